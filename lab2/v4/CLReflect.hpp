@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// 成员指针 M T::* 的成员类型
+template <typename P>
+struct CLMemberType;
+
+template <typename T, typename M>
+struct CLMemberType<M T::*> {
+    typedef M type;
+};
+
+// 编译期字段描述：类型 T 提供 static constexpr auto Fields()，按序列化顺序返回成员指针的 tuple，例如
+//     static constexpr auto Fields() { return std::make_tuple(&B::i, &B::j); }
+// 由此在编译期生成定长编码器：字段依次紧密排列（与手写的 os.write 逐字段写入格式相同），
+// 每个字段一次定长 memcpy，相邻字段的拷贝在 -O2 下合并为一次整块拷贝；整个对象只调用一次流接口
+template <typename T>
+class CLReflect {
+    typedef decltype(T::Fields()) CFields;
+    static constexpr size_t FIELD_COUNT = std::tuple_size<CFields>::value;
+
+    template <size_t... I>
+    static constexpr size_t SumSizes(std::index_sequence<I...>) {
+        return (size_t(0) + ... + sizeof(typename CLMemberType<std::tuple_element_t<I, CFields>>::type));
+    }
+
+    template <size_t... I>
+    static constexpr bool AllTrivial(std::index_sequence<I...>) {
+        return (true && ... && std::is_trivially_copyable<typename CLMemberType<std::tuple_element_t<I, CFields>>::type>::value);
+    }
+
+public:
+    // 一个对象编码后的字节数
+    static constexpr size_t WIRE_SIZE = SumSizes(std::make_index_sequence<FIELD_COUNT>());
+
+    static_assert(AllTrivial(std::make_index_sequence<FIELD_COUNT>()), "reflected fields must be trivially copyable");
+
+    // 编码到 p 开始的 WIRE_SIZE 字节
+    static void Encode(const T &obj, char *p) {
+        std::apply([&obj, &p](auto... pMember) { ((memcpy(p, &(obj.*pMember), sizeof(obj.*pMember)), p += sizeof(obj.*pMember)), ...); },
+                   T::Fields());
+    }
+
+    // 从 p 开始的 WIRE_SIZE 字节解码
+    static void Decode(T &obj, const char *p) {
+        std::apply([&obj, &p](auto... pMember) { ((memcpy(&(obj.*pMember), p, sizeof(obj.*pMember)), p += sizeof(obj.*pMember)), ...); },
+                   T::Fields());
+    }
+
+    static bool Write(const T &obj, std::ostream &os) {
+        char buf[WIRE_SIZE];
+        Encode(obj, buf);
+        os.write(buf, WIRE_SIZE);
+        return os.good();
+    }
+
+    static bool Read(T &obj, std::istream &is) {
+        char buf[WIRE_SIZE];
+        if (!is.read(buf, WIRE_SIZE)) {
+            return false;
+        }
+        Decode(obj, buf);
+        return true;
+    }
+};
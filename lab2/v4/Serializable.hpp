@@ -1,4 +1,5 @@
 #pragma once
+#include "CLReflect.hpp"
 #include <iostream>
 #include <memory> // for std::unique_ptr
 
@@ -21,29 +22,44 @@ public:
     virtual void f() const = 0;
 };
 
-// ================= Class A =================
-class A : public ILSerializable {
+// 编译期反射适配器（CRTP）：Derived 只需提供默认构造函数与 Fields() 字段描述，
+// ILSerializable 的各个虚函数由 CLReflect<Derived> 生成的定长编解码器实现
+// 手写 Serialize/Deserialize 的类型仍直接继承 ILSerializable，两者可以混存在同一个归档中
+template <typename Derived, int TypeID>
+class CLReflectSerializable : public ILSerializable {
 public:
-    A() : i(0) {}
-    explicit A(int val) : i(val) {}
-
-    void f() const override {
-        std::cout << "[Class A] i = " << i << std::endl;
-    }
+    static const int TYPE = TypeID;
 
     int GetType() const override {
-        return 0; // Type ID for A
+        return TypeID;
     }
 
     bool Serialize(std::ostream &os) const override {
-        os.write(reinterpret_cast<const char *>(&i), sizeof(i));
-        return os.good();
+        return CLReflect<Derived>::Write(static_cast<const Derived &>(*this), os);
     }
 
     std::unique_ptr<ILSerializable> Deserialize(std::istream &is) override {
-        auto p = std::make_unique<A>();                        // 创建新对象
-        is.read(reinterpret_cast<char *>(&(p->i)), sizeof(i)); // 填充数据
-        return p;                                              // 返回基类指针
+        auto p = std::make_unique<Derived>();
+        if (!CLReflect<Derived>::Read(*p, is)) {
+            return nullptr;
+        }
+        return p;
+    }
+};
+
+// ================= Class A =================
+class A : public CLReflectSerializable<A, 0> {
+public:
+    A() : i(0) {}
+    explicit A(int val) : i(val) {}
+
+    void f() const override {
+        std::cout << "[Class A] i = " << i << std::endl;
+    }
+
+    // 字段描述：序列化/反序列化代码由 CLReflect<A> 在编译期生成
+    static constexpr auto Fields() {
+        return std::make_tuple(&A::i);
     }
 
 private:
@@ -51,7 +67,7 @@ private:
 };
 
 // ================= Class B =================
-class B : public ILSerializable {
+class B : public CLReflectSerializable<B, 1> {
 public:
     B() : i(0), j(0) {}
     B(int val) : i(val), j(val + 1) {}
@@ -60,21 +76,8 @@ public:
         std::cout << "[Class B] i = " << i << ", j = " << j << std::endl;
     }
 
-    int GetType() const override {
-        return 1; // Type ID for B
-    }
-
-    bool Serialize(std::ostream &os) const override {
-        os.write(reinterpret_cast<const char *>(&i), sizeof(i));
-        os.write(reinterpret_cast<const char *>(&j), sizeof(j));
-        return os.good();
-    }
-
-    std::unique_ptr<ILSerializable> Deserialize(std::istream &is) override {
-        auto p = std::make_unique<B>();
-        is.read(reinterpret_cast<char *>(&(p->i)), sizeof(i));
-        is.read(reinterpret_cast<char *>(&(p->j)), sizeof(j));
-        return p;
+    static constexpr auto Fields() {
+        return std::make_tuple(&B::i, &B::j);
     }
 
 private:
@@ -82,7 +85,7 @@ private:
 };
 
 // ================= Class C  =================
-class C : public ILSerializable {
+class C : public CLReflectSerializable<C, 2> {
 public:
     C() : d(0.0) {}
     explicit C(double val) : d(val) {}
@@ -91,19 +94,8 @@ public:
         std::cout << "[Class C] d = " << d << std::endl;
     }
 
-    int GetType() const override {
-        return 2; // Type ID for C
-    }
-
-    bool Serialize(std::ostream &os) const override {
-        os.write(reinterpret_cast<const char *>(&d), sizeof(d));
-        return os.good();
-    }
-
-    std::unique_ptr<ILSerializable> Deserialize(std::istream &is) override {
-        auto p = std::make_unique<C>();
-        is.read(reinterpret_cast<char *>(&(p->d)), sizeof(d));
-        return p;
+    static constexpr auto Fields() {
+        return std::make_tuple(&C::d);
     }
 
 private:
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 单调（monotonic）内存区：对象依次放置构造在连续的内存块中，
+// 不支持单独释放，Reset() 一次性析构全部对象并回收内存以供下一批复用
+class CLArena {
+public:
+    explicit CLArena(size_t nFirstChunkSize = 64 * 1024) : m_nNextChunkSize(nFirstChunkSize), m_nCurrent(0), m_pCursor(nullptr), m_pLimit(nullptr), m_nBytesUsed(0) {
+        if (m_nNextChunkSize < 256) {
+            m_nNextChunkSize = 256;
+        }
+    }
+
+    ~CLArena() {
+        Reset();
+        for (auto &chunk : m_chunks) {
+            std::free(chunk.pData);
+        }
+    }
+
+    CLArena(const CLArena &) = delete;
+    CLArena &operator=(const CLArena &) = delete;
+
+    // 分配 nSize 字节，按 nAlign 对齐
+    void *Allocate(size_t nSize, size_t nAlign = alignof(std::max_align_t)) {
+        char *p = AlignUp(m_pCursor, nAlign);
+        if (m_pCursor == nullptr || p + nSize > m_pLimit) {
+            NextChunk(nSize + nAlign);
+            p = AlignUp(m_pCursor, nAlign);
+        }
+        m_pCursor = p + nSize;
+        m_nBytesUsed += nSize;
+        return p;
+    }
+
+    // 在内存区中放置构造对象；有非平凡析构函数的对象登记析构函数，Reset 时调用
+    template <typename T, typename... Args>
+    T *Create(Args &&...args) {
+        void *p = Allocate(sizeof(T), alignof(T));
+        T *pObj = new (p) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            m_dtors.push_back(CDtor{pObj, &Destroy<T>});
+        }
+        return pObj;
+    }
+
+    // 接管一个堆对象的所有权，Reset 时 delete（供不支持放置构造的类型兜底）
+    template <typename T>
+    T *Adopt(T *pObj) {
+        if (pObj) {
+            m_dtors.push_back(CDtor{pObj, &Delete<T>});
+        }
+        return pObj;
+    }
+
+    // 按构造的逆序析构所有对象，保留已申请的内存块以便复用
+    void Reset() {
+        for (auto it = m_dtors.rbegin(); it != m_dtors.rend(); ++it) {
+            it->pfnDestroy(it->pObj);
+        }
+        m_dtors.clear();
+        m_nCurrent = 0;
+        m_nBytesUsed = 0;
+        if (!m_chunks.empty()) {
+            m_pCursor = m_chunks[0].pData;
+            m_pLimit = m_chunks[0].pData + m_chunks[0].nSize;
+        }
+    }
+
+    size_t GetBytesUsed() const {
+        return m_nBytesUsed;
+    }
+
+    size_t GetChunkCount() const {
+        return m_chunks.size();
+    }
+
+private:
+    struct CChunk {
+        char *pData;
+        size_t nSize;
+    };
+
+    struct CDtor {
+        void *pObj;
+        void (*pfnDestroy)(void *);
+    };
+
+    template <typename T>
+    static void Destroy(void *p) {
+        static_cast<T *>(p)->~T();
+    }
+
+    template <typename T>
+    static void Delete(void *p) {
+        delete static_cast<T *>(p);
+    }
+
+    static char *AlignUp(char *p, size_t nAlign) {
+        uintptr_t n = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char *>((n + nAlign - 1) & ~(uintptr_t)(nAlign - 1));
+    }
+
+    // 切换到下一个至少 nMin 字节的内存块：优先复用 Reset 前申请过的块，否则申请新块（大小翻倍）
+    void NextChunk(size_t nMin) {
+        size_t nNext = m_pCursor == nullptr ? 0 : m_nCurrent + 1;
+        while (nNext < m_chunks.size() && m_chunks[nNext].nSize < nMin) {
+            nNext++;
+        }
+        if (nNext >= m_chunks.size()) {
+            size_t nSize = m_nNextChunkSize;
+            while (nSize < nMin) {
+                nSize *= 2;
+            }
+            CChunk chunk;
+            chunk.pData = static_cast<char *>(std::malloc(nSize));
+            if (chunk.pData == nullptr) {
+                throw std::bad_alloc();
+            }
+            chunk.nSize = nSize;
+            m_chunks.push_back(chunk);
+            nNext = m_chunks.size() - 1;
+            // 块大小翻倍增长，超过 16MB 后不再增大
+            m_nNextChunkSize = nSize < (16u << 20) ? nSize * 2 : nSize;
+        }
+        m_nCurrent = nNext;
+        m_pCursor = m_chunks[nNext].pData;
+        m_pLimit = m_chunks[nNext].pData + m_chunks[nNext].nSize;
+    }
+
+private:
+    std::vector<CChunk> m_chunks;
+    std::vector<CDtor> m_dtors; // 与对象分开存放，使对象在内存中保持紧凑
+    size_t m_nNextChunkSize;
+    size_t m_nCurrent;
+    char *m_pCursor;
+    char *m_pLimit;
+    size_t m_nBytesUsed;
+};
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "CLSerializer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 异步归档写入器：生产者把对象放入无锁的有界环形队列后立即返回，后台编码线程取出对象，
+// 通过内部的 CLSerializer（开启双缓冲写出）编码并写入文件，生产者不等待编码与磁盘 I/O
+// 队列支持多个生产者、一个消费者（MPSC），每个槽带序号（Vyukov 有界队列），入队只有一次 CAS
+// 归档格式与 CLSerializer::Serialize 相同；多个生产者之间的记录顺序取决于入队的先后
+class CLAsyncSerializer {
+public:
+    // nCapacity 向上取整为 2 的幂
+    explicit CLAsyncSerializer(size_t nCapacity = 64 * 1024)
+        : m_nEnqueuePos(0), m_nDequeuePos(0), m_nPeakDepth(0), m_nSleepers(0), m_bClosing(false), m_bOpen(false), m_bOk(true) {
+        m_nCapacity = 2;
+        while (m_nCapacity < nCapacity) {
+            m_nCapacity *= 2;
+        }
+        m_pSlots.reset(new CSlot[m_nCapacity]);
+        for (size_t i = 0; i < m_nCapacity; i++) {
+            m_pSlots[i].nSeq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~CLAsyncSerializer() {
+        Close();
+    }
+
+    CLAsyncSerializer(const CLAsyncSerializer &) = delete;
+    CLAsyncSerializer &operator=(const CLAsyncSerializer &) = delete;
+
+    // 内部的序列化器：在 Open 之前设置归档标志、块编解码器、落盘策略等
+    CLSerializer &GetSerializer() {
+        return m_serializer;
+    }
+
+    // 打开文件并启动编码线程
+    bool Open(const std::string &filePath) {
+        if (m_bOpen) {
+            return false;
+        }
+        m_serializer.SetWriteBehind(true);
+        if (!m_serializer.Begin(filePath)) {
+            return false;
+        }
+        m_bOk = true;
+        m_bClosing.store(false, std::memory_order_relaxed);
+        m_nPeakDepth.store(0, std::memory_order_relaxed);
+        m_bOpen = true;
+        m_thread = std::thread(&CLAsyncSerializer::Run, this);
+        return true;
+    }
+
+    // 非阻塞入队：成功时接管对象（pObj 置空），队列已满时返回 false，pObj 保持不变
+    bool TryPush(std::unique_ptr<ILSerializable> &pObj) {
+        if (!Enqueue(pObj.get(), nullptr)) {
+            return false;
+        }
+        pObj.release();
+        return true;
+    }
+
+    // 入队，队列已满时让出 CPU 直到编码线程腾出空位（背压）
+    void Push(std::unique_ptr<ILSerializable> pObj) {
+        ILSerializable *p = pObj.release();
+        while (!Enqueue(p, nullptr)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // 在此之前入队的对象全部写入文件后兑现，值为此前的编码与写出是否都成功
+    // 只保证写入内核页缓存；落盘由 CLSerializer::SetFsyncPolicy 在 Close 时处理
+    std::future<bool> Flush() {
+        std::promise<bool> *pFlush = new std::promise<bool>();
+        std::future<bool> future = pFlush->get_future();
+        if (!m_bOpen) {
+            pFlush->set_value(false);
+            delete pFlush;
+            return future;
+        }
+        while (!Enqueue(nullptr, pFlush)) {
+            std::this_thread::yield();
+        }
+        return future;
+    }
+
+    // 队列中尚未被编码线程取走的条目数（近似值，供监控）
+    size_t GetQueueDepth() const {
+        size_t nEnqueue = m_nEnqueuePos.load(std::memory_order_relaxed);
+        size_t nDequeue = m_nDequeuePos.load(std::memory_order_relaxed);
+        return nEnqueue > nDequeue ? nEnqueue - nDequeue : 0;
+    }
+
+    // Open 以来编码线程观察到的最大队列深度
+    size_t GetPeakQueueDepth() const {
+        return m_nPeakDepth.load(std::memory_order_relaxed);
+    }
+
+    size_t GetCapacity() const {
+        return m_nCapacity;
+    }
+
+    // 编码完队列中剩余的对象，写出并关闭文件；调用前所有生产者必须已停止入队
+    bool Close() {
+        if (!m_bOpen) {
+            return false;
+        }
+        m_bClosing.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cond.notify_one();
+        }
+        m_thread.join();
+        m_bOpen = false;
+        return m_serializer.End() && m_bOk;
+    }
+
+private:
+    // 一个队列槽：nSeq == 位置 表示空闲可写，nSeq == 位置 + 1 表示已写入可读
+    struct CSlot {
+        std::atomic<size_t> nSeq;
+        ILSerializable *pObj;
+        std::promise<bool> *pFlush; // 非空时为 Flush 标记
+    };
+
+    bool Enqueue(ILSerializable *pObj, std::promise<bool> *pFlush) {
+        CSlot *pSlot;
+        size_t nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            pSlot = &m_pSlots[nPos & (m_nCapacity - 1)];
+            size_t nSeq = pSlot->nSeq.load(std::memory_order_acquire);
+            intptr_t nDiff = (intptr_t)nSeq - (intptr_t)nPos;
+            if (nDiff == 0) {
+                if (m_nEnqueuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (nDiff < 0) {
+                return false; // 该槽上一轮的数据还没被取走：队列已满
+            } else {
+                nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        pSlot->pObj = pObj;
+        pSlot->pFlush = pFlush;
+        pSlot->nSeq.store(nPos + 1, std::memory_order_release);
+
+        // 编码线程空闲等待时才需要唤醒；极少数情况下错过唤醒，编码线程也会在超时后自行醒来
+        if (m_nSleepers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cond.notify_one();
+        }
+        return true;
+    }
+
+    // 只由编码线程调用
+    bool Dequeue(ILSerializable *&pObj, std::promise<bool> *&pFlush) {
+        size_t nPos = m_nDequeuePos.load(std::memory_order_relaxed);
+        CSlot &slot = m_pSlots[nPos & (m_nCapacity - 1)];
+        if (slot.nSeq.load(std::memory_order_acquire) != nPos + 1) {
+            return false;
+        }
+        pObj = slot.pObj;
+        pFlush = slot.pFlush;
+        slot.nSeq.store(nPos + m_nCapacity, std::memory_order_release);
+        m_nDequeuePos.store(nPos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Run() {
+        while (true) {
+            // 先读关闭标志再取队列：Close 之前入队的条目此时一定可见，取空即可退出
+            bool bClosing = m_bClosing.load(std::memory_order_acquire);
+            ILSerializable *pObj;
+            std::promise<bool> *pFlush;
+            if (Dequeue(pObj, pFlush)) {
+                // 取走的这一条也算在内；生产者可能已经占用了刚腾出的槽，因此不超过容量
+                size_t nDepth = std::min(GetQueueDepth() + 1, m_nCapacity);
+                if (nDepth > m_nPeakDepth.load(std::memory_order_relaxed)) {
+                    m_nPeakDepth.store(nDepth, std::memory_order_relaxed);
+                }
+                if (pFlush) {
+                    pFlush->set_value(m_serializer.Sync() && m_bOk);
+                    delete pFlush;
+                } else {
+                    if (!m_serializer.Append(pObj)) {
+                        m_bOk = false;
+                    }
+                    delete pObj;
+                }
+                continue;
+            }
+            if (bClosing) {
+                return;
+            }
+
+            m_nSleepers.fetch_add(1, std::memory_order_seq_cst);
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait_for(lock, std::chrono::milliseconds(1),
+                                [this]() { return GetQueueDepth() > 0 || m_bClosing.load(std::memory_order_acquire); });
+            }
+            m_nSleepers.fetch_sub(1, std::memory_order_seq_cst);
+        }
+    }
+
+private:
+    std::unique_ptr<CSlot[]> m_pSlots;
+    size_t m_nCapacity;
+    alignas(64) std::atomic<size_t> m_nEnqueuePos; // 生产者竞争的位置与编码线程的位置放在不同缓存行
+    alignas(64) std::atomic<size_t> m_nDequeuePos;
+    std::atomic<size_t> m_nPeakDepth;
+    std::atomic<int> m_nSleepers;
+    std::atomic<bool> m_bClosing;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    CLSerializer m_serializer; // 只由编码线程使用（Open / Close 除外）
+    bool m_bOpen;
+    bool m_bOk; // 编码线程写，Close 在 join 之后读
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "CLBlockCodec.hpp"
+#include "CLCompact.hpp"
+#include "CLFileIO.hpp"
+#include "CLOutputBuffer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 分块压缩归档格式（文件头带 ARCHIVE_FLAG_BLOCKS）：
+//   [文件头: CLArchiveHeader]
+//   [块数据...]               每块是若干条完整记录（编码方式由其余标志决定）独立压缩的结果，记录不跨块
+//   [块索引: CLBlockEntry * N]
+//   [文件尾: 块索引偏移, 块数 N, magic]
+// 块之间没有依赖：紧凑编码的浮点异或状态在每块开头清零，因此可以并行解压、直接定位到任意一块
+struct CLBlockEntry {
+    uint64_t nOffset;         // 块数据在文件中的偏移
+    uint32_t nCompressedSize; // 压缩后的字节数
+    uint32_t nRawSize;        // 解压后的字节数
+    uint32_t nRecordCount;    // 块内记录数
+    uint32_t nCodecId;        // 该块使用的编解码器
+};
+
+struct CLBlockTrailer {
+    uint64_t nIndexOffset;
+    uint32_t nBlockCount;
+    uint32_t nMagic;
+};
+
+// 在 nThreads 个线程上运行 func（当前线程算作其中一个），全部结束后返回
+// func 自行从共享的原子计数器领取任务，线程数只影响并行度
+template <typename Func>
+void RunParallel(unsigned nThreads, Func func) {
+    std::vector<std::thread> vThreads;
+    for (unsigned i = 1; i < nThreads; i++) {
+        vThreads.emplace_back(func);
+    }
+    func();
+    for (auto &t : vThreads) {
+        t.join();
+    }
+}
+
+// 分块写入器：原始记录块压缩后追加到输出缓冲区，由调用方择机写出
+class CLBlockWriter {
+public:
+    CLBlockWriter() : m_pCodec(nullptr), m_nOffset(0) {}
+
+    CLBlockWriter(const CLBlockWriter &) = delete;
+    CLBlockWriter &operator=(const CLBlockWriter &) = delete;
+
+    // 开始一个新归档：写出文件头
+    void Begin(uint32_t nFlags, ILBlockCodec *pCodec) {
+        m_pCodec = pCodec;
+        m_vIndex.clear();
+        m_buf.Clear();
+        m_nOffset = 0;
+        CLArchiveHeader header = {ARCHIVE_MAGIC, nFlags | ARCHIVE_FLAG_BLOCKS};
+        Append(&header, sizeof(header));
+    }
+
+    // 压缩一块；压缩后不比原数据小时原样存放
+    void AddBlock(const char *pData, size_t nSize, size_t nRecords) {
+        CLBlockEntry entry = {m_nOffset, 0, (uint32_t)nSize, (uint32_t)nRecords, BLOCK_CODEC_STORE};
+        char *pDst = m_buf.Tail(m_pCodec->MaxCompressedSize(nSize));
+        size_t nCompressed = m_pCodec->Compress(pData, nSize, pDst);
+        if (nCompressed < nSize) {
+            entry.nCodecId = m_pCodec->GetId();
+        } else {
+            memcpy(pDst, pData, nSize);
+            nCompressed = nSize;
+        }
+        m_buf.Advance(nCompressed);
+        m_nOffset += nCompressed;
+        entry.nCompressedSize = (uint32_t)nCompressed;
+        m_vIndex.push_back(entry);
+    }
+
+    // 追加块索引与文件尾
+    void End() {
+        CLBlockTrailer trailer = {m_nOffset, (uint32_t)m_vIndex.size(), ARCHIVE_MAGIC};
+        Append(m_vIndex.data(), m_vIndex.size() * sizeof(CLBlockEntry));
+        Append(&trailer, sizeof(trailer));
+    }
+
+    // 待写出的数据；写出后由调用方 Clear()，偏移仍按整个文件累计
+    CLOutputBuffer &Buffer() {
+        return m_buf;
+    }
+
+private:
+    void Append(const void *p, size_t nSize) {
+        m_buf.Append(p, nSize);
+        m_nOffset += nSize;
+    }
+
+private:
+    ILBlockCodec *m_pCodec;
+    CLOutputBuffer m_buf;
+    std::vector<CLBlockEntry> m_vIndex;
+    uint64_t m_nOffset; // 下一个字节在文件中的偏移
+};
+
+// 分块压缩归档读取器：映射文件、校验块索引，按块解压
+class CLBlockArchive {
+public:
+    // pCodecs 为空时使用自带的编解码器表（只有内置编解码器），否则使用调用方的表（如 CLSerializer 注册过自定义编解码器的表）
+    explicit CLBlockArchive(const CLCodecTable *pCodecs = nullptr) : m_pBase(NULL), m_nSize(0), m_nFlags(0), m_pCodecs(pCodecs ? pCodecs : &m_codecs) {}
+
+    ~CLBlockArchive() {
+        Close();
+    }
+
+    CLBlockArchive(const CLBlockArchive &) = delete;
+    CLBlockArchive &operator=(const CLBlockArchive &) = delete;
+
+    // 映射文件并校验文件头、文件尾与块索引
+    bool Open(const std::string &filePath) {
+        Close();
+        if (!MapFile(filePath, sizeof(CLArchiveHeader) + sizeof(CLBlockTrailer), m_pBase, m_nSize)) {
+            return false;
+        }
+        if (!ParseIndex()) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+        UnmapFile(m_pBase, m_nSize);
+        m_nFlags = 0;
+        m_vIndex.clear();
+        m_vFirstRecord.clear();
+    }
+
+    // 文件头中的标志，决定块内记录的编码方式
+    uint32_t GetFlags() const {
+        return m_nFlags;
+    }
+
+    size_t GetBlockCount() const {
+        return m_vIndex.size();
+    }
+
+    const CLBlockEntry &GetBlock(size_t nBlock) const {
+        return m_vIndex[nBlock];
+    }
+
+    size_t GetRecordCount() const {
+        return m_vFirstRecord.empty() ? 0 : (size_t)m_vFirstRecord.back();
+    }
+
+    // 第 nBlock 块第一条记录的序号
+    size_t GetFirstRecord(size_t nBlock) const {
+        return (size_t)m_vFirstRecord[nBlock];
+    }
+
+    // 第 nRecord 条记录所在的块，二分查找；越界时返回 GetBlockCount()
+    size_t FindBlock(size_t nRecord) const {
+        if (nRecord >= GetRecordCount()) {
+            return m_vIndex.size();
+        }
+        auto it = std::upper_bound(m_vFirstRecord.begin(), m_vFirstRecord.end(), (uint64_t)nRecord);
+        return (size_t)(it - m_vFirstRecord.begin()) - 1;
+    }
+
+    // 解压一块到 v：v.size() 为 nRawSize + COMPACT_PADDING，末尾补零，紧凑编码的块可直接交给 CLCompactReader
+    bool DecompressBlock(size_t nBlock, std::vector<char> &v) const {
+        const CLBlockEntry &entry = m_vIndex[nBlock];
+        ILBlockCodec *pCodec = m_pCodecs->Find(entry.nCodecId);
+        if (!pCodec) {
+            return false;
+        }
+        v.assign(entry.nRawSize + COMPACT_PADDING, 0);
+        return pCodec->Decompress(m_pBase + entry.nOffset, entry.nCompressedSize, v.data(), entry.nRawSize);
+    }
+
+    // 用 nThreads 个线程（0 表示 CPU 核数）并行解压从 nFirst 开始的 nCount 块，vBlocks[k] 为第 nFirst + k 块
+    // vBlocks 可在多次调用之间复用，已有的容量不会释放
+    bool Decompress(size_t nFirst, size_t nCount, std::vector<std::vector<char>> &vBlocks, unsigned nThreads = 0) const {
+        if (nFirst > m_vIndex.size() || nCount > m_vIndex.size() - nFirst) {
+            return false;
+        }
+        if (vBlocks.size() < nCount) {
+            vBlocks.resize(nCount);
+        }
+        std::atomic<size_t> nNext(0);
+        std::atomic<bool> bOk(true);
+        auto worker = [this, nFirst, nCount, &vBlocks, &nNext, &bOk]() {
+            for (size_t k = nNext++; k < nCount; k = nNext++) {
+                if (!DecompressBlock(nFirst + k, vBlocks[k])) {
+                    bOk = false;
+                }
+            }
+        };
+
+        RunParallel((unsigned)std::min<size_t>(nThreads ? nThreads : DefaultThreads(), nCount), worker);
+        return bOk;
+    }
+
+    bool DecompressAll(std::vector<std::vector<char>> &vBlocks, unsigned nThreads = 0) const {
+        vBlocks.resize(m_vIndex.size());
+        return Decompress(0, m_vIndex.size(), vBlocks, nThreads);
+    }
+
+    static unsigned DefaultThreads() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+private:
+    bool ParseIndex() {
+        CLArchiveHeader header;
+        memcpy(&header, m_pBase, sizeof(header));
+        CLBlockTrailer trailer;
+        memcpy(&trailer, m_pBase + m_nSize - sizeof(trailer), sizeof(trailer));
+        if (header.nMagic != ARCHIVE_MAGIC || !(header.nFlags & ARCHIVE_FLAG_BLOCKS) || (header.nFlags & ~ARCHIVE_KNOWN_FLAGS) ||
+            trailer.nMagic != ARCHIVE_MAGIC) {
+            return false;
+        }
+        m_nFlags = header.nFlags;
+
+        uint64_t nIndexSize = (uint64_t)trailer.nBlockCount * sizeof(CLBlockEntry);
+        if (trailer.nIndexOffset < sizeof(header) || trailer.nIndexOffset > m_nSize ||
+            nIndexSize != m_nSize - sizeof(trailer) - trailer.nIndexOffset) {
+            return false;
+        }
+        m_vIndex.resize(trailer.nBlockCount);
+        memcpy(m_vIndex.data(), m_pBase + trailer.nIndexOffset, nIndexSize);
+
+        // 每块都必须落在块数据区内；原始长度不超过压缩数据能解出的上限，
+        // 每条记录编码后至少占 1 字节，因此记录数不超过原始长度，调用方可以按记录数预先分配
+        m_vFirstRecord.assign(1, 0);
+        for (const auto &entry : m_vIndex) {
+            if (entry.nOffset < sizeof(header) || entry.nOffset > trailer.nIndexOffset ||
+                entry.nCompressedSize > trailer.nIndexOffset - entry.nOffset || entry.nRecordCount > entry.nRawSize) {
+                return false;
+            }
+            const ILBlockCodec *pCodec = m_pCodecs->Find(entry.nCodecId);
+            if (pCodec && entry.nRawSize > pCodec->MaxDecompressedSize(entry.nCompressedSize)) {
+                return false;
+            }
+            m_vFirstRecord.push_back(m_vFirstRecord.back() + entry.nRecordCount);
+        }
+        return true;
+    }
+
+private:
+    const char *m_pBase;
+    size_t m_nSize;
+    uint32_t m_nFlags;
+    std::vector<CLBlockEntry> m_vIndex;
+    std::vector<uint64_t> m_vFirstRecord; // 各块首条记录的序号，末尾多一个元素为总记录数
+    CLCodecTable m_codecs;
+    const CLCodecTable *m_pCodecs;
+};
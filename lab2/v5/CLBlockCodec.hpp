@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 块压缩编解码器接口：每个块独立压缩，解码不依赖其他块，因此可以并行解压、按块随机访问
+// Decompress 必须是无状态的（可被多个线程同时调用）；Compress 只在写入线程中调用
+class ILBlockCodec {
+public:
+    virtual ~ILBlockCodec() = default;
+
+    // 写入块索引的编解码器 ID，读取时据此查找编解码器
+    virtual uint32_t GetId() const = 0;
+
+    // nSize 字节输入压缩后的最大字节数
+    virtual size_t MaxCompressedSize(size_t nSize) const = 0;
+
+    // nSize 字节压缩数据解压后的最大字节数，读取时据此校验块索引中的原始长度；无法给出上限时返回 SIZE_MAX
+    virtual size_t MaxDecompressedSize(size_t /*nSize*/) const {
+        return SIZE_MAX;
+    }
+
+    // 压缩到 pDst（容量至少为 MaxCompressedSize(nSize)），返回压缩后的字节数
+    virtual size_t Compress(const char *pSrc, size_t nSize, char *pDst) = 0;
+
+    // 解压到 pDst，结果必须恰好为 nRawSize 字节，否则返回 false（输入损坏）
+    virtual bool Decompress(const char *pSrc, size_t nSize, char *pDst, size_t nRawSize) const = 0;
+};
+
+#define BLOCK_CODEC_STORE 0u // 不压缩，原样存放；压缩后不比原数据小的块也使用它
+#define BLOCK_CODEC_LZ 1u    // 内置的 LZ77 编解码器
+
+class CLStoreCodec : public ILBlockCodec {
+public:
+    uint32_t GetId() const override {
+        return BLOCK_CODEC_STORE;
+    }
+
+    size_t MaxCompressedSize(size_t nSize) const override {
+        return nSize;
+    }
+
+    size_t MaxDecompressedSize(size_t nSize) const override {
+        return nSize;
+    }
+
+    size_t Compress(const char *pSrc, size_t nSize, char *pDst) override {
+        memcpy(pDst, pSrc, nSize);
+        return nSize;
+    }
+
+    bool Decompress(const char *pSrc, size_t nSize, char *pDst, size_t nRawSize) const override {
+        if (nSize != nRawSize) {
+            return false;
+        }
+        memcpy(pDst, pSrc, nSize);
+        return true;
+    }
+};
+
+// 内置的字节级 LZ77 编解码器，序列格式与 LZ4 块格式相同：
+//   [标记字节: 高 4 位字面量长度, 低 4 位匹配长度 - 4][长度扩展字节...][字面量][2 字节偏移][匹配长度扩展字节...]
+// 长度字段为 15 时后跟扩展字节，每个 255 表示继续；最后一个序列只有字面量
+// 压缩端用 4 字节哈希表做贪心匹配，连续未命中时加大步长快速跳过不可压缩的数据
+class CLLzCodec : public ILBlockCodec {
+public:
+    CLLzCodec() : m_vHash(HASH_SIZE) {}
+
+    uint32_t GetId() const override {
+        return BLOCK_CODEC_LZ;
+    }
+
+    size_t MaxCompressedSize(size_t nSize) const override {
+        return nSize + nSize / 255 + 16;
+    }
+
+    // 每个长度扩展字节最多使匹配增长 255 字节，字面量为 1:1，解压后不超过输入的 255 倍
+    size_t MaxDecompressedSize(size_t nSize) const override {
+        return nSize > SIZE_MAX / 255 ? SIZE_MAX : nSize * 255;
+    }
+
+    size_t Compress(const char *pSrc, size_t nSize, char *pDst) override {
+        const uint8_t *pIn = reinterpret_cast<const uint8_t *>(pSrc);
+        uint8_t *pOut = reinterpret_cast<uint8_t *>(pDst);
+        const uint8_t *pAnchor = pIn; // 尚未输出的字面量起点
+        const uint8_t *const pEnd = pIn + nSize;
+
+        if (nSize >= MIN_INPUT) {
+            // 最后 LAST_LITERALS 字节总是作为字面量，匹配起点不超过 pMatchLimit
+            const uint8_t *const pMatchLimit = pEnd - LAST_LITERALS;
+            const uint8_t *const pSearchLimit = pEnd - MIN_INPUT;
+            std::fill(m_vHash.begin(), m_vHash.end(), 0);
+            uint32_t *pHash = m_vHash.data();
+            const uint8_t *p = pIn + 1;
+            uint32_t nMisses = 1 << SKIP_SHIFT;
+
+            while (p < pSearchLimit) {
+                uint32_t nHash = Hash(Load32(p));
+                const uint8_t *pRef = pIn + pHash[nHash];
+                pHash[nHash] = (uint32_t)(p - pIn);
+                if (pRef >= p || p - pRef > MAX_OFFSET || Load32(pRef) != Load32(p)) {
+                    p += nMisses++ >> SKIP_SHIFT;
+                    continue;
+                }
+                nMisses = 1 << SKIP_SHIFT;
+
+                // 向前扩展匹配
+                while (p > pAnchor && pRef > pIn && p[-1] == pRef[-1]) {
+                    p--;
+                    pRef--;
+                }
+                const uint8_t *q = MatchEnd(p + MIN_MATCH, pRef + MIN_MATCH, pMatchLimit);
+                pOut = PutSequence(pOut, pAnchor, (size_t)(p - pAnchor), (uint32_t)(p - pRef), (size_t)(q - p));
+                // 匹配区间内间隔填入哈希表，提高后续命中率
+                if (q - 2 > p) {
+                    pHash[Hash(Load32(q - 2))] = (uint32_t)(q - 2 - pIn);
+                }
+                p = pAnchor = q;
+            }
+        }
+
+        // 最后一段字面量
+        size_t nLiterals = (size_t)(pEnd - pAnchor);
+        pOut = PutLiteralLength(pOut, nLiterals);
+        memcpy(pOut, pAnchor, nLiterals);
+        pOut += nLiterals;
+        return (size_t)(pOut - reinterpret_cast<uint8_t *>(pDst));
+    }
+
+    bool Decompress(const char *pSrc, size_t nSize, char *pDst, size_t nRawSize) const override {
+        const uint8_t *pIn = reinterpret_cast<const uint8_t *>(pSrc);
+        const uint8_t *const pInEnd = pIn + nSize;
+        uint8_t *pOut = reinterpret_cast<uint8_t *>(pDst);
+        uint8_t *const pOutBegin = pOut;
+        uint8_t *const pOutEnd = pOut + nRawSize;
+
+        while (pIn < pInEnd) {
+            uint32_t nToken = *pIn++;
+            size_t nLiterals = nToken >> 4;
+            if (nLiterals == 15 && !GetLength(pIn, pInEnd, nLiterals)) {
+                return false;
+            }
+            if (nLiterals > (size_t)(pInEnd - pIn) || nLiterals > (size_t)(pOutEnd - pOut)) {
+                return false;
+            }
+            memcpy(pOut, pIn, nLiterals);
+            pIn += nLiterals;
+            pOut += nLiterals;
+            if (pIn == pInEnd) {
+                break; // 最后一个序列没有匹配部分
+            }
+
+            if (pInEnd - pIn < 2) {
+                return false;
+            }
+            size_t nOffset = (size_t)pIn[0] | ((size_t)pIn[1] << 8);
+            pIn += 2;
+            size_t nMatch = nToken & 15;
+            if (nMatch == 15 && !GetLength(pIn, pInEnd, nMatch)) {
+                return false;
+            }
+            nMatch += MIN_MATCH;
+            if (nOffset == 0 || nOffset > (size_t)(pOut - pOutBegin) || nMatch > (size_t)(pOutEnd - pOut)) {
+                return false;
+            }
+
+            const uint8_t *pRef = pOut - nOffset;
+            if (nOffset >= nMatch) {
+                memcpy(pOut, pRef, nMatch);
+            } else {
+                // 重叠复制（如连续重复的字节），必须逐字节向前传播
+                for (size_t i = 0; i < nMatch; i++) {
+                    pOut[i] = pRef[i];
+                }
+            }
+            pOut += nMatch;
+        }
+        return pOut == pOutEnd;
+    }
+
+private:
+    enum {
+        HASH_BITS = 14,
+        HASH_SIZE = 1 << HASH_BITS,
+        MIN_MATCH = 4,
+        MAX_OFFSET = 65535,
+        LAST_LITERALS = 5,
+        MIN_INPUT = 13,
+        SKIP_SHIFT = 6
+    };
+
+    static uint32_t Load32(const uint8_t *p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    static uint64_t Load64(const uint8_t *p) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        return v;
+    }
+
+    // 向后扩展匹配，先按 8 字节整字比较，返回匹配结束位置（不超过 pLimit）
+    static const uint8_t *MatchEnd(const uint8_t *q, const uint8_t *r, const uint8_t *pLimit) {
+        while (q + 8 <= pLimit) {
+            uint64_t nDiff = Load64(q) ^ Load64(r);
+            if (nDiff) {
+                return q + (__builtin_ctzll(nDiff) >> 3);
+            }
+            q += 8;
+            r += 8;
+        }
+        while (q < pLimit && *q == *r) {
+            q++;
+            r++;
+        }
+        return q;
+    }
+
+    static uint32_t Hash(uint32_t v) {
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // 写出标记字节（字面量长度放在高 4 位）及放不下的长度扩展字节
+    static uint8_t *PutLiteralLength(uint8_t *pOut, size_t nLength) {
+        if (nLength < 15) {
+            *pOut++ = (uint8_t)(nLength << 4);
+            return pOut;
+        }
+        *pOut++ = (uint8_t)(15 << 4);
+        return PutExtra(pOut, nLength - 15);
+    }
+
+    static uint8_t *PutExtra(uint8_t *pOut, size_t nRemain) {
+        while (nRemain >= 255) {
+            *pOut++ = 255;
+            nRemain -= 255;
+        }
+        *pOut++ = (uint8_t)nRemain;
+        return pOut;
+    }
+
+    static uint8_t *PutSequence(uint8_t *pOut, const uint8_t *pLiterals, size_t nLiterals, uint32_t nOffset, size_t nMatch) {
+        uint8_t *pToken = pOut;
+        pOut = PutLiteralLength(pOut, nLiterals);
+        memcpy(pOut, pLiterals, nLiterals);
+        pOut += nLiterals;
+        *pOut++ = (uint8_t)nOffset;
+        *pOut++ = (uint8_t)(nOffset >> 8);
+        nMatch -= MIN_MATCH;
+        if (nMatch < 15) {
+            *pToken |= (uint8_t)nMatch;
+        } else {
+            *pToken |= 15;
+            pOut = PutExtra(pOut, nMatch - 15);
+        }
+        return pOut;
+    }
+
+    static bool GetLength(const uint8_t *&pIn, const uint8_t *pInEnd, size_t &nLength) {
+        uint32_t b;
+        do {
+            if (pIn == pInEnd) {
+                return false;
+            }
+            b = *pIn++;
+            nLength += b;
+        } while (b == 255);
+        return true;
+    }
+
+private:
+    std::vector<uint32_t> m_vHash; // 位置哈希表，每个块压缩前清零
+};
+
+// 编解码器表：内置 STORE 与 LZ，可再注册自定义编解码器（ID 不能与已有的重复）
+class CLCodecTable {
+public:
+    CLCodecTable() {
+        m_vCodecs.push_back(&m_store);
+        m_vCodecs.push_back(&m_lz);
+    }
+
+    CLCodecTable(const CLCodecTable &) = delete;
+    CLCodecTable &operator=(const CLCodecTable &) = delete;
+
+    bool Register(ILBlockCodec *pCodec) {
+        if (!pCodec || Find(pCodec->GetId())) {
+            return false;
+        }
+        m_vCodecs.push_back(pCodec);
+        return true;
+    }
+
+    ILBlockCodec *Find(uint32_t nId) const {
+        for (auto *pCodec : m_vCodecs) {
+            if (pCodec->GetId() == nId) {
+                return pCodec;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    CLStoreCodec m_store;
+    CLLzCodec m_lz;
+    std::vector<ILBlockCodec *> m_vCodecs; // 编解码器很少，线性查找即可
+};
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "CLFileIO.hpp"
+#include "CLOutputBuffer.hpp"
+#include "Serializable.hpp"
+#include <cstdint>
+#include <fcntl.h>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+// 列式（struct-of-arrays）归档格式：
+//   [文件头: magic, version]
+//   [列数据...]               每列为同一类型同一字段的全部取值，连续存放，起始偏移按 64 字节对齐
+//   [列索引: CLColumnEntry * N]
+//   [文件尾: 列索引偏移, 列数 N, magic]
+// 对象按类型 ID 分组，同一类型内保持写入顺序；不同类型之间的原始交错顺序不保存
+#define COLUMNAR_MAGIC 0x4c4f4343u // "CCOL"
+#define COLUMNAR_VERSION 1u
+#define COLUMNAR_ALIGN 64
+
+struct CLColumnarHeader {
+    uint32_t nMagic;
+    uint32_t nVersion;
+};
+
+struct CLColumnEntry {
+    int32_t nType;      // 类型 ID
+    uint32_t nField;    // 字段序号（View::FIELD_xxx）
+    uint64_t nElemSize; // 每个取值的字节数
+    uint64_t nCount;    // 取值个数，即该类型的对象数
+    uint64_t nOffset;   // 列数据在文件中的偏移
+};
+
+struct CLColumnarTrailer {
+    uint64_t nIndexOffset;
+    uint32_t nColumnCount;
+    uint32_t nMagic;
+};
+
+// 列式归档写入器：对象经 Serialize(CLOutputBuffer&) 编码后按字段布局拆分到各列
+class CLColumnarWriter {
+public:
+    CLColumnarWriter() {}
+
+    CLColumnarWriter(const CLColumnarWriter &) = delete;
+    CLColumnarWriter &operator=(const CLColumnarWriter &) = delete;
+
+    // 注册一种记录：字段布局取自视图类型的 FIELD_SIZES
+    template <typename View>
+    void Register() {
+        if (View::TYPE < 0) {
+            return;
+        }
+        if ((size_t)View::TYPE >= m_vTypes.size()) {
+            m_vTypes.resize(View::TYPE + 1);
+        }
+        CTypeColumns &type = m_vTypes[View::TYPE];
+        type.bRegistered = true;
+        type.nWireSize = View::WIRE_SIZE;
+        type.vFieldSizes.assign(std::begin(View::FIELD_SIZES), std::end(View::FIELD_SIZES));
+    }
+
+    // 写入对象列表；遇到未注册类型或编码长度与字段布局不符时返回 false
+    bool Write(const std::string &filePath, const std::vector<ILSerializable *> &v) {
+        for (auto &type : m_vTypes) {
+            type.nCount = 0;
+            for (auto &pColumn : type.vColumns) {
+                pColumn->Clear();
+            }
+        }
+
+        for (const auto *ptr : v) {
+            if (!ptr) {
+                continue;
+            }
+            int nType = ptr->GetType();
+            if (nType < 0 || (size_t)nType >= m_vTypes.size() || !m_vTypes[nType].bRegistered) {
+                std::cerr << "Warning: Unknown type ID " << nType << " encountered." << std::endl;
+                return false;
+            }
+
+            CTypeColumns &type = m_vTypes[nType];
+            m_scratch.Clear();
+            if (!ptr->Serialize(m_scratch) || m_scratch.Size() != type.nWireSize) {
+                return false;
+            }
+            if (type.vColumns.size() != type.vFieldSizes.size()) {
+                type.vColumns.clear();
+                for (size_t i = 0; i < type.vFieldSizes.size(); i++) {
+                    type.vColumns.emplace_back(new CLOutputBuffer());
+                }
+            }
+
+            // 按字段布局把一条记录拆到各列末尾
+            const char *p = m_scratch.Data();
+            for (size_t i = 0; i < type.vFieldSizes.size(); i++) {
+                type.vColumns[i]->Append(p, type.vFieldSizes[i]);
+                p += type.vFieldSizes[i];
+            }
+            type.nCount++;
+        }
+
+        return WriteFile(filePath);
+    }
+
+private:
+    struct CTypeColumns {
+        bool bRegistered = false;
+        size_t nWireSize = 0;
+        size_t nCount = 0;
+        std::vector<size_t> vFieldSizes;
+        std::vector<std::unique_ptr<CLOutputBuffer>> vColumns; // 每个字段一列，跨调用复用
+    };
+
+    bool WriteFile(const std::string &filePath) {
+        int fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            return false;
+        }
+
+        CLColumnarHeader header = {COLUMNAR_MAGIC, COLUMNAR_VERSION};
+        uint64_t nOffset = 0;
+        bool bOk = WriteAll(fd, &header, sizeof(header), nOffset);
+
+        std::vector<CLColumnEntry> vIndex;
+        for (size_t nType = 0; bOk && nType < m_vTypes.size(); nType++) {
+            const CTypeColumns &type = m_vTypes[nType];
+            if (!type.bRegistered || type.nCount == 0) {
+                continue;
+            }
+            for (size_t i = 0; bOk && i < type.vColumns.size(); i++) {
+                bOk = Pad(fd, nOffset);
+                CLColumnEntry entry;
+                entry.nType = (int32_t)nType;
+                entry.nField = (uint32_t)i;
+                entry.nElemSize = type.vFieldSizes[i];
+                entry.nCount = type.nCount;
+                entry.nOffset = nOffset;
+                vIndex.push_back(entry);
+                bOk = bOk && WriteAll(fd, type.vColumns[i]->Data(), type.vColumns[i]->Size(), nOffset);
+            }
+        }
+
+        CLColumnarTrailer trailer;
+        trailer.nIndexOffset = nOffset;
+        trailer.nColumnCount = (uint32_t)vIndex.size();
+        trailer.nMagic = COLUMNAR_MAGIC;
+        bOk = bOk && WriteAll(fd, vIndex.data(), vIndex.size() * sizeof(CLColumnEntry), nOffset);
+        bOk = bOk && WriteAll(fd, &trailer, sizeof(trailer), nOffset);
+
+        if (::close(fd) == -1) {
+            bOk = false;
+        }
+        return bOk;
+    }
+
+    // 补零到 COLUMNAR_ALIGN 的整数倍，使映射后每列的起始地址按缓存行对齐
+    static bool Pad(int fd, uint64_t &nOffset) {
+        static const char zeros[COLUMNAR_ALIGN] = {0};
+        size_t nPad = (size_t)((COLUMNAR_ALIGN - nOffset % COLUMNAR_ALIGN) % COLUMNAR_ALIGN);
+        return WriteAll(fd, zeros, nPad, nOffset);
+    }
+
+    // 写出并累计文件偏移（列索引记录每列的起始偏移）
+    static bool WriteAll(int fd, const void *pData, size_t nSize, uint64_t &nOffset) {
+        if (!WriteFully(fd, static_cast<const char *>(pData), nSize)) {
+            return false;
+        }
+        nOffset += nSize;
+        return true;
+    }
+
+private:
+    std::vector<CTypeColumns> m_vTypes; // 按类型 ID 直接索引
+    CLOutputBuffer m_scratch;           // 单条记录的编码缓冲区
+};
+
+// 列式归档读取器：mmap 整个文件，按 (类型 ID, 字段序号) 直接定位到一列
+class CLColumnarArchive {
+public:
+    // 一列数据：指向映射内存，在 Close() 之前有效
+    struct CColumn {
+        const char *pData;
+        size_t nElemSize;
+        size_t nCount;
+    };
+
+public:
+    CLColumnarArchive() : m_pBase(NULL), m_nSize(0) {}
+
+    ~CLColumnarArchive() {
+        Close();
+    }
+
+    CLColumnarArchive(const CLColumnarArchive &) = delete;
+    CLColumnarArchive &operator=(const CLColumnarArchive &) = delete;
+
+    // 映射文件并校验文件头、文件尾与列索引
+    bool Open(const std::string &filePath) {
+        Close();
+        if (!MapFile(filePath, sizeof(CLColumnarHeader) + sizeof(CLColumnarTrailer), m_pBase, m_nSize)) {
+            return false;
+        }
+        if (!ParseIndex()) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+        UnmapFile(m_pBase, m_nSize);
+        m_vIndex.clear();
+    }
+
+    // 某一类型的对象数，类型不存在时为 0
+    size_t GetRecordCount(int nType) const {
+        for (const auto &entry : m_vIndex) {
+            if (entry.nType == nType) {
+                return (size_t)entry.nCount;
+            }
+        }
+        return 0;
+    }
+
+    // 取一列；不存在时 pData 为 NULL
+    CColumn GetColumn(int nType, size_t nField) const {
+        CColumn column = {NULL, 0, 0};
+        for (const auto &entry : m_vIndex) {
+            if (entry.nType == nType && entry.nField == nField) {
+                column.pData = m_pBase + entry.nOffset;
+                column.nElemSize = (size_t)entry.nElemSize;
+                column.nCount = (size_t)entry.nCount;
+                break;
+            }
+        }
+        return column;
+    }
+
+    // 整列载入到 v：一次 memcpy；T 的大小必须与列元素大小一致
+    template <typename T>
+    bool LoadColumn(int nType, size_t nField, std::vector<T> &v) const {
+        static_assert(std::is_trivially_copyable<T>::value, "column element must be trivially copyable");
+        CColumn column = GetColumn(nType, nField);
+        if (column.pData == NULL || column.nElemSize != sizeof(T)) {
+            return false;
+        }
+        v.resize(column.nCount);
+        memcpy(v.data(), column.pData, column.nCount * sizeof(T));
+        return true;
+    }
+
+private:
+    bool ParseIndex() {
+        CLColumnarHeader header;
+        memcpy(&header, m_pBase, sizeof(header));
+        CLColumnarTrailer trailer;
+        memcpy(&trailer, m_pBase + m_nSize - sizeof(trailer), sizeof(trailer));
+        if (header.nMagic != COLUMNAR_MAGIC || header.nVersion != COLUMNAR_VERSION || trailer.nMagic != COLUMNAR_MAGIC) {
+            return false;
+        }
+
+        uint64_t nIndexSize = (uint64_t)trailer.nColumnCount * sizeof(CLColumnEntry);
+        if (trailer.nIndexOffset > m_nSize || nIndexSize != m_nSize - sizeof(trailer) - trailer.nIndexOffset) {
+            return false;
+        }
+        m_vIndex.resize(trailer.nColumnCount);
+        memcpy(m_vIndex.data(), m_pBase + trailer.nIndexOffset, nIndexSize);
+
+        // 每列都必须落在列数据区内
+        for (const auto &entry : m_vIndex) {
+            if (entry.nElemSize == 0 || entry.nOffset > trailer.nIndexOffset ||
+                entry.nCount > (trailer.nIndexOffset - entry.nOffset) / entry.nElemSize) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    const char *m_pBase;
+    size_t m_nSize;
+    std::vector<CLColumnEntry> m_vIndex; // 列数很少，线性查找即可
+};
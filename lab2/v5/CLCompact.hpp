@@ -0,0 +1,292 @@
+#pragma once
+
+#include "CLOutputBuffer.hpp"
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// ================= 归档头 =================
+// 旧格式没有文件头，直接从第一条记录的类型 ID 开始；新格式以 ARCHIVE_MAGIC 开头，后跟 32 位标志
+// 读取时按前 4 字节区分，旧归档不受影响（前提是不存在类型 ID 恰好等于 ARCHIVE_MAGIC 的类型）
+#define ARCHIVE_MAGIC 0x41534c43u // "CLSA"
+#define ARCHIVE_FLAG_COMPACT 0x1u   // 记录使用 varint/zigzag 紧凑编码
+#define ARCHIVE_FLAG_FLOAT_XOR 0x2u // 浮点字段与同类型上一条记录的同一字段异或后压缩（需同时设置 COMPACT）
+#define ARCHIVE_FLAG_BLOCKS 0x4u    // 记录分块独立压缩，文件末尾带块索引（见 CLBlockArchive.hpp）
+#define ARCHIVE_KNOWN_FLAGS (ARCHIVE_FLAG_COMPACT | ARCHIVE_FLAG_FLOAT_XOR | ARCHIVE_FLAG_BLOCKS)
+
+// 紧凑编码的输入缓冲区末尾需要补齐的字节数：解码时按 8 字节整字读取，64 位 varint 最多再多读 10 字节
+#define COMPACT_PADDING 16
+
+struct CLArchiveHeader {
+    uint32_t nMagic;
+    uint32_t nFlags;
+};
+
+// 浮点异或压缩的状态：每个 (类型 ID, 浮点字段) 保存上一条记录的取值
+class CLFloatState {
+public:
+    // 某一类型的 nFields 个状态槽，首次访问时清零
+    uint64_t *Slots(int nType, size_t nFields) {
+        std::vector<uint64_t> *pSlots;
+        if (nType >= 0 && nType < 4096) {
+            if ((size_t)nType >= m_vDense.size()) {
+                m_vDense.resize(nType + 1);
+            }
+            pSlots = &m_vDense[nType];
+        } else {
+            pSlots = &m_sparse[nType];
+        }
+        if (pSlots->size() < nFields) {
+            pSlots->resize(nFields, 0);
+        }
+        return pSlots->data();
+    }
+
+    void Reset() {
+        m_vDense.clear();
+        m_sparse.clear();
+    }
+
+private:
+    std::vector<std::vector<uint64_t>> m_vDense;
+    std::unordered_map<int, std::vector<uint64_t>> m_sparse;
+};
+
+// 紧凑编码写入器：追加到 CLOutputBuffer
+// 变长整数先整字写入 8 字节再按实际长度前进，没有逐字节循环
+class CLCompactWriter {
+public:
+    explicit CLCompactWriter(CLOutputBuffer &buf) : m_buf(buf), m_scratch(256), m_bFloatXor(false) {}
+
+    CLCompactWriter(const CLCompactWriter &) = delete;
+    CLCompactWriter &operator=(const CLCompactWriter &) = delete;
+
+    // 开始一个新归档：清空浮点状态
+    void Reset(bool bFloatXor) {
+        m_bFloatXor = bFloatXor;
+        m_floatState.Reset();
+    }
+
+    void PutVarint32(uint32_t v) {
+        // 7 位一组分散到 5 个字节，除最后一个字节外置续位
+        uint64_t w = (v & 0x7f) | ((uint64_t)(v & 0x3f80) << 1) | ((uint64_t)(v & 0x1fc000) << 2) |
+                     ((uint64_t)(v & 0xfe00000) << 3) | ((uint64_t)(v & 0xf0000000) << 4);
+        uint32_t nLen = (32 - __builtin_clz(v | 1) + 6) / 7;
+        w |= 0x0000008080808080ULL & ((1ULL << (8 * (nLen - 1))) - 1);
+        memcpy(m_buf.Tail(8), &w, 8);
+        m_buf.Advance(nLen);
+    }
+
+    void PutVarint64(uint64_t v) {
+        char *p = m_buf.Tail(10);
+        size_t n = 0;
+        while (v >= 0x80) {
+            p[n++] = (char)(v | 0x80);
+            v >>= 7;
+        }
+        p[n++] = (char)v;
+        m_buf.Advance(n);
+    }
+
+    void PutSigned32(int32_t v) {
+        PutVarint32(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+    }
+
+    void PutSigned64(int64_t v) {
+        PutVarint64(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+    }
+
+    // 浮点：与上一个值异或，只写出中间非零的字节；控制字节高 4 位为字节数，低 4 位为末尾零字节数
+    // 相邻取值相近时符号、指数与尾数高位相同，尾数低位常为零，通常只需 1~4 字节
+    void PutDouble(double d, uint64_t &nPrev) {
+        uint64_t nBits;
+        memcpy(&nBits, &d, 8);
+        if (!m_bFloatXor) {
+            m_buf.Put(nBits);
+            return;
+        }
+        PutXor(nBits ^ nPrev);
+        nPrev = nBits;
+    }
+
+    void PutFloat(float f, uint64_t &nPrev) {
+        uint32_t nBits;
+        memcpy(&nBits, &f, 4);
+        if (!m_bFloatXor) {
+            m_buf.Put(nBits);
+            return;
+        }
+        PutXor(nBits ^ nPrev);
+        nPrev = nBits;
+    }
+
+    void PutRaw(const void *p, size_t nSize) {
+        m_buf.Append(p, nSize);
+    }
+
+    uint64_t *FloatSlots(int nType, size_t nFields) {
+        return m_floatState.Slots(nType, nFields);
+    }
+
+    // 供未提供紧凑编码的类型暂存其原始编码
+    CLOutputBuffer &Scratch() {
+        return m_scratch;
+    }
+
+private:
+    void PutXor(uint64_t x) {
+        uint32_t nLeading = x ? (uint32_t)__builtin_clzll(x) >> 3 : 8;
+        uint32_t nTrailing = x ? (uint32_t)__builtin_ctzll(x) >> 3 : 0;
+        uint32_t nBytes = 8 - nLeading - nTrailing;
+        char *p = m_buf.Tail(9);
+        p[0] = (char)((nBytes << 4) | nTrailing);
+        uint64_t w = x >> (8 * nTrailing);
+        memcpy(p + 1, &w, 8);
+        m_buf.Advance(1 + nBytes);
+    }
+
+private:
+    CLOutputBuffer &m_buf;
+    CLOutputBuffer m_scratch;
+    CLFloatState m_floatState;
+    bool m_bFloatXor;
+};
+
+// 紧凑编码读取器：[pData, pData + nSize) 之后必须还有 COMPACT_PADDING 字节可读
+// 每次读取只检查一次当前位置是否已越过末尾（可预测的分支），之后按整字读取；
+// 单个字段最多前进 10 字节，因此越界读取不会超出补齐区。格式错误只记录标志，由调用方每条记录检查一次 HasError()
+class CLCompactReader {
+public:
+    CLCompactReader(const char *pData, size_t nSize, bool bFloatXor) : m_p(pData), m_pEnd(pData + nSize), m_bFloatXor(bFloatXor), m_bError(false) {}
+
+    uint32_t GetVarint32() {
+        if (Overrun()) {
+            return 0;
+        }
+        uint64_t w;
+        memcpy(&w, m_p, 8);
+        uint64_t nStop = ~w & 0x0000008080808080ULL;
+        if (nStop == 0) {
+            m_bError = true; // 超过 5 字节
+            return 0;
+        }
+        uint32_t nLen = ((uint32_t)__builtin_ctzll(nStop) >> 3) + 1;
+        w &= ~0ULL >> (64 - 8 * nLen);
+        uint64_t v = (w & 0x7f) | ((w >> 1) & 0x3f80) | ((w >> 2) & 0x1fc000) | ((w >> 3) & 0xfe00000) | ((w >> 4) & 0x7f0000000ULL);
+        m_bError |= (v >> 32) != 0;
+        m_p += nLen;
+        return (uint32_t)v;
+    }
+
+    uint64_t GetVarint64() {
+        if (Overrun()) {
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int nShift = 0; nShift < 70; nShift += 7) {
+            uint8_t b = (uint8_t)*m_p++;
+            v |= (uint64_t)(b & 0x7f) << nShift;
+            if (!(b & 0x80)) {
+                return v;
+            }
+        }
+        m_bError = true;
+        return 0;
+    }
+
+    int32_t GetSigned32() {
+        uint32_t v = GetVarint32();
+        return (int32_t)((v >> 1) ^ (0u - (v & 1)));
+    }
+
+    int64_t GetSigned64() {
+        uint64_t v = GetVarint64();
+        return (int64_t)((v >> 1) ^ (0ULL - (v & 1)));
+    }
+
+    double GetDouble(uint64_t &nPrev) {
+        uint64_t nBits = 0;
+        if (!Overrun()) {
+            if (m_bFloatXor) {
+                nBits = nPrev ^ GetXor();
+                nPrev = nBits;
+            } else {
+                memcpy(&nBits, m_p, 8);
+                m_p += 8;
+            }
+        }
+        double d;
+        memcpy(&d, &nBits, 8);
+        return d;
+    }
+
+    float GetFloat(uint64_t &nPrev) {
+        uint32_t nBits = 0;
+        if (!Overrun()) {
+            if (m_bFloatXor) {
+                nBits = (uint32_t)(nPrev ^ GetXor());
+                nPrev = nBits;
+            } else {
+                memcpy(&nBits, m_p, 4);
+                m_p += 4;
+            }
+        }
+        float f;
+        memcpy(&f, &nBits, 4);
+        return f;
+    }
+
+    // 返回 nSize 字节原始数据的起始地址，越界时返回 NULL
+    const char *GetRaw(size_t nSize) {
+        if (m_p > m_pEnd || nSize > (size_t)(m_pEnd - m_p)) {
+            m_bError = true;
+            return NULL;
+        }
+        const char *p = m_p;
+        m_p += nSize;
+        return p;
+    }
+
+    uint64_t *FloatSlots(int nType, size_t nFields) {
+        return m_floatState.Slots(nType, nFields);
+    }
+
+    bool HasError() const {
+        return m_bError || m_p > m_pEnd;
+    }
+
+    bool AtEnd() const {
+        return m_p >= m_pEnd;
+    }
+
+private:
+    bool Overrun() {
+        if (m_p > m_pEnd) {
+            m_bError = true;
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t GetXor() {
+        uint32_t nControl = (uint8_t)*m_p;
+        uint32_t nBytes = nControl >> 4;
+        uint32_t nTrailing = nControl & 0xf;
+        m_bError |= nBytes + nTrailing > 8;
+        nBytes = nBytes > 8 ? 8 : nBytes; // 非法值已记录错误，这里只需保证移位量合法
+        nTrailing &= 7;
+        uint64_t w;
+        memcpy(&w, m_p + 1, 8);
+        uint64_t nMask = nBytes ? ~0ULL >> (64 - 8 * nBytes) : 0;
+        m_p += 1 + nBytes;
+        return (w & nMask) << (8 * nTrailing);
+    }
+
+private:
+    const char *m_p;
+    const char *m_pEnd;
+    bool m_bFloatXor;
+    bool m_bError;
+    CLFloatState m_floatState;
+};
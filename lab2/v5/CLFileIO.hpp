@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 归档读写共用的文件操作：整块写出与只读映射
+
+// 把 [p, p + nSize) 全部写到 fd；write 只在被信号打断或部分写入时才会再次调用
+inline bool WriteFully(int fd, const char *p, size_t nSize) {
+    while (nSize > 0) {
+        ssize_t n = ::write(fd, p, nSize);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        nSize -= (size_t)n;
+    }
+    return true;
+}
+
+// 只读映射整个文件，结果写入 pBase / nSize；映射建立后即关闭文件描述符
+// 文件小于 nMinSize 字节或映射失败时返回 false；nMinSize 为 0 时空文件也成功（pBase 为 NULL、nSize 为 0）
+// nAdvice 为传给 madvise 的访问模式（如顺序遍历用 MADV_SEQUENTIAL 加大预读）
+inline bool MapFile(const std::string &filePath, size_t nMinSize, const char *&pBase, size_t &nSize, int nAdvice = MADV_NORMAL) {
+    pBase = NULL;
+    nSize = 0;
+    int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1 || (size_t)st.st_size < nMinSize) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void *p = ::mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    if (nAdvice != MADV_NORMAL) {
+        ::madvise(p, (size_t)st.st_size, nAdvice);
+    }
+    pBase = static_cast<const char *>(p);
+    nSize = (size_t)st.st_size;
+    return true;
+}
+
+// 解除 MapFile 建立的映射并清空 pBase / nSize，未映射时什么也不做
+inline void UnmapFile(const char *&pBase, size_t &nSize) {
+    if (pBase != NULL) {
+        ::munmap(const_cast<char *>(pBase), nSize);
+        pBase = NULL;
+    }
+    nSize = 0;
+}
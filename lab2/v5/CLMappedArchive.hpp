@@ -0,0 +1,274 @@
+#pragma once
+
+#include "CLFileIO.hpp"
+#include "CLMemoryStreamBuf.hpp"
+#include "Serializable.hpp"
+#include <iterator>
+#include <string>
+#include <vector>
+
+// 基于 mmap 的 CLSerializer 归档读取器
+// 归档格式与 CLSerializer::Serialize 默认输出相同：[int 类型 ID][对象负载]...，不支持带文件头的归档
+// 直接在映射内存上遍历记录，按类型返回零拷贝视图；需要完整对象时再按需反序列化
+class CLMappedArchive {
+public:
+    CLMappedArchive() : m_pBase(NULL), m_nSize(0), m_bError(false) {}
+
+    ~CLMappedArchive() {
+        Close();
+    }
+
+    CLMappedArchive(const CLMappedArchive &) = delete;
+    CLMappedArchive &operator=(const CLMappedArchive &) = delete;
+
+    // 映射归档文件
+    bool Open(const std::string &filePath) {
+        Close();
+        // 顺序遍历：提示内核加大预读
+        if (!MapFile(filePath, 0, m_pBase, m_nSize, MADV_SEQUENTIAL)) {
+            return false;
+        }
+        m_bError = false;
+
+        // 带文件头的归档（如紧凑编码）记录不是定长布局，不能零拷贝访问，交给 CLSerializer 读取
+        uint32_t nMagic = 0;
+        if (m_nSize >= sizeof(nMagic)) {
+            memcpy(&nMagic, m_pBase, sizeof(nMagic));
+        }
+        if (nMagic == ARCHIVE_MAGIC) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+        UnmapFile(m_pBase, m_nSize);
+    }
+
+    // 注册一种记录：视图类型给出类型 ID 与定长负载大小，原型用于按需反序列化（可为空）
+    template <typename View>
+    void Register(ILSerializable *pPrototype = nullptr) {
+        if (View::TYPE < 0) {
+            return;
+        }
+        if ((size_t)View::TYPE >= m_vRecordInfo.size()) {
+            m_vRecordInfo.resize(View::TYPE + 1);
+        }
+        m_vRecordInfo[View::TYPE].bRegistered = true;
+        m_vRecordInfo[View::TYPE].nWireSize = View::WIRE_SIZE;
+        m_vRecordInfo[View::TYPE].pPrototype = pPrototype;
+    }
+
+    // 遍历中是否遇到未注册的类型或截断的记录
+    bool HasError() const {
+        return m_bError;
+    }
+
+public:
+    // 一条记录：类型 ID 与指向映射内存中负载的指针
+    class CRecord {
+    public:
+        CRecord() : m_nType(-1), m_pData(NULL), m_nSize(0), m_pPrototype(NULL) {}
+
+        int GetType() const {
+            return m_nType;
+        }
+
+        const char *Data() const {
+            return m_pData;
+        }
+
+        size_t Size() const {
+            return m_nSize;
+        }
+
+        template <typename View>
+        bool Is() const {
+            return m_nType == View::TYPE;
+        }
+
+        // 以指定视图访问字段，调用方需先确认类型
+        template <typename View>
+        View As() const {
+            return View(m_pData);
+        }
+
+        // 按需构造完整对象：原型的 Deserialize 直接读取映射内存
+        std::unique_ptr<ILSerializable> Materialize() const {
+            CLMemoryStreamBuf buf(m_pData, m_nSize);
+            std::istream is(&buf);
+            return Materialize(buf, is);
+        }
+
+        // 复用调用方的流对象，避免逐条构造 istream（构造开销远大于读取几个字段）
+        std::unique_ptr<ILSerializable> Materialize(CLMemoryStreamBuf &buf, std::istream &is) const {
+            if (m_pPrototype == NULL) {
+                return nullptr;
+            }
+            buf.Reset(m_pData, m_nSize);
+            is.clear();
+            return m_pPrototype->Deserialize(is);
+        }
+
+        // 按需构造到 arena 中，对象生命周期由 arena 管理
+        ILSerializable *Materialize(CLMemoryStreamBuf &buf, std::istream &is, CLArena &arena) const {
+            if (m_pPrototype == NULL) {
+                return NULL;
+            }
+            buf.Reset(m_pData, m_nSize);
+            is.clear();
+            return m_pPrototype->DeserializeInto(is, arena);
+        }
+
+    private:
+        friend class CLMappedArchive;
+        int m_nType;
+        const char *m_pData;
+        size_t m_nSize;
+        ILSerializable *m_pPrototype;
+    };
+
+    // 前向迭代器，遇到未注册类型或截断记录时置错误标志并结束
+    class CIterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef CRecord value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const CRecord *pointer;
+        typedef const CRecord &reference;
+
+        CIterator() : m_pArchive(NULL), m_nOffset(0) {}
+
+        CIterator(CLMappedArchive *pArchive, size_t nOffset) : m_pArchive(pArchive), m_nOffset(nOffset) {
+            Parse();
+        }
+
+        const CRecord &operator*() const {
+            return m_record;
+        }
+
+        const CRecord *operator->() const {
+            return &m_record;
+        }
+
+        CIterator &operator++() {
+            m_nOffset += sizeof(int) + m_record.m_nSize;
+            Parse();
+            return *this;
+        }
+
+        bool operator==(const CIterator &other) const {
+            return m_nOffset == other.m_nOffset;
+        }
+
+        bool operator!=(const CIterator &other) const {
+            return m_nOffset != other.m_nOffset;
+        }
+
+    private:
+        // 解析当前偏移处的记录头；无法解析时跳到末尾
+        void Parse() {
+            if (m_pArchive == NULL || m_nOffset >= m_pArchive->m_nSize) {
+                m_nOffset = m_pArchive ? m_pArchive->m_nSize : 0;
+                return;
+            }
+
+            const size_t nRemain = m_pArchive->m_nSize - m_nOffset;
+            int nType = -1;
+            if (nRemain >= sizeof(int)) {
+                memcpy(&nType, m_pArchive->m_pBase + m_nOffset, sizeof(int));
+            }
+
+            const CRecordInfo *pInfo = m_pArchive->Lookup(nType);
+            if (nRemain < sizeof(int) || pInfo == NULL || nRemain - sizeof(int) < pInfo->nWireSize) {
+                if (pInfo == NULL && nRemain >= sizeof(int)) {
+                    std::cerr << "Warning: Unknown type ID " << nType << " encountered." << std::endl;
+                }
+                m_pArchive->m_bError = true;
+                m_nOffset = m_pArchive->m_nSize;
+                return;
+            }
+
+            m_record.m_nType = nType;
+            m_record.m_pData = m_pArchive->m_pBase + m_nOffset + sizeof(int);
+            m_record.m_nSize = pInfo->nWireSize;
+            m_record.m_pPrototype = pInfo->pPrototype;
+        }
+
+        CLMappedArchive *m_pArchive;
+        size_t m_nOffset;
+        CRecord m_record;
+    };
+
+    CIterator begin() {
+        m_bError = false;
+        return CIterator(this, 0);
+    }
+
+    CIterator end() {
+        return CIterator(this, m_nSize);
+    }
+
+    // 只访问某一类型的记录，返回访问的记录数
+    template <typename View, typename Func>
+    size_t ForEach(Func func) {
+        size_t nCount = 0;
+        for (const CRecord &rec : *this) {
+            if (rec.Is<View>()) {
+                func(rec.As<View>());
+                nCount++;
+            }
+        }
+        return nCount;
+    }
+
+    // 全部物化，结果与 CLSerializer::Deserialize 相同
+    bool MaterializeAll(std::vector<std::unique_ptr<ILSerializable>> &v) {
+        CLMemoryStreamBuf buf(m_pBase, 0);
+        std::istream is(&buf);
+        for (const CRecord &rec : *this) {
+            auto obj = rec.Materialize(buf, is);
+            if (!obj) {
+                return false;
+            }
+            v.push_back(std::move(obj));
+        }
+        return !m_bError;
+    }
+
+    // 全部物化到 arena，v 中的指针在 arena.Reset() 之前有效
+    bool MaterializeAll(std::vector<ILSerializable *> &v, CLArena &arena) {
+        CLMemoryStreamBuf buf(m_pBase, 0);
+        std::istream is(&buf);
+        for (const CRecord &rec : *this) {
+            ILSerializable *obj = rec.Materialize(buf, is, arena);
+            if (!obj) {
+                return false;
+            }
+            v.push_back(obj);
+        }
+        return !m_bError;
+    }
+
+private:
+    struct CRecordInfo {
+        bool bRegistered = false;
+        size_t nWireSize = 0;
+        ILSerializable *pPrototype = nullptr;
+    };
+
+    // 类型 ID 为小整数，按 ID 直接索引
+    const CRecordInfo *Lookup(int nType) const {
+        if (nType < 0 || (size_t)nType >= m_vRecordInfo.size() || !m_vRecordInfo[nType].bRegistered) {
+            return NULL;
+        }
+        return &m_vRecordInfo[nType];
+    }
+
+private:
+    const char *m_pBase;
+    size_t m_nSize;
+    bool m_bError;
+    std::vector<CRecordInfo> m_vRecordInfo;
+};
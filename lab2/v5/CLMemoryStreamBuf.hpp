@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+
+// 只读内存流缓冲区：让 istream 直接读取映射区域中的数据，不拷贝
+class CLMemoryStreamBuf : public std::streambuf {
+public:
+    CLMemoryStreamBuf(const char *pData, size_t nSize) {
+        Reset(pData, nSize);
+    }
+
+    // 指向新的内存区域，便于批量物化时复用同一个 istream
+    void Reset(const char *pData, size_t nSize) {
+        char *p = const_cast<char *>(pData); // streambuf 接口要求非 const，get 区域只读不写
+        setg(p, p, p + nSize);
+    }
+};
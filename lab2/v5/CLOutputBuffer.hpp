@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <utility>
+
+class CLOutputBuffer;
+
+// 追加写入 CLOutputBuffer 的流缓冲区：供只实现了 ostream 版本 Serialize 的类型兜底
+class CLOutputStreamBuf : public std::streambuf {
+public:
+    explicit CLOutputStreamBuf(CLOutputBuffer &buf) : m_buf(buf) {}
+
+protected:
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int_type overflow(int_type c) override;
+
+private:
+    CLOutputBuffer &m_buf;
+};
+
+// 可增长的连续输出缓冲区：序列化时先编码到这里，再由调用方一次 write 写出
+// Clear() 只清空内容、保留容量，同一个缓冲区在多次序列化之间复用，稳态下不再 malloc
+class CLOutputBuffer {
+public:
+    explicit CLOutputBuffer(size_t nInitialCapacity = 64 * 1024) : m_pData(nullptr), m_nSize(0), m_nCapacity(0) {
+        Reserve(nInitialCapacity);
+    }
+
+    ~CLOutputBuffer() {
+        std::free(m_pData);
+    }
+
+    CLOutputBuffer(const CLOutputBuffer &) = delete;
+    CLOutputBuffer &operator=(const CLOutputBuffer &) = delete;
+
+    // 追加 nSize 字节；容量足够时只有一次比较和一次 memcpy
+    void Append(const void *p, size_t nSize) {
+        if (m_nSize + nSize > m_nCapacity) {
+            Reserve(m_nSize + nSize);
+        }
+        memcpy(m_pData + m_nSize, p, nSize);
+        m_nSize += nSize;
+    }
+
+    // 追加一个定长字段，长度为编译期常量，memcpy 会被展开为一条 mov
+    template <typename T>
+    void Put(const T &v) {
+        Append(&v, sizeof(T));
+    }
+
+    // 在末尾预留 nSize 字节并返回其起始地址，由调用方直接编码写入
+    char *Extend(size_t nSize) {
+        if (m_nSize + nSize > m_nCapacity) {
+            Reserve(m_nSize + nSize);
+        }
+        char *p = m_pData + m_nSize;
+        m_nSize += nSize;
+        return p;
+    }
+
+    // 保证末尾至少还有 nMax 字节可写并返回其起始地址，但不改变 Size()
+    // 用于先整字写入、再按实际长度 Advance 的变长编码
+    char *Tail(size_t nMax) {
+        if (m_nSize + nMax > m_nCapacity) {
+            Reserve(m_nSize + nMax);
+        }
+        return m_pData + m_nSize;
+    }
+
+    void Advance(size_t nSize) {
+        m_nSize += nSize;
+    }
+
+    // 保证容量至少为 nCapacity，按 2 倍增长
+    void Reserve(size_t nCapacity) {
+        if (nCapacity <= m_nCapacity) {
+            return;
+        }
+        size_t nNew = m_nCapacity ? m_nCapacity : 4096;
+        while (nNew < nCapacity) {
+            nNew *= 2;
+        }
+        char *p = static_cast<char *>(std::realloc(m_pData, nNew));
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        m_pData = p;
+        m_nCapacity = nNew;
+    }
+
+    void Clear() {
+        m_nSize = 0;
+    }
+
+    // 交换两个缓冲区的内容与容量（不交换各自的 Stream()），用于双缓冲：一个写出的同时编码到另一个
+    void Swap(CLOutputBuffer &other) {
+        std::swap(m_pData, other.m_pData);
+        std::swap(m_nSize, other.m_nSize);
+        std::swap(m_nCapacity, other.m_nCapacity);
+    }
+
+    const char *Data() const {
+        return m_pData;
+    }
+
+    size_t Size() const {
+        return m_nSize;
+    }
+
+    size_t Capacity() const {
+        return m_nCapacity;
+    }
+
+    // 写入本缓冲区的 ostream，首次使用时创建，之后复用（构造 ostream 的开销远大于写几个字段）
+    std::ostream &Stream() {
+        if (!m_pStream) {
+            m_pStreamBuf.reset(new CLOutputStreamBuf(*this));
+            m_pStream.reset(new std::ostream(m_pStreamBuf.get()));
+        }
+        m_pStream->clear();
+        return *m_pStream;
+    }
+
+private:
+    char *m_pData;
+    size_t m_nSize;
+    size_t m_nCapacity;
+    std::unique_ptr<CLOutputStreamBuf> m_pStreamBuf;
+    std::unique_ptr<std::ostream> m_pStream;
+};
+
+inline std::streamsize CLOutputStreamBuf::xsputn(const char *s, std::streamsize n) {
+    m_buf.Append(s, (size_t)n);
+    return n;
+}
+
+inline CLOutputStreamBuf::int_type CLOutputStreamBuf::overflow(int_type c) {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        char ch = traits_type::to_char_type(c);
+        m_buf.Append(&ch, 1);
+    }
+    return traits_type::not_eof(c);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "CLCompact.hpp"
+#include "CLOutputBuffer.hpp"
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// 成员指针 M T::* 的成员类型
+template <typename P>
+struct CLMemberType;
+
+template <typename T, typename M>
+struct CLMemberType<M T::*> {
+    typedef M type;
+};
+
+// 编译期字段描述：类型 T 提供 static constexpr auto Fields()，按序列化顺序返回成员指针的 tuple，例如
+//     static constexpr auto Fields() { return std::make_tuple(&B::i, &B::j); }
+// 由此在编译期生成定长编码器：字段依次紧密排列（与手写的 os.write 逐字段写入格式相同），
+// 每个字段一次定长 memcpy，相邻字段的拷贝在 -O2 下合并为一次整块拷贝；整个对象只调用一次流接口
+template <typename T>
+class CLReflect {
+    typedef decltype(T::Fields()) CFields;
+    static constexpr size_t FIELD_COUNT = std::tuple_size<CFields>::value;
+
+    template <size_t... I>
+    static constexpr size_t SumSizes(std::index_sequence<I...>) {
+        return (size_t(0) + ... + sizeof(typename CLMemberType<std::tuple_element_t<I, CFields>>::type));
+    }
+
+    template <typename M>
+    static constexpr bool IsFloatField() {
+        return std::is_same<M, double>::value || std::is_same<M, float>::value;
+    }
+
+    template <size_t... I>
+    static constexpr size_t CountFloats(std::index_sequence<I...>) {
+        return (size_t(0) + ... + (IsFloatField<typename CLMemberType<std::tuple_element_t<I, CFields>>::type>() ? 1 : 0));
+    }
+
+    template <size_t... I>
+    static constexpr bool AllTrivial(std::index_sequence<I...>) {
+        return (true && ... && std::is_trivially_copyable<typename CLMemberType<std::tuple_element_t<I, CFields>>::type>::value);
+    }
+
+public:
+    // 一个对象编码后的字节数
+    static constexpr size_t WIRE_SIZE = SumSizes(std::make_index_sequence<FIELD_COUNT>());
+
+    // 浮点字段数，紧凑编码时每个浮点字段占一个异或状态槽
+    static constexpr size_t FLOAT_FIELD_COUNT = CountFloats(std::make_index_sequence<FIELD_COUNT>());
+
+    static_assert(AllTrivial(std::make_index_sequence<FIELD_COUNT>()), "reflected fields must be trivially copyable");
+
+    // 编码到 p 开始的 WIRE_SIZE 字节
+    static void Encode(const T &obj, char *p) {
+        std::apply([&obj, &p](auto... pMember) { ((memcpy(p, &(obj.*pMember), sizeof(obj.*pMember)), p += sizeof(obj.*pMember)), ...); },
+                   T::Fields());
+    }
+
+    // 从 p 开始的 WIRE_SIZE 字节解码
+    static void Decode(T &obj, const char *p) {
+        std::apply([&obj, &p](auto... pMember) { ((memcpy(&(obj.*pMember), p, sizeof(obj.*pMember)), p += sizeof(obj.*pMember)), ...); },
+                   T::Fields());
+    }
+
+    static bool Write(const T &obj, std::ostream &os) {
+        char buf[WIRE_SIZE];
+        Encode(obj, buf);
+        os.write(buf, WIRE_SIZE);
+        return os.good();
+    }
+
+    static bool Read(T &obj, std::istream &is) {
+        char buf[WIRE_SIZE];
+        if (!is.read(buf, WIRE_SIZE)) {
+            return false;
+        }
+        Decode(obj, buf);
+        return true;
+    }
+
+    static void Append(const T &obj, CLOutputBuffer &buf) {
+        Encode(obj, buf.Extend(WIRE_SIZE));
+    }
+
+    // 批量编码 n 个同类型对象，每条记录前写入类型 ID（与 CLSerializer 的归档格式相同）
+    // 只做一次容量检查，循环体内是定长的 load/store，没有虚函数调用
+    static void AppendRecords(const T *pObjs, size_t n, int nType, CLOutputBuffer &buf) {
+        char *p = buf.Extend(n * (sizeof(int) + WIRE_SIZE));
+        for (size_t i = 0; i < n; i++) {
+            memcpy(p, &nType, sizeof(int));
+            Encode(pObjs[i], p + sizeof(int));
+            p += sizeof(int) + WIRE_SIZE;
+        }
+    }
+
+    // 紧凑编码：按字段类型选择编码方式，全部在编译期展开
+    //   有符号整数 -> zigzag varint，无符号整数 -> varint，浮点 -> 异或压缩（或原样 8/4 字节），其余类型原样拷贝
+    static void WriteCompact(const T &obj, CLCompactWriter &w, int nType) {
+        uint64_t *pSlot = FLOAT_FIELD_COUNT ? w.FloatSlots(nType, FLOAT_FIELD_COUNT) : nullptr;
+        std::apply([&obj, &w, &pSlot](auto... pMember) { (PutField(w, obj.*pMember, pSlot), ...); }, T::Fields());
+    }
+
+    static bool ReadCompact(T &obj, CLCompactReader &r, int nType) {
+        uint64_t *pSlot = FLOAT_FIELD_COUNT ? r.FloatSlots(nType, FLOAT_FIELD_COUNT) : nullptr;
+        std::apply([&obj, &r, &pSlot](auto... pMember) { (GetField(r, obj.*pMember, pSlot), ...); }, T::Fields());
+        return !r.HasError();
+    }
+
+private:
+    template <typename M>
+    static void PutField(CLCompactWriter &w, const M &v, uint64_t *&pSlot) {
+        if constexpr (std::is_integral<M>::value && std::is_signed<M>::value) {
+            if constexpr (sizeof(M) <= 4) {
+                w.PutSigned32((int32_t)v);
+            } else {
+                w.PutSigned64((int64_t)v);
+            }
+        } else if constexpr (std::is_integral<M>::value) {
+            if constexpr (sizeof(M) <= 4) {
+                w.PutVarint32((uint32_t)v);
+            } else {
+                w.PutVarint64((uint64_t)v);
+            }
+        } else if constexpr (std::is_same<M, double>::value) {
+            w.PutDouble(v, *pSlot++);
+        } else if constexpr (std::is_same<M, float>::value) {
+            w.PutFloat(v, *pSlot++);
+        } else {
+            w.PutRaw(&v, sizeof(M));
+        }
+    }
+
+    template <typename M>
+    static void GetField(CLCompactReader &r, M &v, uint64_t *&pSlot) {
+        if constexpr (std::is_integral<M>::value && std::is_signed<M>::value) {
+            if constexpr (sizeof(M) <= 4) {
+                v = (M)r.GetSigned32();
+            } else {
+                v = (M)r.GetSigned64();
+            }
+        } else if constexpr (std::is_integral<M>::value) {
+            if constexpr (sizeof(M) <= 4) {
+                v = (M)r.GetVarint32();
+            } else {
+                v = (M)r.GetVarint64();
+            }
+        } else if constexpr (std::is_same<M, double>::value) {
+            v = r.GetDouble(*pSlot++);
+        } else if constexpr (std::is_same<M, float>::value) {
+            v = r.GetFloat(*pSlot++);
+        } else {
+            const char *p = r.GetRaw(sizeof(M));
+            if (p) {
+                memcpy(&v, p, sizeof(M));
+            }
+        }
+    }
+};
@@ -1,67 +1,460 @@
 #pragma once
 
+#include "CLBlockArchive.hpp"
+#include "CLWriteBehind.hpp"
 #include "Serializable.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
 #include <fstream>
 #include <string>
+#include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
+// 类型 ID 小于该值时使用数组直接索引，否则放入哈希表
+#define DENSE_TYPE_LIMIT 4096
+
+// 数据落盘策略：Serialize 写完后是否同步到存储设备
+enum ELFsyncPolicy {
+    FSYNC_NONE, // 只写入页缓存，由内核择机回写（默认）
+    FSYNC_DATA, // fdatasync：数据落盘，不强制同步无关的元数据
+    FSYNC_FULL  // fsync：数据与元数据都落盘
+};
+
 class CLSerializer {
 public:
+    CLSerializer()
+        : m_compact(m_outBuf), m_eFsyncPolicy(FSYNC_NONE), m_nFlushThreshold(16 * 1024 * 1024), m_nArchiveFlags(0), m_nBlockCodec(BLOCK_CODEC_LZ),
+          m_nBlockSize(256 * 1024), m_bBlocks(false), m_nBlockRecords(0), m_bWriteBehind(false), m_fd(-1), m_bCompact(false), m_bOk(true) {}
+
+    ~CLSerializer() {
+        if (m_fd != -1) {
+            End();
+        }
+    }
+
+    CLSerializer(const CLSerializer &) = delete;
+    CLSerializer &operator=(const CLSerializer &) = delete;
+
     // 序列化：将对象列表写入文件
     // 参数使用 const 引用，避免拷贝
+    // 对象先编码到成员缓冲区 m_outBuf，积累到 m_nFlushThreshold 字节后一次 write 写出，
+    // 每条记录不再经过 ofstream 的两次 write；缓冲区在多次调用之间复用
     bool Serialize(const std::string &filePath, const std::vector<ILSerializable *> &v) {
-        std::ofstream ofs(filePath, std::ios::binary);
-        if (!ofs.is_open()) {
+        if (!Begin(filePath)) {
             return false;
         }
-
         for (const auto *ptr : v) {
-            if (!ptr) {
-                continue;
+            if (!Append(ptr)) {
+                break;
             }
+        }
+        return End();
+    }
+
+    // 增量写入：Begin 打开文件并写出文件头，之后逐条 Append，最后 End 写出剩余数据并关闭文件
+    // Serialize 即 Begin + 逐条 Append + End；同一时刻只能有一个未 End 的增量写入
+    bool Begin(const std::string &filePath) {
+        if (m_fd != -1) {
+            return false;
+        }
+        m_fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (m_fd == -1) {
+            return false;
+        }
+        m_bOk = true;
+        m_outBuf.Clear();
+        m_bCompact = BeginArchive();
+        return true;
+    }
 
-            int type = ptr->GetType();
+    // 编码一条记录，空指针直接跳过；此前已经失败时不再编码，返回 false
+    bool Append(const ILSerializable *ptr) {
+        if (!m_bOk || m_fd == -1) {
+            return false;
+        }
+        if (!ptr) {
+            return true;
+        }
+
+        int type = ptr->GetType();
+        if (m_bCompact) {
+            // 紧凑编码：类型 ID 同样写成 zigzag varint
+            m_compact.PutSigned32(type);
+            m_bOk = ptr->SerializeCompact(m_compact);
+        } else {
             // 1. 写入类型 ID
-            ofs.write(reinterpret_cast<const char *>(&type), sizeof(int));
+            m_outBuf.Put(type);
             // 2. 调用对象自身的序列化方法
-            ptr->Serialize(ofs);
+            m_bOk = ptr->Serialize(m_outBuf);
+        }
+        m_bOk = m_bOk && EndRecord(m_fd);
+        return m_bOk;
+    }
+
+    // 把已编码的记录全部写入文件（分块模式下先结束当前块），返回后文件内容包含此前 Append 的所有记录
+    // 只保证写入内核页缓存，是否落盘由 SetFsyncPolicy 在 End 时决定
+    bool Sync() {
+        if (!m_bOk || m_fd == -1) {
+            return false;
+        }
+        if (m_bBlocks) {
+            m_bOk = EndChunk(m_fd) && WriteAll(m_fd, m_blockWriter.Buffer());
+        } else {
+            m_bOk = Flush(m_fd);
+        }
+        if (m_bWriteBehind) {
+            m_bOk = m_writeBehind.Wait() && m_bOk;
+        }
+        return m_bOk;
+    }
+
+    bool End() {
+        if (m_fd == -1) {
+            return false;
+        }
+        bool bOk = Finish(m_fd, m_bOk);
+        m_fd = -1;
+        return bOk;
+    }
+
+    // 序列化同一类型的对象数组，归档格式与上面相同（包括 SetArchiveFlags 选择的紧凑编码）
+    // T 通过 Fields() 提供编译期字段描述（见 CLReflect），编码器内联展开，不经过虚函数
+    template <typename T>
+    bool SerializeTyped(const std::string &filePath, const std::vector<T> &v) {
+        if (!Begin(filePath)) {
+            return false;
+        }
+
+        if (m_bCompact) {
+            for (size_t i = 0; m_bOk && i < v.size(); i++) {
+                m_compact.PutSigned32(T::TYPE);
+                CLReflect<T>::WriteCompact(v[i], m_compact, T::TYPE);
+                m_bOk = EndRecord(m_fd);
+            }
+            return End();
         }
-        return true; // ofstream 会自动关闭
+
+        const size_t RECORD_SIZE = sizeof(int) + CLReflect<T>::WIRE_SIZE;
+        const size_t nBatch = ChunkLimit() / RECORD_SIZE > 0 ? ChunkLimit() / RECORD_SIZE : 1;
+        for (size_t nStart = 0; m_bOk && nStart < v.size(); nStart += nBatch) {
+            size_t n = v.size() - nStart < nBatch ? v.size() - nStart : nBatch;
+            CLReflect<T>::AppendRecords(v.data() + nStart, n, T::TYPE, m_outBuf);
+            m_nBlockRecords += n;
+            m_bOk = EndChunk(m_fd);
+        }
+        return End();
+    }
+
+    void SetFsyncPolicy(ELFsyncPolicy ePolicy) {
+        m_eFsyncPolicy = ePolicy;
+    }
+
+    // 双缓冲写出：缓冲区满后交给后台线程 write，调用线程换一个空缓冲区继续编码（见 CLWriteBehind）
+    // 只应在没有未 End 的写入时切换
+    void SetWriteBehind(bool bEnable) {
+        m_bWriteBehind = bEnable;
+    }
+
+    // 缓冲区积累多少字节后写出一次；越大系统调用越少，但占用内存越多
+    void SetFlushThreshold(size_t nBytes) {
+        m_nFlushThreshold = nBytes > 0 ? nBytes : 1;
+    }
+
+    // 归档标志（见 CLCompact.hpp）：0 写出无文件头的旧格式（默认）；
+    // ARCHIVE_FLAG_COMPACT 写出文件头并使用 varint/zigzag 紧凑编码，ARCHIVE_FLAG_FLOAT_XOR 另外对浮点字段做异或压缩；
+    // ARCHIVE_FLAG_BLOCKS 把编码后的记录按块压缩（见 SetBlockCodec），可与前两者组合
+    // 读取时按文件头自动识别，与写入端的设置无关
+    void SetArchiveFlags(uint32_t nFlags) {
+        if (nFlags & ARCHIVE_FLAG_FLOAT_XOR) {
+            nFlags |= ARCHIVE_FLAG_COMPACT;
+        }
+        m_nArchiveFlags = nFlags & ARCHIVE_KNOWN_FLAGS;
+    }
+
+    // 分块压缩使用的编解码器与每块的原始字节数（块在记录边界切分，单条记录超过 nBlockSize 时独占一块）
+    // 编解码器必须是内置的或已通过 RegisterCodec 注册，否则返回 false
+    bool SetBlockCodec(uint32_t nCodecId, size_t nBlockSize = 256 * 1024) {
+        if (!m_codecs.Find(nCodecId)) {
+            return false;
+        }
+        m_nBlockCodec = nCodecId;
+        m_nBlockSize = nBlockSize > 0 ? nBlockSize : 1;
+        return true;
+    }
+
+    // 注册自定义块编解码器，写入与读取都使用这张表；编解码器对象由调用方持有
+    bool RegisterCodec(ILBlockCodec *pCodec) {
+        return m_codecs.Register(pCodec);
     }
 
     // 反序列化：从文件读取并重建对象列表
     bool Deserialize(const std::string &filePath, std::vector<std::unique_ptr<ILSerializable>> &v) {
+        return ReadRecords(
+            filePath,
+            [&v](ILSerializable *proto, std::istream &is) {
+                // 原型工厂模式的核心：proto 是工厂，返回的是新创建的 unique_ptr
+                auto newObj = proto->Deserialize(is);
+                if (!newObj) {
+                    return false;
+                }
+                v.push_back(std::move(newObj)); // 转移所有权到 vector
+                return true;
+            },
+            [&v](ILSerializable *proto, CLCompactReader &r) {
+                auto newObj = proto->DeserializeCompact(r);
+                if (!newObj) {
+                    return false;
+                }
+                v.push_back(std::move(newObj));
+                return true;
+            });
+    }
+
+    // 多线程反序列化分块归档（写入时设置了 ARCHIVE_FLAG_BLOCKS）：块索引中的记录数就是同步点
+    // 各线程从共享计数器领取块，解压后解码到线程自己的临时数组，再按块首记录的序号移入 v 的对应位置，
+    // 因此结果顺序与 Deserialize 相同；nThreads 为 0 时使用 CPU 核数
+    // 要求原型的 Deserialize / DeserializeCompact 不修改原型自身（可被多个线程同时调用）
+    // 非分块归档没有同步点，退回顺序读取；失败时 v 恢复为调用前的内容
+    bool DeserializeParallel(const std::string &filePath, std::vector<std::unique_ptr<ILSerializable>> &v, unsigned nThreads = 0) {
+        CLBlockArchive archive(&m_codecs);
+        if (!archive.Open(filePath)) {
+            return Deserialize(filePath, v);
+        }
+
+        // 记录数来自块索引，Open 已按各块的原始长度校验过（见 CLBlockArchive::ParseIndex），不会超出压缩数据能容纳的记录数
+        const size_t nBase = v.size();
+        v.resize(nBase + archive.GetRecordCount());
+        std::atomic<size_t> nNext(0);
+        std::atomic<bool> bOk(true);
+        auto worker = [this, &archive, &v, nBase, &nNext, &bOk]() {
+            std::vector<char> vRaw;
+            std::vector<std::unique_ptr<ILSerializable>> vLocal;
+            auto factory = [&vLocal](ILSerializable *proto, std::istream &is) {
+                auto newObj = proto->Deserialize(is);
+                if (!newObj) {
+                    return false;
+                }
+                vLocal.push_back(std::move(newObj));
+                return true;
+            };
+            auto compactFactory = [&vLocal](ILSerializable *proto, CLCompactReader &r) {
+                auto newObj = proto->DeserializeCompact(r);
+                if (!newObj) {
+                    return false;
+                }
+                vLocal.push_back(std::move(newObj));
+                return true;
+            };
+
+            for (size_t nBlock = nNext++; nBlock < archive.GetBlockCount() && bOk; nBlock = nNext++) {
+                const CLBlockEntry &entry = archive.GetBlock(nBlock);
+                vLocal.clear();
+                if (!archive.DecompressBlock(nBlock, vRaw) || !DecodeBlock(vRaw.data(), entry.nRawSize, archive.GetFlags(), factory, compactFactory) ||
+                    vLocal.size() != entry.nRecordCount) {
+                    bOk = false;
+                    break;
+                }
+                std::move(vLocal.begin(), vLocal.end(), v.begin() + nBase + archive.GetFirstRecord(nBlock));
+            }
+        };
+
+        RunParallel((unsigned)std::min<size_t>(nThreads ? nThreads : CLBlockArchive::DefaultThreads(), std::max<size_t>(archive.GetBlockCount(), 1)),
+                    worker);
+        if (!bOk) {
+            std::cerr << "Warning: Failed to decode " << filePath << "." << std::endl;
+            v.resize(nBase);
+            return false;
+        }
+        return true;
+    }
+
+    // 反序列化到 arena：对象连续放置在 arena 的内存块中，v 中的指针在 arena.Reset() 之前有效
+    // 紧凑归档的对象由 DeserializeCompact 在堆上创建，交给 arena 托管析构
+    bool Deserialize(const std::string &filePath, std::vector<ILSerializable *> &v, CLArena &arena) {
+        return ReadRecords(
+            filePath,
+            [&v, &arena](ILSerializable *proto, std::istream &is) {
+                ILSerializable *newObj = proto->DeserializeInto(is, arena);
+                if (!newObj) {
+                    return false;
+                }
+                v.push_back(newObj);
+                return true;
+            },
+            [&v, &arena](ILSerializable *proto, CLCompactReader &r) {
+                auto newObj = proto->DeserializeCompact(r);
+                if (!newObj) {
+                    return false;
+                }
+                v.push_back(arena.Adopt(newObj.release()));
+                return true;
+            });
+    }
+
+    // 注册原型对象：注册时建立 类型 ID -> 原型 的索引，GetType() 只在这里调用一次
+    // 同一类型 ID 重复注册时返回 false，保留先注册的原型
+    bool Register(ILSerializable *pSerialized) {
+        if (!pSerialized) {
+            return false;
+        }
+
+        int nType = pSerialized->GetType();
+        if (Lookup(nType)) {
+            std::cerr << "Warning: Type ID " << nType << " is already registered." << std::endl;
+            return false;
+        }
+
+        if (nType >= 0 && nType < DENSE_TYPE_LIMIT) {
+            if ((size_t)nType >= m_dense.size()) {
+                m_dense.resize(nType + 1, nullptr);
+            }
+            m_dense[nType] = pSerialized;
+        } else {
+            m_sparse[nType] = pSerialized;
+        }
+        return true;
+    }
+
+    // 按类型 ID 查找已注册的原型，未注册时返回 nullptr
+    ILSerializable *Lookup(int nType) const {
+        if (nType >= 0 && nType < DENSE_TYPE_LIMIT) {
+            return (size_t)nType < m_dense.size() ? m_dense[nType] : nullptr;
+        }
+        auto it = m_sparse.find(nType);
+        return it != m_sparse.end() ? it->second : nullptr;
+    }
+
+private:
+    bool Flush(int fd) {
+        return WriteAll(fd, m_outBuf);
+    }
+
+    // 把缓冲区内容写到 fd 后清空；双缓冲模式下交给后台线程，返回时 buf 已换成空缓冲区
+    bool WriteAll(int fd, CLOutputBuffer &buf) {
+        if (m_bWriteBehind) {
+            return m_writeBehind.Submit(fd, buf);
+        }
+        bool bOk = WriteFully(fd, buf.Data(), buf.Size());
+        buf.Clear();
+        return bOk;
+    }
+
+    // 按 m_nArchiveFlags 写出文件头，返回是否使用紧凑编码
+    // 分块模式下文件头不压缩，直接进入分块写入器；m_outBuf 只存放当前块的原始记录
+    bool BeginArchive() {
+        m_bBlocks = (m_nArchiveFlags & ARCHIVE_FLAG_BLOCKS) != 0;
+        m_nBlockRecords = 0;
+        if (m_nArchiveFlags == 0) {
+            return false;
+        }
+        if (m_bBlocks) {
+            m_blockWriter.Begin(m_nArchiveFlags, m_codecs.Find(m_nBlockCodec));
+        } else {
+            CLArchiveHeader header = {ARCHIVE_MAGIC, m_nArchiveFlags};
+            m_outBuf.Put(header);
+        }
+        m_compact.Reset((m_nArchiveFlags & ARCHIVE_FLAG_FLOAT_XOR) != 0);
+        return (m_nArchiveFlags & ARCHIVE_FLAG_COMPACT) != 0;
+    }
+
+    // 分块模式下 m_outBuf 积累一块的数据，否则积累到写出阈值
+    size_t ChunkLimit() const {
+        return m_bBlocks ? m_nBlockSize : m_nFlushThreshold;
+    }
+
+    // 一条记录编码完毕
+    bool EndRecord(int fd) {
+        m_nBlockRecords++;
+        return m_outBuf.Size() < ChunkLimit() || EndChunk(fd);
+    }
+
+    // m_outBuf 中是若干条完整记录：分块模式下压缩成一块，否则直接写出
+    bool EndChunk(int fd) {
+        if (!m_bBlocks) {
+            return Flush(fd);
+        }
+        if (m_outBuf.Size() > 0) {
+            m_blockWriter.AddBlock(m_outBuf.Data(), m_outBuf.Size(), m_nBlockRecords);
+            m_outBuf.Clear();
+            m_nBlockRecords = 0;
+            // 每块从干净的浮点异或状态开始，解码时块之间互不依赖
+            m_compact.Reset((m_nArchiveFlags & ARCHIVE_FLAG_FLOAT_XOR) != 0);
+        }
+        if (m_blockWriter.Buffer().Size() >= m_nFlushThreshold) {
+            return WriteAll(fd, m_blockWriter.Buffer());
+        }
+        return true;
+    }
+
+    // 写出剩余数据，按落盘策略同步后关闭文件
+    bool Finish(int fd, bool bOk) {
+        if (bOk && m_bBlocks) {
+            bOk = EndChunk(fd);
+            m_blockWriter.End();
+            bOk = bOk && WriteAll(fd, m_blockWriter.Buffer());
+        } else if (bOk) {
+            bOk = Flush(fd);
+        }
+        if (m_bWriteBehind) {
+            bOk = m_writeBehind.Wait() && bOk; // 关闭文件之前必须等后台写出结束
+        }
+        if (bOk && m_eFsyncPolicy == FSYNC_DATA) {
+            bOk = ::fdatasync(fd) == 0;
+        } else if (bOk && m_eFsyncPolicy == FSYNC_FULL) {
+            bOk = ::fsync(fd) == 0;
+        }
+        m_outBuf.Clear();
+        if (::close(fd) == -1) {
+            bOk = false;
+        }
+        return bOk;
+    }
+
+    // 逐条读取记录，按类型 ID 找到原型后交给 factory 创建对象；紧凑归档交给 compactFactory
+    template <typename Factory, typename CompactFactory>
+    bool ReadRecords(const std::string &filePath, Factory factory, CompactFactory compactFactory) {
         std::ifstream ifs(filePath, std::ios::binary);
         if (!ifs.is_open()) {
             return false;
         }
 
+        // 识别文件头：没有 ARCHIVE_MAGIC 的是旧格式，回到文件开头按原方式读取
+        CLArchiveHeader header = {0, 0};
+        if (!ifs.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.nMagic != ARCHIVE_MAGIC) {
+            ifs.clear();
+            ifs.seekg(0);
+        } else if (header.nFlags & ~ARCHIVE_KNOWN_FLAGS) {
+            std::cerr << "Warning: Unsupported archive flags " << header.nFlags << "." << std::endl;
+            return false;
+        } else if (header.nFlags & ARCHIVE_FLAG_BLOCKS) {
+            ifs.close();
+            return ReadBlockRecords(filePath, factory, compactFactory);
+        } else if (header.nFlags & ARCHIVE_FLAG_COMPACT) {
+            return ReadCompactRecords(ifs, (header.nFlags & ARCHIVE_FLAG_FLOAT_XOR) != 0, compactFactory);
+        }
+        return ReadStreamRecords(ifs, factory);
+    }
+
+    // 旧格式：从流中逐条读取直到结束
+    template <typename Factory>
+    bool ReadStreamRecords(std::istream &is, Factory factory) const {
         // 尝试读取文件直到结束
-        while (ifs.peek() != EOF) {
+        while (is.peek() != EOF) {
             int nType = -1;
             // 1. 读取类型 ID
-            ifs.read(reinterpret_cast<char *>(&nType), sizeof(int));
+            is.read(reinterpret_cast<char *>(&nType), sizeof(int));
 
-            if (ifs.eof() || ifs.fail()) {
+            if (is.eof() || is.fail()) {
                 break;
             }
 
-            // 2. 在注册的原型列表中查找对应的处理器
-            bool found = false;
-            for (auto *proto : m_prototypes) {
-                if (proto->GetType() == nType) {
-                    // 3. 调用原型的 Deserialize 创建新对象
-                    // 原型工厂模式的核心：proto 是工厂，返回的是新创建的 unique_ptr
-                    auto newObj = proto->Deserialize(ifs);
-                    if (newObj) {
-                        v.push_back(std::move(newObj)); // 转移所有权到 vector
-                        found = true;
-                    }
-                    break;
-                }
-            }
+            // 2. 按类型 ID 在分派索引中查找对应的原型，O(1)，与注册类型数量无关
+            ILSerializable *proto = Lookup(nType);
 
-            if (!found) {
+            // 3. 调用原型创建新对象
+            if (!proto || !factory(proto, is)) {
                 std::cerr << "Warning: Unknown type ID " << nType << " encountered." << std::endl;
                 // 在实际项目中，这里可能需要一种机制来跳过未知对象的字节，或者直接报错
                 return false;
@@ -70,12 +463,99 @@ public:
         return true;
     }
 
-    // 注册原型对象
-    void Register(ILSerializable *pSerialized) {
-        m_prototypes.push_back(pSerialized);
+    // 紧凑归档：其余内容一次读入内存（末尾补 COMPACT_PADDING 个零字节），在内存中逐条解码
+    template <typename CompactFactory>
+    bool ReadCompactRecords(std::ifstream &ifs, bool bFloatXor, CompactFactory compactFactory) {
+        std::streampos nStart = ifs.tellg();
+        ifs.seekg(0, std::ios::end);
+        size_t nSize = (size_t)(ifs.tellg() - nStart);
+        ifs.seekg(nStart);
+        std::vector<char> vData(nSize + COMPACT_PADDING, 0);
+        if (nSize > 0 && !ifs.read(vData.data(), nSize)) {
+            return false;
+        }
+
+        return DecodeCompactRecords(vData.data(), nSize, bFloatXor, compactFactory);
+    }
+
+    // 在内存中逐条解码紧凑编码的记录，[pData + nSize, pData + nSize + COMPACT_PADDING) 必须可读
+    template <typename CompactFactory>
+    bool DecodeCompactRecords(const char *pData, size_t nSize, bool bFloatXor, CompactFactory compactFactory) const {
+        CLCompactReader r(pData, nSize, bFloatXor);
+        while (!r.AtEnd()) {
+            int nType = r.GetSigned32();
+            if (r.HasError()) {
+                break;
+            }
+            ILSerializable *proto = Lookup(nType);
+            if (!proto || !compactFactory(proto, r)) {
+                std::cerr << "Warning: Unknown type ID " << nType << " encountered." << std::endl;
+                return false;
+            }
+        }
+        return !r.HasError();
+    }
+
+    // 分块归档：每次并行解压一批块（每个线程若干块），再按顺序解码，内存占用与文件大小无关
+    template <typename Factory, typename CompactFactory>
+    bool ReadBlockRecords(const std::string &filePath, Factory factory, CompactFactory compactFactory) {
+        CLBlockArchive archive(&m_codecs);
+        if (!archive.Open(filePath)) {
+            return false;
+        }
+        const unsigned nThreads = CLBlockArchive::DefaultThreads();
+        const size_t nWindow = nThreads * 4;
+
+        std::vector<std::vector<char>> vBlocks;
+        for (size_t nFirst = 0; nFirst < archive.GetBlockCount(); nFirst += nWindow) {
+            size_t nCount = std::min(nWindow, archive.GetBlockCount() - nFirst);
+            if (!archive.Decompress(nFirst, nCount, vBlocks, nThreads)) {
+                std::cerr << "Warning: Corrupted block in " << filePath << "." << std::endl;
+                return false;
+            }
+            for (size_t k = 0; k < nCount; k++) {
+                if (!DecodeBlock(vBlocks[k].data(), archive.GetBlock(nFirst + k).nRawSize, archive.GetFlags(), factory, compactFactory)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // 解码一块解压后的记录，编码方式由归档标志决定；可在多个线程中同时调用
+    template <typename Factory, typename CompactFactory>
+    bool DecodeBlock(const char *pData, size_t nSize, uint32_t nFlags, Factory &factory, CompactFactory &compactFactory) const {
+        if (nFlags & ARCHIVE_FLAG_COMPACT) {
+            return DecodeCompactRecords(pData, nSize, (nFlags & ARCHIVE_FLAG_FLOAT_XOR) != 0, compactFactory);
+        }
+        CLMemoryStreamBuf buf(pData, nSize);
+        std::istream is(&buf);
+        return ReadStreamRecords(is, factory);
     }
 
 private:
-    // 存储用于反序列化的“原型”对象指针
-    std::vector<ILSerializable *> m_prototypes;
+    // 存储用于反序列化的“原型”对象指针，按类型 ID 索引
+    std::vector<ILSerializable *> m_dense;              // 小的非负 ID：直接下标访问
+    std::unordered_map<int, ILSerializable *> m_sparse; // 负数或过大的 ID
+
+    CLOutputBuffer m_outBuf;    // 序列化输出缓冲区，跨调用复用
+    CLCompactWriter m_compact; // 紧凑编码写入 m_outBuf，须在 m_outBuf 之后声明
+    ELFsyncPolicy m_eFsyncPolicy;
+    size_t m_nFlushThreshold;
+    uint32_t m_nArchiveFlags;
+
+    CLCodecTable m_codecs;
+    CLBlockWriter m_blockWriter; // 分块模式下压缩后的输出
+    uint32_t m_nBlockCodec;
+    size_t m_nBlockSize;
+    bool m_bBlocks;         // 当前归档是否分块
+    size_t m_nBlockRecords; // 当前块已编码的记录数
+
+    bool m_bWriteBehind;
+    CLWriteBehind m_writeBehind;
+
+    // 增量写入的状态
+    int m_fd;       // 未 Begin 时为 -1
+    bool m_bCompact; // 当前归档是否紧凑编码
+    bool m_bOk;
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CLFileIO.hpp"
+#include "CLOutputBuffer.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// 后台写出线程（双缓冲）：调用方把写满的缓冲区交给它，换回一个已写完的空缓冲区后立即继续编码，
+// 编码与 write 系统调用重叠进行；同一时刻最多有一个缓冲区在写出
+// 写出失败会在之后的 Submit / Wait 中报告
+class CLWriteBehind {
+public:
+    CLWriteBehind() : m_fd(-1), m_bPending(false), m_bStop(false), m_bOk(true) {}
+
+    ~CLWriteBehind() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
+        }
+        m_cond.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    CLWriteBehind(const CLWriteBehind &) = delete;
+    CLWriteBehind &operator=(const CLWriteBehind &) = delete;
+
+    // 等待上一次写出完成，再把 buf 的内容交给写出线程，buf 换成空缓冲区；返回此前的写出是否都成功
+    bool Submit(int fd, CLOutputBuffer &buf) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&CLWriteBehind::Run, this); // 首次使用时启动
+        }
+        m_cond.wait(lock, [this]() { return !m_bPending; });
+        m_buf.Swap(buf);
+        buf.Clear();
+        m_fd = fd;
+        m_bPending = true;
+        m_cond.notify_all();
+        return m_bOk;
+    }
+
+    // 等待已提交的数据全部写出，返回期间的写出是否都成功，并清除错误状态
+    bool Wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this]() { return !m_bPending; });
+        bool bOk = m_bOk;
+        m_bOk = true;
+        return bOk;
+    }
+
+private:
+    void Run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cond.wait(lock, [this]() { return m_bPending || m_bStop; });
+            if (!m_bPending) {
+                return;
+            }
+            // 写出期间不持有锁，调用方可以继续编码到另一个缓冲区
+            lock.unlock();
+            bool bOk = WriteFully(m_fd, m_buf.Data(), m_buf.Size());
+            lock.lock();
+            m_buf.Clear();
+            m_bOk = m_bOk && bOk;
+            m_bPending = false;
+            m_cond.notify_all();
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond; // 调用方与写出线程共用，两个方向的等待条件互不相同
+    std::thread m_thread;
+    CLOutputBuffer m_buf; // 正在写出的缓冲区
+    int m_fd;
+    bool m_bPending; // m_buf 中有待写出的数据
+    bool m_bStop;
+    bool m_bOk;
+};
@@ -1,4 +1,10 @@
 #pragma once
+#include "CLArena.hpp"
+#include "CLCompact.hpp"
+#include "CLMemoryStreamBuf.hpp"
+#include "CLOutputBuffer.hpp"
+#include "CLReflect.hpp"
+#include <cstring>
 #include <iostream>
 #include <memory> // for std::unique_ptr
 
@@ -10,10 +16,46 @@ public:
     // 纯虚函数：序列化当前对象到输出流
     virtual bool Serialize(std::ostream &os) const = 0;
 
+    // 序列化到内存缓冲区（CLSerializer 的批量写路径）
+    // 默认实现通过缓冲区自带的 ostream 转调上面的版本，子类重写为直接 Put 字段以绕开流的虚函数开销
+    virtual bool Serialize(CLOutputBuffer &buf) const {
+        return Serialize(buf.Stream());
+    }
+
     // 纯虚函数：从输入流反序列化创建新对象 (原型模式工厂方法)
     // 返回 unique_ptr 以转移所有权，防止内存泄漏
     virtual std::unique_ptr<ILSerializable> Deserialize(std::istream &is) = 0;
 
+    // 从输入流反序列化，对象放置构造在 arena 中，生命周期由 arena 管理（Reset 时析构）
+    // 默认实现退化为堆分配后交给 arena 接管，子类重写以获得连续内存与零 malloc
+    virtual ILSerializable *DeserializeInto(std::istream &is, CLArena &arena) {
+        return arena.Adopt(Deserialize(is).release());
+    }
+
+    // 紧凑编码（varint/zigzag，见 CLCompact.hpp），用于带 ARCHIVE_FLAG_COMPACT 标志的归档
+    // 默认实现：varint 长度前缀 + 原始编码，手写序列化的类型无需改动即可写入紧凑归档
+    virtual bool SerializeCompact(CLCompactWriter &w) const {
+        CLOutputBuffer &scratch = w.Scratch();
+        scratch.Clear();
+        if (!Serialize(scratch)) {
+            return false;
+        }
+        w.PutVarint32((uint32_t)scratch.Size());
+        w.PutRaw(scratch.Data(), scratch.Size());
+        return true;
+    }
+
+    virtual std::unique_ptr<ILSerializable> DeserializeCompact(CLCompactReader &r) {
+        uint32_t nSize = r.GetVarint32();
+        const char *p = r.GetRaw(nSize);
+        if (p == NULL) {
+            return nullptr;
+        }
+        CLMemoryStreamBuf buf(p, nSize);
+        std::istream is(&buf);
+        return Deserialize(is);
+    }
+
     // 获取类型标识
     virtual int GetType() const = 0;
 
@@ -21,29 +63,96 @@ public:
     virtual void f() const = 0;
 };
 
-// ================= Class A =================
-class A : public ILSerializable {
+// 编译期反射适配器（CRTP）：Derived 只需提供默认构造函数与 Fields() 字段描述，
+// ILSerializable 的各个虚函数由 CLReflect<Derived> 生成的定长编解码器实现
+// 手写 Serialize/Deserialize 的类型仍直接继承 ILSerializable，两者可以混存在同一个归档中
+template <typename Derived, int TypeID>
+class CLReflectSerializable : public ILSerializable {
 public:
-    A() : i(0) {}
-    explicit A(int val) : i(val) {}
-
-    void f() const override {
-        std::cout << "[Class A] i = " << i << std::endl;
-    }
+    static const int TYPE = TypeID;
 
     int GetType() const override {
-        return 0; // Type ID for A
+        return TypeID;
     }
 
     bool Serialize(std::ostream &os) const override {
-        os.write(reinterpret_cast<const char *>(&i), sizeof(i));
-        return os.good();
+        return CLReflect<Derived>::Write(Self(), os);
+    }
+
+    bool Serialize(CLOutputBuffer &buf) const override {
+        CLReflect<Derived>::Append(Self(), buf);
+        return true;
     }
 
     std::unique_ptr<ILSerializable> Deserialize(std::istream &is) override {
-        auto p = std::make_unique<A>();                        // 创建新对象
-        is.read(reinterpret_cast<char *>(&(p->i)), sizeof(i)); // 填充数据
-        return p;                                              // 返回基类指针
+        auto p = std::make_unique<Derived>();
+        if (!CLReflect<Derived>::Read(*p, is)) {
+            return nullptr;
+        }
+        return p;
+    }
+
+    ILSerializable *DeserializeInto(std::istream &is, CLArena &arena) override {
+        Derived *p = arena.Create<Derived>();
+        if (!CLReflect<Derived>::Read(*p, is)) {
+            return nullptr;
+        }
+        return p;
+    }
+
+    bool SerializeCompact(CLCompactWriter &w) const override {
+        CLReflect<Derived>::WriteCompact(Self(), w, TypeID);
+        return true;
+    }
+
+    std::unique_ptr<ILSerializable> DeserializeCompact(CLCompactReader &r) override {
+        auto p = std::make_unique<Derived>();
+        if (!CLReflect<Derived>::ReadCompact(*p, r, TypeID)) {
+            return nullptr;
+        }
+        return p;
+    }
+
+private:
+    const Derived &Self() const {
+        return static_cast<const Derived &>(*this);
+    }
+};
+
+// ================= Class A =================
+class A : public CLReflectSerializable<A, 0> {
+public:
+    // 零拷贝视图：直接读取归档中的字段，不构造对象（供 CLMappedArchive 使用）
+    class View {
+    public:
+        static const int TYPE = A::TYPE;
+        static const size_t WIRE_SIZE = sizeof(int);
+        // 字段布局：按 Serialize 的写入顺序列出每个字段的字节数（供 CLColumnarWriter 拆分列）
+        enum { FIELD_I = 0 };
+        static constexpr size_t FIELD_SIZES[] = {sizeof(int)};
+
+        explicit View(const char *p) : m_p(p) {}
+
+        int GetI() const {
+            int v;
+            memcpy(&v, m_p, sizeof(v)); // 归档中的字段不保证对齐
+            return v;
+        }
+
+    private:
+        const char *m_p;
+    };
+
+    A() : i(0) {}
+    explicit A(int val) : i(val) {}
+
+    void f() const override {
+        std::cout << "[Class A] i = " << i << std::endl;
+    }
+
+    // 字段描述：序列化/反序列化代码由 CLReflect<A> 在编译期生成
+    static constexpr auto Fields() {
+        return std::make_tuple(&A::i);
     }
 
 private:
@@ -51,8 +160,33 @@ private:
 };
 
 // ================= Class B =================
-class B : public ILSerializable {
+class B : public CLReflectSerializable<B, 1> {
 public:
+    class View {
+    public:
+        static const int TYPE = B::TYPE;
+        static const size_t WIRE_SIZE = 2 * sizeof(int);
+        enum { FIELD_I = 0, FIELD_J = 1 };
+        static constexpr size_t FIELD_SIZES[] = {sizeof(int), sizeof(int)};
+
+        explicit View(const char *p) : m_p(p) {}
+
+        int GetI() const {
+            int v;
+            memcpy(&v, m_p, sizeof(v));
+            return v;
+        }
+
+        int GetJ() const {
+            int v;
+            memcpy(&v, m_p + sizeof(int), sizeof(v));
+            return v;
+        }
+
+    private:
+        const char *m_p;
+    };
+
     B() : i(0), j(0) {}
     B(int val) : i(val), j(val + 1) {}
 
@@ -60,21 +194,8 @@ public:
         std::cout << "[Class B] i = " << i << ", j = " << j << std::endl;
     }
 
-    int GetType() const override {
-        return 1; // Type ID for B
-    }
-
-    bool Serialize(std::ostream &os) const override {
-        os.write(reinterpret_cast<const char *>(&i), sizeof(i));
-        os.write(reinterpret_cast<const char *>(&j), sizeof(j));
-        return os.good();
-    }
-
-    std::unique_ptr<ILSerializable> Deserialize(std::istream &is) override {
-        auto p = std::make_unique<B>();
-        is.read(reinterpret_cast<char *>(&(p->i)), sizeof(i));
-        is.read(reinterpret_cast<char *>(&(p->j)), sizeof(j));
-        return p;
+    static constexpr auto Fields() {
+        return std::make_tuple(&B::i, &B::j);
     }
 
 private:
@@ -82,8 +203,27 @@ private:
 };
 
 // ================= Class C  =================
-class C : public ILSerializable {
+class C : public CLReflectSerializable<C, 2> {
 public:
+    class View {
+    public:
+        static const int TYPE = C::TYPE;
+        static const size_t WIRE_SIZE = sizeof(double);
+        enum { FIELD_D = 0 };
+        static constexpr size_t FIELD_SIZES[] = {sizeof(double)};
+
+        explicit View(const char *p) : m_p(p) {}
+
+        double GetD() const {
+            double v;
+            memcpy(&v, m_p, sizeof(v));
+            return v;
+        }
+
+    private:
+        const char *m_p;
+    };
+
     C() : d(0.0) {}
     explicit C(double val) : d(val) {}
 
@@ -91,19 +231,8 @@ public:
         std::cout << "[Class C] d = " << d << std::endl;
     }
 
-    int GetType() const override {
-        return 2; // Type ID for C
-    }
-
-    bool Serialize(std::ostream &os) const override {
-        os.write(reinterpret_cast<const char *>(&d), sizeof(d));
-        return os.good();
-    }
-
-    std::unique_ptr<ILSerializable> Deserialize(std::istream &is) override {
-        auto p = std::make_unique<C>();
-        is.read(reinterpret_cast<char *>(&(p->d)), sizeof(d));
-        return p;
+    static constexpr auto Fields() {
+        return std::make_tuple(&C::d);
     }
 
 private:
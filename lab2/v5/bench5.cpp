@@ -0,0 +1,492 @@
+#include "CLArena.hpp"
+#include "CLAsyncSerializer.hpp"
+#include "CLBlockArchive.hpp"
+#include "CLMappedArchive.hpp"
+#include "CLSerializer.hpp"
+#include "Serializable.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// 【版本5扩展】：比较 ofstream/缓冲批量序列化、ifstream 反序列化、紧凑编码与 mmap 原地遍历的开销
+// 用法: ./lab2-bench5 [记录数，默认 3000000]
+
+static double SecondsSince(chrono::steady_clock::time_point tStart) {
+    return chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+}
+
+int main(int argc, char **argv) {
+    const string DATA_FILE = "data5_bench.bin";
+    size_t nRecords = argc > 1 ? strtoul(argv[1], NULL, 10) : 3000000;
+
+    // ================= 生成归档 =================
+    long long nExpectedSumA = 0, nExpectedSumB = 0;
+    double dExpectedSumC = 0;
+    {
+        vector<unique_ptr<ILSerializable>> objects;
+        objects.reserve(nRecords);
+        for (size_t i = 0; i < nRecords; i++) {
+            int v = (int)(i % 100000);
+            switch (i % 3) {
+            case 0:
+                objects.push_back(make_unique<A>(v));
+                nExpectedSumA += v;
+                break;
+            case 1:
+                objects.push_back(make_unique<B>(v));
+                nExpectedSumB += v + (v + 1);
+                break;
+            default:
+                objects.push_back(make_unique<C>(v * 0.5));
+                dExpectedSumC += v * 0.5;
+                break;
+            }
+        }
+
+        vector<ILSerializable *> v_write;
+        v_write.reserve(nRecords);
+        for (auto &obj : objects) {
+            v_write.push_back(obj.get());
+        }
+        // 旧版写法：ofstream 每条记录两次 write（类型 ID + 负载）
+        auto tStart = chrono::steady_clock::now();
+        {
+            ofstream ofs(DATA_FILE, ios::binary);
+            for (const auto *ptr : v_write) {
+                int type = ptr->GetType();
+                ofs.write(reinterpret_cast<const char *>(&type), sizeof(int));
+                ptr->Serialize(ofs);
+            }
+        }
+        double dSeconds = SecondsSince(tStart);
+        printf("ofstream Serialize   : %8.3f s  %7.1f Mrec/s\n", dSeconds, nRecords / dSeconds / 1e6);
+
+        // 【版本5扩展】：编码到复用的内存缓冲区，批量 write；第二次调用时缓冲区已就绪
+        CLSerializer s;
+        for (int nRound = 0; nRound < 2; nRound++) {
+            tStart = chrono::steady_clock::now();
+            if (!s.Serialize(DATA_FILE, v_write)) {
+                cerr << "Failed to write " << DATA_FILE << endl;
+                return 1;
+            }
+            dSeconds = SecondsSince(tStart);
+            printf("buffered Serialize #%d: %8.3f s  %7.1f Mrec/s\n", nRound + 1, dSeconds, nRecords / dSeconds / 1e6);
+        }
+        cout << "Wrote " << nRecords << " records to " << DATA_FILE << endl;
+    }
+
+    A protoA;
+    B protoB;
+    C protoC;
+
+    // ================= ifstream 反序列化 =================
+    {
+        CLSerializer s;
+        s.Register(&protoA);
+        s.Register(&protoB);
+        s.Register(&protoC);
+
+        vector<unique_ptr<ILSerializable>> v_read;
+        auto tStart = chrono::steady_clock::now();
+        bool bOk = s.Deserialize(DATA_FILE, v_read);
+        double dSeconds = SecondsSince(tStart);
+        printf("ifstream Deserialize : %8.3f s  %7.1f Mrec/s  objects=%zu%s\n", dSeconds, v_read.size() / dSeconds / 1e6,
+               v_read.size(), bOk ? "" : "  [failed]");
+
+        // 遍历已加载的对象：堆上逐个分配的对象
+        long long nTypeSum = 0;
+        tStart = chrono::steady_clock::now();
+        for (const auto &obj : v_read) {
+            nTypeSum += obj->GetType();
+        }
+        dSeconds = SecondsSince(tStart);
+        printf("  iterate heap objects : %8.3f s  (type sum %lld)\n", dSeconds, nTypeSum);
+
+        // 【版本5扩展】：反序列化到 arena，对象连续存放，一次 Reset 全部释放
+        CLArena arena;
+        vector<ILSerializable *> v_arena;
+        v_arena.reserve(nRecords);
+        tStart = chrono::steady_clock::now();
+        bOk = s.Deserialize(DATA_FILE, v_arena, arena);
+        dSeconds = SecondsSince(tStart);
+        printf("ifstream Deserialize (arena): %8.3f s  %7.1f Mrec/s  objects=%zu  arena=%zuB in %zu chunks%s\n", dSeconds,
+               v_arena.size() / dSeconds / 1e6, v_arena.size(), arena.GetBytesUsed(), arena.GetChunkCount(), bOk ? "" : "  [failed]");
+
+        nTypeSum = 0;
+        tStart = chrono::steady_clock::now();
+        for (const auto *obj : v_arena) {
+            nTypeSum += obj->GetType();
+        }
+        dSeconds = SecondsSince(tStart);
+        printf("  iterate arena objects: %8.3f s  (type sum %lld)\n", dSeconds, nTypeSum);
+
+        tStart = chrono::steady_clock::now();
+        v_arena.clear();
+        arena.Reset();
+        printf("  arena reset          : %8.3f s\n", SecondsSince(tStart));
+    }
+
+    // ================= 同类型数组：虚函数逐个序列化 vs 编译期生成的编码器 =================
+    {
+        const string TYPED_FILE = "data5_typed.bin";
+        vector<B> vB;
+        vB.reserve(nRecords);
+        for (size_t i = 0; i < nRecords; i++) {
+            vB.push_back(B((int)(i % 100000)));
+        }
+        vector<ILSerializable *> v_write;
+        v_write.reserve(nRecords);
+        for (auto &b : vB) {
+            v_write.push_back(&b);
+        }
+
+        CLSerializer s;
+        double dVirtual = 1e9, dTyped = 1e9;
+        bool bOk = true;
+        for (int nRound = 0; nRound < 2; nRound++) {
+            auto tStart = chrono::steady_clock::now();
+            bOk = s.Serialize(DATA_FILE + ".virtual", v_write) && bOk;
+            dVirtual = min(dVirtual, SecondsSince(tStart));
+            tStart = chrono::steady_clock::now();
+            bOk = s.SerializeTyped(TYPED_FILE, vB) && bOk;
+            dTyped = min(dTyped, SecondsSince(tStart));
+        }
+
+        // 两条路径写出的归档应逐字节相同
+        ifstream f1(DATA_FILE + ".virtual", ios::binary), f2(TYPED_FILE, ios::binary);
+        string strVirtual((istreambuf_iterator<char>(f1)), istreambuf_iterator<char>());
+        string strTyped((istreambuf_iterator<char>(f2)), istreambuf_iterator<char>());
+        printf("B[] virtual Serialize: %8.3f s  %7.1f Mrec/s\n", dVirtual, nRecords / dVirtual / 1e6);
+        printf("B[] SerializeTyped   : %8.3f s  %7.1f Mrec/s  %s\n", dTyped, nRecords / dTyped / 1e6,
+               bOk && strVirtual == strTyped ? "identical output" : "OUTPUT MISMATCH");
+        remove((DATA_FILE + ".virtual").c_str());
+        remove(TYPED_FILE.c_str());
+    }
+
+    // ================= 紧凑编码：文件大小与读写吞吐 =================
+    // 读回的对象重新按旧格式写出，应与原归档逐字节相同
+    {
+        CLSerializer s;
+        s.Register(&protoA);
+        s.Register(&protoB);
+        s.Register(&protoC);
+        vector<unique_ptr<ILSerializable>> objects;
+        s.Deserialize(DATA_FILE, objects);
+        vector<ILSerializable *> v_write;
+        v_write.reserve(objects.size());
+        for (auto &obj : objects) {
+            v_write.push_back(obj.get());
+        }
+        ifstream ifs(DATA_FILE, ios::binary);
+        string strOriginal((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+
+        const char *modeNames[] = {"legacy", "compact", "compact+xor", "legacy+lz", "compact+lz", "compact+xor+lz"};
+        const uint32_t modeFlags[] = {0,
+                                      ARCHIVE_FLAG_COMPACT,
+                                      ARCHIVE_FLAG_COMPACT | ARCHIVE_FLAG_FLOAT_XOR,
+                                      ARCHIVE_FLAG_BLOCKS,
+                                      ARCHIVE_FLAG_COMPACT | ARCHIVE_FLAG_BLOCKS,
+                                      ARCHIVE_FLAG_COMPACT | ARCHIVE_FLAG_FLOAT_XOR | ARCHIVE_FLAG_BLOCKS};
+        const string COMPACT_FILE = "data5_compact.bin";
+        for (int nMode = 0; nMode < 6; nMode++) {
+            s.SetArchiveFlags(modeFlags[nMode]);
+            double dWrite = 1e9, dRead = 1e9;
+            bool bOk = true;
+            vector<unique_ptr<ILSerializable>> v_read;
+            for (int nRound = 0; nRound < 2; nRound++) {
+                auto tStart = chrono::steady_clock::now();
+                bOk = s.Serialize(COMPACT_FILE, v_write) && bOk;
+                dWrite = min(dWrite, SecondsSince(tStart));
+                v_read.clear();
+                tStart = chrono::steady_clock::now();
+                bOk = s.Deserialize(COMPACT_FILE, v_read) && bOk;
+                dRead = min(dRead, SecondsSince(tStart));
+            }
+            ifstream f(COMPACT_FILE, ios::binary | ios::ate);
+            size_t nFileSize = (size_t)f.tellg();
+
+            vector<ILSerializable *> v_again;
+            for (auto &obj : v_read) {
+                v_again.push_back(obj.get());
+            }
+            s.SetArchiveFlags(0);
+            bOk = s.Serialize(COMPACT_FILE, v_again) && bOk;
+            ifstream f2(COMPACT_FILE, ios::binary);
+            string strAgain((istreambuf_iterator<char>(f2)), istreambuf_iterator<char>());
+            printf("%-14s: %9zu B (%5.1f%%)  write %7.1f Mrec/s  read %7.1f Mrec/s  %s\n", modeNames[nMode], nFileSize,
+                   100.0 * nFileSize / strOriginal.size(), nRecords / dWrite / 1e6, nRecords / dRead / 1e6,
+                   bOk && strAgain == strOriginal ? "round trip ok" : "ROUND TRIP MISMATCH");
+        }
+
+        // 分块归档（旧格式记录）：各块解压后依次拼接应与旧格式归档相同
+        s.SetArchiveFlags(ARCHIVE_FLAG_BLOCKS);
+        s.Serialize(COMPACT_FILE, v_write);
+        CLBlockArchive blocks;
+        if (blocks.Open(COMPACT_FILE)) {
+            vector<vector<char>> vBlocks;
+            const unsigned nThreads = CLBlockArchive::DefaultThreads();
+            auto tStart = chrono::steady_clock::now();
+            bool bOk = blocks.DecompressAll(vBlocks, 1);
+            double dSerial = SecondsSince(tStart);
+            tStart = chrono::steady_clock::now();
+            bOk = blocks.DecompressAll(vBlocks, nThreads) && bOk;
+            double dParallel = SecondsSince(tStart);
+            string strJoined;
+            for (size_t i = 0; i < blocks.GetBlockCount(); i++) {
+                strJoined.append(vBlocks[i].data(), blocks.GetBlock(i).nRawSize);
+            }
+            printf("lz blocks     : %zu blocks  decompress 1 thread %7.1f MB/s, %u threads %7.1f MB/s  %s\n", blocks.GetBlockCount(),
+                   strOriginal.size() / dSerial / 1e6, nThreads, strOriginal.size() / dParallel / 1e6,
+                   bOk && strJoined == strOriginal ? "content match" : "CONTENT MISMATCH");
+
+            // 定位到第 nRecords / 2 条记录：按块索引找到所在的块，只解压这一块
+            tStart = chrono::steady_clock::now();
+            size_t nBlock = blocks.FindBlock(nRecords / 2);
+            vector<char> vBlock;
+            bOk = nBlock < blocks.GetBlockCount() && blocks.DecompressBlock(nBlock, vBlock);
+            double dSeek = SecondsSince(tStart);
+            size_t nRawOffset = 0;
+            for (size_t i = 0; i < nBlock; i++) {
+                nRawOffset += blocks.GetBlock(i).nRawSize;
+            }
+            bOk = bOk && strOriginal.compare(nRawOffset, blocks.GetBlock(nBlock).nRawSize, vBlock.data(), blocks.GetBlock(nBlock).nRawSize) == 0;
+            printf("lz seek       : record %zu in block %zu (first record %zu)  %8.1f us  %s\n", nRecords / 2, nBlock,
+                   blocks.GetFirstRecord(nBlock), dSeek * 1e6, bOk ? "content match" : "CONTENT MISMATCH");
+        }
+        remove(COMPACT_FILE.c_str());
+    }
+
+    // ================= 分块归档：顺序 vs 多线程反序列化 =================
+    // 结果应与顺序读取逐个相同（重新写成旧格式后比较字节）
+    {
+        CLSerializer s;
+        s.Register(&protoA);
+        s.Register(&protoB);
+        s.Register(&protoC);
+        vector<unique_ptr<ILSerializable>> objects;
+        s.Deserialize(DATA_FILE, objects);
+        vector<ILSerializable *> v_write;
+        v_write.reserve(objects.size());
+        for (auto &obj : objects) {
+            v_write.push_back(obj.get());
+        }
+        ifstream ifs(DATA_FILE, ios::binary);
+        string strOriginal((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+
+        const string BLOCK_FILE = "data5_blocks.bin";
+        const char *modeNames[] = {"legacy+store", "compact+xor+lz"};
+        const uint32_t modeFlags[] = {ARCHIVE_FLAG_BLOCKS, ARCHIVE_FLAG_COMPACT | ARCHIVE_FLAG_FLOAT_XOR | ARCHIVE_FLAG_BLOCKS};
+        const uint32_t modeCodecs[] = {BLOCK_CODEC_STORE, BLOCK_CODEC_LZ};
+        for (int nMode = 0; nMode < 2; nMode++) {
+            s.SetArchiveFlags(modeFlags[nMode]);
+            s.SetBlockCodec(modeCodecs[nMode]);
+            s.Serialize(BLOCK_FILE, v_write);
+
+            vector<unique_ptr<ILSerializable>> v_read;
+            auto tStart = chrono::steady_clock::now();
+            bool bOk = s.Deserialize(BLOCK_FILE, v_read);
+            double dSequential = SecondsSince(tStart);
+            printf("%-14s: Deserialize          %8.3f s  %7.1f Mrec/s%s\n", modeNames[nMode], dSequential, v_read.size() / dSequential / 1e6,
+                   bOk ? "" : "  [failed]");
+
+            // 至少测到 4 个线程，单核机器上也能验证多线程结果的顺序
+            for (unsigned nThreads = 1; nThreads <= max(4u, CLBlockArchive::DefaultThreads()); nThreads *= 2) {
+                v_read.clear();
+                tStart = chrono::steady_clock::now();
+                bOk = s.DeserializeParallel(BLOCK_FILE, v_read, nThreads);
+                double dSeconds = SecondsSince(tStart);
+
+                vector<ILSerializable *> v_again;
+                for (auto &obj : v_read) {
+                    v_again.push_back(obj.get());
+                }
+                s.SetArchiveFlags(0);
+                bOk = s.Serialize(BLOCK_FILE + ".check", v_again) && bOk;
+                s.SetArchiveFlags(modeFlags[nMode]);
+                ifstream f(BLOCK_FILE + ".check", ios::binary);
+                string strAgain((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+                printf("%-14s: DeserializeParallel/%-2u %8.3f s  %7.1f Mrec/s  speedup %.2fx  %s\n", modeNames[nMode], nThreads, dSeconds,
+                       v_read.size() / dSeconds / 1e6, dSequential / dSeconds, bOk && strAgain == strOriginal ? "same order" : "ORDER MISMATCH");
+            }
+        }
+        remove(BLOCK_FILE.c_str());
+        remove((BLOCK_FILE + ".check").c_str());
+    }
+
+    // ================= 异步写入：生产者只入队，编码与写出在后台 =================
+    {
+        ifstream ifs(DATA_FILE, ios::binary);
+        string strOriginal((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+        const string ASYNC_FILE = "data5_async.bin";
+        auto makeObject = [](size_t i) -> unique_ptr<ILSerializable> {
+            int v = (int)(i % 100000);
+            switch (i % 3) {
+            case 0:
+                return make_unique<A>(v);
+            case 1:
+                return make_unique<B>(v);
+            default:
+                return make_unique<C>(v * 0.5);
+            }
+        };
+
+        // 同步基线：调用方创建对象后阻塞在 Serialize 上直到写完
+        {
+            auto tStart = chrono::steady_clock::now();
+            vector<unique_ptr<ILSerializable>> objects;
+            vector<ILSerializable *> v_write;
+            objects.reserve(nRecords);
+            v_write.reserve(nRecords);
+            for (size_t i = 0; i < nRecords; i++) {
+                objects.push_back(makeObject(i));
+                v_write.push_back(objects.back().get());
+            }
+            CLSerializer s;
+            s.Serialize(ASYNC_FILE, v_write);
+            double dSeconds = SecondsSince(tStart);
+            printf("sync create+Serialize: caller blocked %8.3f s  %7.1f Mrec/s\n", dSeconds, nRecords / dSeconds / 1e6);
+        }
+
+        // 单生产者：记录顺序确定，输出应与旧格式归档逐字节相同
+        {
+            CLAsyncSerializer writer;
+            writer.Open(ASYNC_FILE);
+            auto tStart = chrono::steady_clock::now();
+            for (size_t i = 0; i < nRecords; i++) {
+                writer.Push(makeObject(i));
+            }
+            double dProducer = SecondsSince(tStart);
+            size_t nDepthAfterPush = writer.GetQueueDepth();
+            bool bOk = writer.Flush().get();
+            double dFlushed = SecondsSince(tStart);
+            bOk = writer.Close() && bOk;
+            ifstream f(ASYNC_FILE, ios::binary);
+            string strAsync((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+            printf("async Push (1 producer): caller busy %8.3f s  %7.1f Mrec/s  flushed after %.3f s  depth %zu/%zu peak %zu  %s\n", dProducer,
+                   nRecords / dProducer / 1e6, dFlushed, nDepthAfterPush, writer.GetCapacity(), writer.GetPeakQueueDepth(),
+                   bOk && strAsync == strOriginal ? "identical output" : "OUTPUT MISMATCH");
+        }
+
+        // 多生产者：记录交错顺序不确定，检查记录数与各类型校验和
+        {
+            const int PRODUCERS = 4;
+            CLAsyncSerializer writer;
+            writer.Open(ASYNC_FILE);
+            auto tStart = chrono::steady_clock::now();
+            vector<thread> vProducers;
+            for (int t = 0; t < PRODUCERS; t++) {
+                vProducers.emplace_back([&writer, &makeObject, t, nRecords]() {
+                    for (size_t i = t; i < nRecords; i += PRODUCERS) {
+                        writer.Push(makeObject(i));
+                    }
+                });
+            }
+            for (auto &t : vProducers) {
+                t.join();
+            }
+            double dProducer = SecondsSince(tStart);
+            bool bOk = writer.Close();
+
+            CLMappedArchive check;
+            check.Register<A::View>();
+            check.Register<B::View>();
+            check.Register<C::View>();
+            bOk = check.Open(ASYNC_FILE) && bOk;
+            long long nSumA = 0, nSumB = 0;
+            double dSumC = 0;
+            size_t nCount = 0;
+            nCount += check.ForEach<A::View>([&nSumA](const A::View &a) { nSumA += a.GetI(); });
+            nCount += check.ForEach<B::View>([&nSumB](const B::View &b) { nSumB += b.GetI() + b.GetJ(); });
+            nCount += check.ForEach<C::View>([&dSumC](const C::View &c) { dSumC += c.GetD(); });
+            bool bMatch = bOk && !check.HasError() && nCount == nRecords && nSumA == nExpectedSumA && nSumB == nExpectedSumB && dSumC == dExpectedSumC;
+            printf("async Push (%d producers): producers busy %8.3f s  %7.1f Mrec/s  peak depth %zu  %s\n", PRODUCERS, dProducer,
+                   nRecords / dProducer / 1e6, writer.GetPeakQueueDepth(), bMatch ? "checksums match" : "CHECKSUM MISMATCH");
+        }
+        remove(ASYNC_FILE.c_str());
+    }
+
+    CLMappedArchive archive;
+    archive.Register<A::View>(&protoA);
+    archive.Register<B::View>(&protoB);
+    archive.Register<C::View>(&protoC);
+    if (!archive.Open(DATA_FILE)) {
+        cerr << "Failed to map " << DATA_FILE << endl;
+        return 1;
+    }
+
+    // ================= mmap + 视图遍历 =================
+    {
+        long long nSumA = 0, nSumB = 0;
+        double dSumC = 0;
+        size_t nCount = 0;
+        auto tStart = chrono::steady_clock::now();
+        for (const auto &rec : archive) {
+            switch (rec.GetType()) {
+            case A::View::TYPE:
+                nSumA += rec.As<A::View>().GetI();
+                break;
+            case B::View::TYPE: {
+                B::View b = rec.As<B::View>();
+                nSumB += b.GetI() + b.GetJ();
+                break;
+            }
+            case C::View::TYPE:
+                dSumC += rec.As<C::View>().GetD();
+                break;
+            }
+            nCount++;
+        }
+        double dSeconds = SecondsSince(tStart);
+        bool bMatch = !archive.HasError() && nCount == nRecords && nSumA == nExpectedSumA && nSumB == nExpectedSumB
+                      && dSumC == dExpectedSumC;
+        printf("mmap typed views     : %8.3f s  %7.1f Mrec/s  records=%zu  %s\n", dSeconds, nCount / dSeconds / 1e6,
+               nCount, bMatch ? "checksums match" : "CHECKSUM MISMATCH");
+    }
+
+    // ================= mmap + 按类型过滤 =================
+    {
+        long long nSumA = 0;
+        auto tStart = chrono::steady_clock::now();
+        size_t nCount = archive.ForEach<A::View>([&nSumA](const A::View &a) { nSumA += a.GetI(); });
+        double dSeconds = SecondsSince(tStart);
+        printf("mmap ForEach<A::View>: %8.3f s  %7.1f Mrec/s  matched=%zu  %s\n", dSeconds, nRecords / dSeconds / 1e6,
+               nCount, nSumA == nExpectedSumA ? "checksum match" : "CHECKSUM MISMATCH");
+    }
+
+    // ================= mmap + 按需物化 =================
+    {
+        vector<unique_ptr<ILSerializable>> v_read;
+        auto tStart = chrono::steady_clock::now();
+        bool bOk = archive.MaterializeAll(v_read);
+        double dSeconds = SecondsSince(tStart);
+        printf("mmap MaterializeAll  : %8.3f s  %7.1f Mrec/s  objects=%zu%s\n", dSeconds, v_read.size() / dSeconds / 1e6,
+               v_read.size(), bOk ? "" : "  [failed]");
+        if (!v_read.empty()) {
+            v_read.front()->f();
+            v_read.back()->f();
+        }
+    }
+
+    // ================= mmap + 物化到 arena =================
+    {
+        CLArena arena;
+        vector<ILSerializable *> v_arena;
+        v_arena.reserve(nRecords);
+        auto tStart = chrono::steady_clock::now();
+        bool bOk = archive.MaterializeAll(v_arena, arena);
+        double dSeconds = SecondsSince(tStart);
+        printf("mmap MaterializeAll (arena): %8.3f s  %7.1f Mrec/s  objects=%zu%s\n", dSeconds, v_arena.size() / dSeconds / 1e6,
+               v_arena.size(), bOk ? "" : "  [failed]");
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "CLColumnarArchive.hpp"
+#include "CLMappedArchive.hpp"
+#include "CLSerializer.hpp"
+#include "Serializable.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace std;
+
+#define BENCH_ROUNDS 3
+
+// 【版本5扩展】：只读取一个字段（全部 B::j）时，行式归档与列式归档的开销对比
+// 用法: ./lab2-bench5-columnar [记录数，默认 3000000]
+
+static double SecondsSince(chrono::steady_clock::time_point tStart) {
+    return chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+}
+
+static long long FileSize(const string &path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (long long)st.st_size : -1;
+}
+
+int main(int argc, char **argv) {
+    const string ROW_FILE = "data5_row.bin";
+    const string COLUMN_FILE = "data5_column.bin";
+    size_t nRecords = argc > 1 ? strtoul(argv[1], NULL, 10) : 3000000;
+
+    // ================= 生成两种归档 =================
+    long long nExpectedSumJ = 0;
+    {
+        vector<unique_ptr<ILSerializable>> objects;
+        vector<ILSerializable *> v_write;
+        objects.reserve(nRecords);
+        v_write.reserve(nRecords);
+        for (size_t i = 0; i < nRecords; i++) {
+            int v = (int)(i % 100000);
+            switch (i % 3) {
+            case 0:
+                objects.push_back(make_unique<A>(v));
+                break;
+            case 1:
+                objects.push_back(make_unique<B>(v));
+                nExpectedSumJ += v + 1;
+                break;
+            default:
+                objects.push_back(make_unique<C>(v * 0.5));
+                break;
+            }
+            v_write.push_back(objects.back().get());
+        }
+
+        CLSerializer rowWriter;
+        auto tStart = chrono::steady_clock::now();
+        if (!rowWriter.Serialize(ROW_FILE, v_write)) {
+            cerr << "Failed to write " << ROW_FILE << endl;
+            return 1;
+        }
+        printf("write row archive    : %8.3f s  %lld bytes\n", SecondsSince(tStart), FileSize(ROW_FILE));
+
+        CLColumnarWriter columnWriter;
+        columnWriter.Register<A::View>();
+        columnWriter.Register<B::View>();
+        columnWriter.Register<C::View>();
+        tStart = chrono::steady_clock::now();
+        if (!columnWriter.Write(COLUMN_FILE, v_write)) {
+            cerr << "Failed to write " << COLUMN_FILE << endl;
+            return 1;
+        }
+        printf("write column archive : %8.3f s  %lld bytes\n", SecondsSince(tStart), FileSize(COLUMN_FILE));
+    }
+
+    // 每种读法重复 BENCH_ROUNDS 次取最快一次：刚写入的文件首次映射要额外承担一次性的缺页开销
+    // ================= 行式：遍历全部记录，取出 B::j =================
+    {
+        double dBest = 1e9;
+        long long nSumJ = 0;
+        size_t nCount = 0;
+        for (int nRound = 0; nRound < BENCH_ROUNDS; nRound++) {
+            auto tStart = chrono::steady_clock::now();
+            CLMappedArchive archive;
+            archive.Register<A::View>();
+            archive.Register<B::View>();
+            archive.Register<C::View>();
+            nSumJ = 0;
+            nCount = 0;
+            if (archive.Open(ROW_FILE)) {
+                nCount = archive.ForEach<B::View>([&nSumJ](const B::View &b) { nSumJ += b.GetJ(); });
+            }
+            dBest = min(dBest, SecondsSince(tStart));
+        }
+        printf("row scan B::j        : %8.3f s  values=%zu  %s\n", dBest, nCount,
+               nSumJ == nExpectedSumJ ? "checksum match" : "CHECKSUM MISMATCH");
+    }
+
+    // ================= 列式：整列一次 memcpy 载入 =================
+    {
+        double dBest = 1e9;
+        long long nSumJ = 0;
+        size_t nCount = 0;
+        for (int nRound = 0; nRound < BENCH_ROUNDS; nRound++) {
+            auto tStart = chrono::steady_clock::now();
+            CLColumnarArchive archive;
+            vector<int> vJ;
+            nSumJ = 0;
+            if (archive.Open(COLUMN_FILE) && archive.LoadColumn(B::View::TYPE, B::View::FIELD_J, vJ)) {
+                for (int j : vJ) {
+                    nSumJ += j;
+                }
+            }
+            nCount = vJ.size();
+            dBest = min(dBest, SecondsSince(tStart));
+        }
+        printf("column load B::j     : %8.3f s  values=%zu  %s\n", dBest, nCount,
+               nSumJ == nExpectedSumJ ? "checksum match" : "CHECKSUM MISMATCH");
+    }
+
+    // ================= 列式：直接在映射内存上求和 =================
+    {
+        double dBest = 1e9;
+        long long nSumJ = 0;
+        size_t nCount = 0;
+        for (int nRound = 0; nRound < BENCH_ROUNDS; nRound++) {
+            auto tStart = chrono::steady_clock::now();
+            CLColumnarArchive archive;
+            nSumJ = 0;
+            nCount = 0;
+            if (archive.Open(COLUMN_FILE)) {
+                CLColumnarArchive::CColumn column = archive.GetColumn(B::View::TYPE, B::View::FIELD_J);
+                nCount = column.nCount;
+                for (size_t i = 0; i < column.nCount; i++) {
+                    int j;
+                    memcpy(&j, column.pData + i * sizeof(int), sizeof(int));
+                    nSumJ += j;
+                }
+            }
+            dBest = min(dBest, SecondsSince(tStart));
+        }
+        printf("column scan B::j     : %8.3f s  values=%zu  %s\n", dBest, nCount,
+               nSumJ == nExpectedSumJ ? "checksum match" : "CHECKSUM MISMATCH");
+    }
+
+    remove(ROW_FILE.c_str());
+    remove(COLUMN_FILE.c_str());
+    return 0;
+}
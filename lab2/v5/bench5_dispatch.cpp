@@ -0,0 +1,141 @@
+#include "CLSerializer.hpp"
+#include "Serializable.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 【版本5扩展】：注册类型数量增长时，每条记录查找原型的开销
+// 对比 CLSerializer 的索引查找与旧版逐个比较 GetType() 的线性查找，两者都只计查找本身，不含 I/O 与解码
+// 每种类型数量下先完整反序列化一次，确认索引分派的结果正确（不计时）
+// 用法: ./lab2-bench5-dispatch [记录数，默认 1000000]
+
+#define MAX_SYNTHETIC_TYPES 1024
+
+// 合成的记录类型：每个原型实例携带自己的类型 ID，注册时按 GetType() 建立索引
+class CLSyntheticRecord : public ILSerializable {
+public:
+    explicit CLSyntheticRecord(int nID) : m_nID(nID), v(nID) {}
+
+    void f() const override {
+        cout << "[Synthetic " << m_nID << "] v = " << v << endl;
+    }
+
+    int GetType() const override {
+        return m_nID;
+    }
+
+    bool Serialize(std::ostream &os) const override {
+        os.write(reinterpret_cast<const char *>(&v), sizeof(v));
+        return os.good();
+    }
+
+    std::unique_ptr<ILSerializable> Deserialize(std::istream &is) override {
+        auto p = std::make_unique<CLSyntheticRecord>(m_nID);
+        is.read(reinterpret_cast<char *>(&(p->v)), sizeof(v));
+        return p;
+    }
+
+private:
+    int m_nID;
+    int v;
+};
+
+static double NanosSince(chrono::steady_clock::time_point tStart) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - tStart).count();
+}
+
+int main(int argc, char **argv) {
+    const string DATA_FILE = "data5_dispatch.bin";
+    size_t nRecords = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    vector<unique_ptr<ILSerializable>> prototypes;
+    for (int i = 0; i < MAX_SYNTHETIC_TYPES; i++) {
+        prototypes.push_back(make_unique<CLSyntheticRecord>(i));
+    }
+
+    // 重复注册检测
+    {
+        CLSerializer s;
+        bool bFirst = s.Register(prototypes[0].get());
+        bool bSecond = s.Register(prototypes[0].get());
+        cout << "Duplicate registration: first=" << bFirst << " second=" << bSecond << endl;
+    }
+
+    printf("%8s %22s %24s\n", "types", "indexed lookup", "linear lookup (old)");
+    const size_t typeCounts[] = {1, 4, 16, 64, 256, 1024};
+    for (size_t nTypes : typeCounts) {
+        // 记录类型在已注册类型中均匀随机分布
+        vector<ILSerializable *> v_write;
+        vector<int> vTypes;
+        v_write.reserve(nRecords);
+        vTypes.reserve(nRecords);
+        unsigned int nSeed = 12345;
+        for (size_t i = 0; i < nRecords; i++) {
+            nSeed = nSeed * 1103515245 + 12345;
+            size_t nIndex = (nSeed >> 8) % nTypes;
+            v_write.push_back(prototypes[nIndex].get());
+            vTypes.push_back((int)nIndex);
+        }
+
+        CLSerializer writer;
+        if (!writer.Serialize(DATA_FILE, v_write)) {
+            cerr << "Failed to write " << DATA_FILE << endl;
+            return 1;
+        }
+
+        // 正确性：按索引分派完整反序列化一次
+        CLSerializer reader;
+        for (size_t i = 0; i < nTypes; i++) {
+            reader.Register(prototypes[i].get());
+        }
+        vector<unique_ptr<ILSerializable>> v_read;
+        v_read.reserve(nRecords);
+        if (!reader.Deserialize(DATA_FILE, v_read) || v_read.size() != nRecords) {
+            cerr << "Deserialization failed with " << nTypes << " types" << endl;
+            return 1;
+        }
+
+        // 索引查找：Deserialize 对每条记录所做的 Lookup
+        // 用找到的原型累加类型 ID，防止编译器把查找优化掉
+        size_t nIndexedFound = 0;
+        long long nIndexedSum = 0;
+        auto tStart = chrono::steady_clock::now();
+        for (int nType : vTypes) {
+            ILSerializable *proto = reader.Lookup(nType);
+            if (proto) {
+                nIndexedFound++;
+                nIndexedSum += proto->GetType();
+            }
+        }
+        double dIndexed = NanosSince(tStart) / nRecords;
+
+        // 旧版线性查找：逐个调用原型的 GetType() 比较
+        vector<ILSerializable *> vLinear;
+        for (size_t i = 0; i < nTypes; i++) {
+            vLinear.push_back(prototypes[i].get());
+        }
+        size_t nLinearFound = 0;
+        long long nLinearSum = 0;
+        tStart = chrono::steady_clock::now();
+        for (int nType : vTypes) {
+            for (auto *proto : vLinear) {
+                if (proto->GetType() == nType) {
+                    nLinearFound++;
+                    nLinearSum += proto->GetType();
+                    break;
+                }
+            }
+        }
+        double dLinear = NanosSince(tStart) / nRecords;
+
+        bool bOk = nIndexedFound == nRecords && nLinearFound == nRecords && nIndexedSum == nLinearSum;
+        printf("%8zu %16.1f ns/rec %18.1f ns/rec%s\n", nTypes, dIndexed, dLinear, bOk ? "" : "  [lookup miss]");
+    }
+
+    remove(DATA_FILE.c_str());
+    return 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CPerfCounter.hpp
+ * 功能: perf_event_open 的简单封装，统计指定进程（或自身）的用户态指令数与周期数
+ *       虚拟机或容器中硬件计数器常不可用，此时 IsAvailable() 返回 false，调用方应输出 n/a
+ *************************************************************************/
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+class CPerfCounter {
+public:
+    // nPid 为 0 表示当前线程；仅统计用户态，perf_event_paranoid <= 2 时普通用户即可使用
+    CPerfCounter(int nPid, uint64_t nConfig = PERF_COUNT_HW_INSTRUCTIONS) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = nConfig;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1; // 统计之后创建的线程
+        m_fd = (int)::syscall(SYS_perf_event_open, &attr, nPid, -1, -1, 0);
+    }
+
+    virtual ~CPerfCounter() {
+        if (m_fd != -1) {
+            ::close(m_fd);
+        }
+    }
+
+    CPerfCounter(const CPerfCounter &) = delete;
+    CPerfCounter &operator=(const CPerfCounter &) = delete;
+
+public:
+    bool IsAvailable() const {
+        return m_fd != -1;
+    }
+
+    void Start() {
+        if (m_fd != -1) {
+            ::ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    // 停止计数并返回累计值，不可用时返回 0
+    uint64_t Stop() {
+        if (m_fd == -1) {
+            return 0;
+        }
+        ::ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t nValue = 0;
+        if (::read(m_fd, &nValue, sizeof(nValue)) != sizeof(nValue)) {
+            return 0;
+        }
+        return nValue;
+    }
+
+private:
+    int m_fd;
+};
@@ -0,0 +1,322 @@
+/*************************************************************************
+ * 文件名: bench_paradigms.cpp
+ * 功能: lab3 五种编程范式 Echo 服务端的对比基准测试
+ *       1. 分派微基准：在进程内单独复现五种“框架调用业务”的方式，测量每次分派的耗时与指令数
+ *          hw1 函数指针回调 / hw2 虚函数继承 / hw3 观察者接口 / hw4 CRTP / hw5 Mixin
+ *       2. 端到端测试：依次启动 hw1~hw5 的服务端进程（默认 epoll 模式，输出重定向到 /dev/null），
+ *          用 CLoadGenerator 经回环地址施压，统计消息吞吐、延迟、服务端每条消息的 CPU 时间与指令数
+ * 用法: ./bench-paradigms [每个服务端的压测秒数，默认 3] [微基准迭代次数（百万），默认 100]
+ *************************************************************************/
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../hw5/CLoadGenerator.hpp"
+#include "CPerfCounter.hpp"
+
+#define SERVER_PORT 5000
+#define MESSAGE_SIZE 64
+
+// 分派测试中禁止编译器把驱动循环针对具体实参克隆或内联，模拟框架代码与业务代码分离编译
+#define BENCH_NOINLINE __attribute__((noinline, noclone))
+
+static char g_message[MESSAGE_SIZE] = "hello, paradigms";
+// 端到端测试的结果行，最后统一输出，避免被压测过程的日志打断
+static std::vector<std::string> g_vSummary;
+
+// 各范式共用的业务：读取消息中的一个字节累加（volatile 读阻止循环被向量化或整体消除）
+static inline uint64_t TouchMessage(int nSocket, const char *pMessage) {
+    return *(volatile const char *)&pMessage[nSocket & (MESSAGE_SIZE - 1)];
+}
+
+// ---------------- hw1: 函数指针回调 ----------------
+typedef bool (*TCPServerCallback)(int nConnectedSocket, const char *pMessage);
+
+static uint64_t g_nCallbackSum = 0;
+
+static bool EchoCallback(int nSocket, const char *pMessage) {
+    g_nCallbackSum += TouchMessage(nSocket, pMessage);
+    return true;
+}
+
+BENCH_NOINLINE static void DriveCallback(TCPServerCallback pCallback, uint64_t nIters) {
+    for (uint64_t i = 0; i < nIters; i++) {
+        pCallback((int)i, g_message);
+    }
+}
+
+// ---------------- hw2: 虚函数继承 ----------------
+class CVirtualServer {
+public:
+    virtual ~CVirtualServer() {
+    }
+
+    BENCH_NOINLINE void Drive(uint64_t nIters) {
+        for (uint64_t i = 0; i < nIters; i++) {
+            ServerFunction((int)i, g_message);
+        }
+    }
+
+    virtual bool ServerFunction(int /*nSocket*/, const char * /*pMessage*/) {
+        return true;
+    }
+};
+
+class CVirtualEcho : public CVirtualServer {
+public:
+    uint64_t m_nSum = 0;
+
+    bool ServerFunction(int nSocket, const char *pMessage) override {
+        m_nSum += TouchMessage(nSocket, pMessage);
+        return true;
+    }
+};
+
+// ---------------- hw3: 观察者接口 ----------------
+class CServerObserver {
+public:
+    virtual ~CServerObserver() {
+    }
+    virtual bool ServerFunction(int nSocket, const char *pMessage) = 0;
+};
+
+class CObservedServer {
+public:
+    explicit CObservedServer(CServerObserver *pObserver) : m_pObserver(pObserver) {
+    }
+
+    BENCH_NOINLINE void Drive(uint64_t nIters) {
+        for (uint64_t i = 0; i < nIters; i++) {
+            m_pObserver->ServerFunction((int)i, g_message);
+        }
+    }
+
+private:
+    CServerObserver *m_pObserver;
+};
+
+class CObserverEcho : public CServerObserver {
+public:
+    uint64_t m_nSum = 0;
+
+    bool ServerFunction(int nSocket, const char *pMessage) override {
+        m_nSum += TouchMessage(nSocket, pMessage);
+        return true;
+    }
+};
+
+// ---------------- hw4: CRTP ----------------
+template <typename Derived>
+class CCRTPServer {
+public:
+    BENCH_NOINLINE void Drive(uint64_t nIters) {
+        Derived *pDerived = static_cast<Derived *>(this);
+        for (uint64_t i = 0; i < nIters; i++) {
+            pDerived->ServerFunction((int)i, g_message);
+        }
+    }
+};
+
+class CCRTPEcho : public CCRTPServer<CCRTPEcho> {
+public:
+    uint64_t m_nSum = 0;
+
+    bool ServerFunction(int nSocket, const char *pMessage) {
+        m_nSum += TouchMessage(nSocket, pMessage);
+        return true;
+    }
+};
+
+// ---------------- hw5: Mixin ----------------
+template <typename ConnectionProcessor>
+class CMixinServer : public ConnectionProcessor {
+public:
+    BENCH_NOINLINE void Drive(uint64_t nIters) {
+        for (uint64_t i = 0; i < nIters; i++) {
+            ConnectionProcessor::ServerFunction((int)i, g_message);
+        }
+    }
+};
+
+class CMixinEcho {
+public:
+    uint64_t m_nSum = 0;
+
+    bool ServerFunction(int nSocket, const char *pMessage) {
+        m_nSum += TouchMessage(nSocket, pMessage);
+        return true;
+    }
+};
+
+// 运行一项分派微基准并打印结果
+template <typename Func>
+static void RunDispatchBench(const char *pName, uint64_t nIters, Func func) {
+    func(nIters / 10); // 预热
+
+    CPerfCounter instructions(0);
+    auto tStart = std::chrono::steady_clock::now();
+    instructions.Start();
+    func(nIters);
+    uint64_t nInstructions = instructions.Stop();
+    double dNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - tStart).count();
+
+    if (instructions.IsAvailable()) {
+        printf("  %-22s %8.3f ns/dispatch  %7.2f instr/dispatch\n", pName, dNanos / nIters, (double)nInstructions / nIters);
+    } else {
+        printf("  %-22s %8.3f ns/dispatch  %7s instr/dispatch\n", pName, dNanos / nIters, "n/a");
+    }
+}
+
+static void RunDispatchBenches(uint64_t nIters) {
+    printf("[Dispatch] %llu iterations per paradigm\n", (unsigned long long)nIters);
+
+    RunDispatchBench("hw1 function pointer", nIters, [](uint64_t n) { DriveCallback(EchoCallback, n); });
+
+    CVirtualEcho virtualEcho;
+    CVirtualServer *pVirtual = &virtualEcho;
+    RunDispatchBench("hw2 virtual", nIters, [pVirtual](uint64_t n) { pVirtual->Drive(n); });
+
+    CObserverEcho observerEcho;
+    CObservedServer observed(&observerEcho);
+    RunDispatchBench("hw3 observer", nIters, [&observed](uint64_t n) { observed.Drive(n); });
+
+    CCRTPEcho crtpEcho;
+    RunDispatchBench("hw4 CRTP", nIters, [&crtpEcho](uint64_t n) { crtpEcho.Drive(n); });
+
+    CMixinServer<CMixinEcho> mixinEcho;
+    RunDispatchBench("hw5 mixin", nIters, [&mixinEcho](uint64_t n) { mixinEcho.Drive(n); });
+
+    // 输出累加结果，保证业务代码不被优化掉
+    uint64_t nCheck = g_nCallbackSum + virtualEcho.m_nSum + observerEcho.m_nSum + crtpEcho.m_nSum + mixinEcho.m_nSum;
+    printf("  (checksum %llu)\n", (unsigned long long)nCheck);
+}
+
+// 启动服务端进程，标准输出与错误输出重定向到 /dev/null
+static pid_t StartServer(const char *pPath) {
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        int fdNull = ::open("/dev/null", O_WRONLY);
+        if (fdNull != -1) {
+            ::dup2(fdNull, STDOUT_FILENO);
+            ::dup2(fdNull, STDERR_FILENO);
+            ::close(fdNull);
+        }
+        ::execl(pPath, pPath, (char *)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+// 等待服务端开始监听，超时返回 false
+static bool WaitForServer(pid_t pid) {
+    for (int nTry = 0; nTry < 300; nTry++) {
+        int nStatus;
+        if (::waitpid(pid, &nStatus, WNOHANG) == pid) {
+            return false;
+        }
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(SERVER_PORT);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool bOk = ::connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0;
+        ::close(fd);
+        if (bOk) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+static void RunServerBench(const char *pName, const char *pPath, int nSeconds) {
+    pid_t pid = StartServer(pPath);
+    if (pid == -1 || !WaitForServer(pid)) {
+        printf("  %-6s failed to start %s\n", pName, pPath);
+        if (pid > 0) {
+            ::kill(pid, SIGKILL);
+            ::waitpid(pid, NULL, 0);
+        }
+        return;
+    }
+
+    CLoadGenerator::CConfig config;
+    config.strServerIP = "127.0.0.1";
+    config.nServerPort = SERVER_PORT;
+    config.nConnections = 16;
+    config.nDepth = 8;
+    config.nSeconds = nSeconds;
+    config.nThreads = 1;
+    config.payload.Parse("64");
+
+    CPerfCounter instructions(pid);
+    instructions.Start();
+    CLoadGenerator generator(config);
+    generator.Run();
+    uint64_t nInstructions = instructions.Stop();
+
+    // 服务端的 CPU 时间取自进程退出后的 rusage（包含启动开销，相对压测时长可忽略）
+    ::kill(pid, SIGTERM);
+    int nStatus;
+    rusage usage;
+    ::wait4(pid, &nStatus, 0, &usage);
+    double dCpuNanos = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e9 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e3;
+
+    const CLatencyHistogram &histogram = generator.GetHistogram();
+    uint64_t nMessages = histogram.GetCount();
+    if (nMessages == 0) {
+        printf("  %-6s no messages completed\n", pName);
+        return;
+    }
+
+    char strInstr[32];
+    if (instructions.IsAvailable()) {
+        snprintf(strInstr, sizeof(strInstr), "%.0f", (double)nInstructions / nMessages);
+    } else {
+        snprintf(strInstr, sizeof(strInstr), "n/a");
+    }
+    char strLine[256];
+    snprintf(strLine, sizeof(strLine), "  %-6s %10.0f msg/s  p50=%7.1fus  p99=%7.1fus  server cpu=%7.0f ns/msg  user instr=%s /msg",
+             pName, generator.GetRequestsPerSecond(), histogram.Percentile(50) / 1e3, histogram.Percentile(99) / 1e3,
+             dCpuNanos / nMessages, strInstr);
+    g_vSummary.push_back(strLine);
+}
+
+int main(int argc, char **argv) {
+    int nSeconds = argc > 1 ? atoi(argv[1]) : 3;
+    uint64_t nIters = (argc > 2 ? strtoull(argv[2], NULL, 10) : 100) * 1000000ULL;
+    if (nSeconds < 1) {
+        nSeconds = 3;
+    }
+    if (nIters == 0) {
+        nIters = 100000000ULL;
+    }
+
+    RunDispatchBenches(nIters);
+
+    printf("[Servers] loopback echo, 16 connections x 8 in flight, %d-byte messages, %ds each\n", MESSAGE_SIZE, nSeconds);
+    RunServerBench("hw1", SERVER_HW1_PATH, nSeconds);
+    RunServerBench("hw2", SERVER_HW2_PATH, nSeconds);
+    RunServerBench("hw3", SERVER_HW3_PATH, nSeconds);
+    RunServerBench("hw4", SERVER_HW4_PATH, nSeconds);
+    RunServerBench("hw5", SERVER_HW5_PATH, nSeconds);
+
+    printf("[Summary]\n");
+    for (auto &strLine : g_vSummary) {
+        printf("%s\n", strLine.c_str());
+    }
+    return 0;
+}
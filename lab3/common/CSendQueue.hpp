@@ -0,0 +1,239 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CSendQueue.hpp
+ * 功能: epoll 事件循环的连接输出缓冲区
+ *       业务类通过 CSendQueue::Send 发送回复：套接字写不下的部分暂存在连接的输出缓冲区中，
+ *       并为该连接注册 EPOLLOUT，可写时由连接切面调用 Flush 继续发送，事件循环从不阻塞在单个连接上
+ *       积压超过 SEND_QUEUE_LIMIT 时业务类应停止读取（IsBacklogged），
+ *       剩余数据留在接收缓冲区，由 TCP 流控限制对端继续发送
+ * 用法: 事件循环在自己的线程上创建 CSendQueue，连接建立/关闭时 AddConnection / RemoveConnection；
+ *       业务代码只使用静态函数，当前线程没有事件循环（阻塞模式、线程池、独立的测试循环）时 Send 退化为完整写出
+ *       线程池中连接在不同工作线程上处理时，每个连接各有一个不自动启用的 CSendQueue，任务执行期间用 CActivation 启用
+ *       lab3 各版本服务端（hw1~hw5）共用这一实现
+ *************************************************************************/
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <unordered_map>
+
+// 单个连接积压的待发送数据上限
+#define SEND_QUEUE_LIMIT (256 * 1024)
+
+class CSendQueue {
+public:
+    // nEpoll 为连接所在的 epoll 实例，nEvents 为连接注册时的基本事件（不含 EPOLLOUT）
+    // nEpoll 为 -1 时不修改 epoll 注册，由调用方根据 GetPendingSize 自行注册 EPOLLOUT
+    // pBytesWritten 不为 NULL 时把写出的字节数累加到该计数器（如多 Reactor 的每线程统计）
+    // bActivate 为 false 时不成为当前线程的输出缓冲区，需要时用 CActivation 临时启用
+    CSendQueue(int nEpoll, uint32_t nEvents, std::atomic<uint64_t> *pBytesWritten = NULL, bool bActivate = true)
+        : m_nEpoll(nEpoll), m_nEvents(nEvents), m_pBytesWritten(pBytesWritten), m_bActive(bActivate), m_pPrevious(s_pCurrent) {
+        if (m_bActive) {
+            s_pCurrent = this;
+        }
+    }
+
+    ~CSendQueue() {
+        if (m_bActive) {
+            s_pCurrent = m_pPrevious;
+        }
+    }
+
+    CSendQueue(const CSendQueue &) = delete;
+    CSendQueue &operator=(const CSendQueue &) = delete;
+
+    // 在当前线程上临时启用一个 CSendQueue，作用域结束时恢复原来的实例
+    class CActivation {
+    public:
+        explicit CActivation(CSendQueue &queue) : m_pPrevious(s_pCurrent) {
+            s_pCurrent = &queue;
+        }
+
+        ~CActivation() {
+            s_pCurrent = m_pPrevious;
+        }
+
+        CActivation(const CActivation &) = delete;
+        CActivation &operator=(const CActivation &) = delete;
+
+    private:
+        CSendQueue *m_pPrevious;
+    };
+
+    void AddConnection(int fd) {
+        COutput &output = m_mapOutputs[fd];
+        output.nOffset = 0;
+        output.bWriteArmed = false;
+    }
+
+    // 连接关闭时丢弃尚未写出的数据
+    void RemoveConnection(int fd) {
+        m_mapOutputs.erase(fd);
+    }
+
+    // 套接字可写时调用：尽量写出积压数据，直到写完或发送缓冲区满
+    // 连接出错返回 false，并丢弃已无法写出的积压，业务类随后读取时会看到同一个错误
+    bool Flush(int fd) {
+        auto it = m_mapOutputs.find(fd);
+        if (it == m_mapOutputs.end()) {
+            return true;
+        }
+        COutput &output = it->second;
+        while (output.nOffset < output.strData.size()) {
+            ssize_t n = ::write(fd, output.strData.data() + output.nOffset, output.strData.size() - output.nOffset);
+            if (n > 0) {
+                output.nOffset += n;
+                CountWritten(n);
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                std::string().swap(output.strData);
+                output.nOffset = 0;
+                UpdateWriteInterest(fd, output);
+                return false;
+            }
+        }
+
+        // 全部写出后释放缓冲区；已写出的部分超过一半时前移剩余数据，避免缓冲区只增不减
+        if (output.nOffset == output.strData.size()) {
+            std::string().swap(output.strData);
+            output.nOffset = 0;
+        } else if (output.nOffset > output.strData.size() / 2) {
+            output.strData.erase(0, output.nOffset);
+            output.nOffset = 0;
+        }
+        return UpdateWriteInterest(fd, output);
+    }
+
+    size_t GetPendingSize(int fd) const {
+        auto it = m_mapOutputs.find(fd);
+        if (it == m_mapOutputs.end()) {
+            return 0;
+        }
+        return it->second.strData.size() - it->second.nOffset;
+    }
+
+    // 发送数据：没有积压时直接写，写不下的部分追加到输出缓冲区；连接出错返回 false
+    static bool Send(int fd, const char *pData, size_t nLen) {
+        COutput *pOutput = Find(fd);
+        if (pOutput == NULL) {
+            return WriteAll(fd, pData, nLen);
+        }
+
+        // 已有积压时只能追加，保证数据按顺序发出
+        while (nLen > 0 && pOutput->nOffset == pOutput->strData.size()) {
+            ssize_t n = ::write(fd, pData, nLen);
+            if (n > 0) {
+                pData += n;
+                nLen -= n;
+                s_pCurrent->CountWritten(n);
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                return false;
+            }
+        }
+        if (nLen == 0) {
+            return true;
+        }
+        pOutput->strData.append(pData, nLen);
+        return s_pCurrent->UpdateWriteInterest(fd, *pOutput);
+    }
+
+    // 连接是否由当前线程的事件循环管理；不是时 Send 会等待到全部写出，调用方也可以自行等待可写
+    static bool IsAttached(int fd) {
+        return Find(fd) != NULL;
+    }
+
+    // 连接是否有尚未写出的数据；此时不能绕过输出缓冲区直接写套接字（splice、MSG_ZEROCOPY 等）
+    static bool HasPending(int fd) {
+        COutput *pOutput = Find(fd);
+        return pOutput != NULL && pOutput->nOffset < pOutput->strData.size();
+    }
+
+    // 积压是否已超过上限：返回 true 时业务类应停止读取并返回 true，积压写出后连接切面会再次调用它
+    static bool IsBacklogged(int fd) {
+        COutput *pOutput = Find(fd);
+        return pOutput != NULL && pOutput->strData.size() - pOutput->nOffset >= SEND_QUEUE_LIMIT;
+    }
+
+private:
+    struct COutput {
+        std::string strData; // 套接字暂时写不下的数据
+        size_t nOffset;      // strData 中已经写出的字节数
+        bool bWriteArmed;    // 是否已注册 EPOLLOUT
+    };
+
+    static COutput *Find(int fd) {
+        if (s_pCurrent == NULL) {
+            return NULL;
+        }
+        auto it = s_pCurrent->m_mapOutputs.find(fd);
+        return it == s_pCurrent->m_mapOutputs.end() ? NULL : &it->second;
+    }
+
+    void CountWritten(ssize_t n) {
+        if (m_pBytesWritten != NULL) {
+            m_pBytesWritten->fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    // 根据连接是否有积压数据注册或取消 EPOLLOUT
+    bool UpdateWriteInterest(int fd, COutput &output) {
+        bool bWantWrite = output.nOffset < output.strData.size();
+        if (bWantWrite == output.bWriteArmed || m_nEpoll == -1) {
+            return true;
+        }
+        epoll_event ev;
+        ev.events = m_nEvents | (bWantWrite ? (uint32_t)EPOLLOUT : 0u);
+        ev.data.fd = fd;
+        if (::epoll_ctl(m_nEpoll, EPOLL_CTL_MOD, fd, &ev) == -1) {
+            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+            return false;
+        }
+        output.bWriteArmed = bWantWrite;
+        return true;
+    }
+
+    // 不在事件循环中时完整写出，非阻塞套接字发送缓冲区满时用 poll 等待可写
+    static bool WriteAll(int fd, const char *pData, size_t nLen) {
+        while (nLen > 0) {
+            ssize_t n = ::write(fd, pData, nLen);
+            if (n > 0) {
+                pData += n;
+                nLen -= n;
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd pfd = {fd, POLLOUT, 0};
+                ::poll(&pfd, 1, -1);
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    int m_nEpoll;
+    uint32_t m_nEvents;
+    std::atomic<uint64_t> *m_pBytesWritten;
+    bool m_bActive;          // 构造时是否已成为当前线程的实例
+    CSendQueue *m_pPrevious; // 同一线程上嵌套创建时恢复外层实例
+    std::unordered_map<int, COutput> m_mapOutputs;
+
+    // 当前线程上正在运行的事件循环的输出缓冲区
+    static thread_local CSendQueue *s_pCurrent;
+};
+
+inline thread_local CSendQueue *CSendQueue::s_pCurrent = NULL;
@@ -4,33 +4,83 @@
  * 功能: 封装TCP服务端通信库，并实现Echo服务器
  *************************************************************************/
 #include <arpa/inet.h>
-#include <cassert>
 #include <cerrno>
+#include <csignal>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <memory.h>
 #include <netinet/in.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
 #include <unistd.h>
+#include <unordered_map>
+
+#include "../common/CSendQueue.hpp"
 
 // 定义最大缓冲区大小
 #define MAX_BUFFER_SIZE 1024
 // 定义默认端口
 #define DEFAULT_PORT 5000
+// 单次 epoll_wait 最多取回的事件数
+#define MAX_EPOLL_EVENTS 256
 
 // 定义回调函数指针类型，用于处理具体的业务逻辑
+// 回调在套接字“可读”时被调用：必须把数据读到 EAGAIN 为止（边沿触发），
+// 或者在 IsSendBacklogged 返回 true 时提前返回，积压写出后通信库会再次调用回调
+// 回复数据通过 SendData 发送，事件循环中不会阻塞
 // nConnectedSocket: 已连接的套接字描述符
 // clientIP: 客户端IP地址字符串
-typedef void (*TCPServerCallback)(int nConnectedSocket, const char *clientIP);
+// 返回值: true 保持连接，false 由通信库关闭连接
+typedef bool (*TCPServerCallback)(int nConnectedSocket, const char *clientIP);
+
+// 事件循环中每个已连接套接字的状态
+// 待发送数据的输出缓冲区由 CSendQueue 管理
+struct CONNECTION_STATE {
+    std::string strClientIP;
+    bool bReadPaused; // 积压超过上限，回调已暂停读取
+    bool bClosing;    // 回调已要求关闭，写完积压数据后再关闭
+};
 
 /**
- * @brief 封装TCP服务端初始化及运行逻辑
- * @param ServerFunction 用户自定义的业务逻辑回调函数
+ * @brief 将套接字设置为非阻塞模式
+ * @return bool 成功返回true
+ */
+bool SetNonBlocking(int nSocket) {
+    int nFlags = ::fcntl(nSocket, F_GETFL, 0);
+    if (-1 == nFlags) {
+        return false;
+    }
+    return ::fcntl(nSocket, F_SETFL, nFlags | O_NONBLOCK) != -1;
+}
+
+/**
+ * @brief 发送数据，供回调函数使用
+ * 事件循环中不阻塞：套接字写不下的部分追加到连接的输出缓冲区，注册 EPOLLOUT 后由事件循环继续发送
+ * 阻塞模式下（连接不在事件循环中）完整写出
+ * @return bool 连接出错返回false
+ */
+bool SendData(int nSocket, const char *pBuf, size_t nLen) {
+    return CSendQueue::Send(nSocket, pBuf, nLen);
+}
+
+/**
+ * @brief 连接积压的待发送数据是否已超过上限
+ * 返回true时回调应停止读取并返回true，积压写出后通信库会再次调用回调
+ */
+bool IsSendBacklogged(int nSocket) {
+    return CSendQueue::IsBacklogged(nSocket);
+}
+
+/**
+ * @brief 创建、绑定并监听TCP套接字
  * @param nPort 监听端口号
- * @param nLengthOfQueueOfListen 监听队列最大长度，默认100
+ * @param nLengthOfQueueOfListen 监听队列最大长度
  * @param strBoundIP 绑定的IP地址，NULL表示绑定所有本地IP (INADDR_ANY)
- * @return int 成功返回0，失败返回-1
+ * @return int 成功返回监听套接字，失败返回-1
  */
-int RunTCPServer(TCPServerCallback ServerFunction, int nPort, int nLengthOfQueueOfListen = 100, const char *strBoundIP = NULL) {
+int CreateListenSocket(int nPort, int nLengthOfQueueOfListen, const char *strBoundIP) {
     // 1. 创建套接字 (Socket)
     // AF_INET: IPv4协议, SOCK_STREAM: TCP流式传输
     int nListenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
@@ -74,6 +124,23 @@ int RunTCPServer(TCPServerCallback ServerFunction, int nPort, int nLengthOfQueue
     }
 
     std::cout << "[Server] Listening on port " << nPort << "..." << std::endl;
+    return nListenSocket;
+}
+
+/**
+ * @brief 封装TCP服务端初始化及运行逻辑（阻塞兼容模式）
+ * 一次只服务一个客户端，直到该客户端断开才接受下一个连接
+ * @param ServerFunction 用户自定义的业务逻辑回调函数
+ * @param nPort 监听端口号
+ * @param nLengthOfQueueOfListen 监听队列最大长度，默认100
+ * @param strBoundIP 绑定的IP地址，NULL表示绑定所有本地IP (INADDR_ANY)
+ * @return int 成功返回0，失败返回-1
+ */
+int RunTCPServer(TCPServerCallback ServerFunction, int nPort, int nLengthOfQueueOfListen = 100, const char *strBoundIP = NULL) {
+    int nListenSocket = CreateListenSocket(nPort, nLengthOfQueueOfListen, strBoundIP);
+    if (-1 == nListenSocket) {
+        return -1;
+    }
 
     // 5. 循环接受客户端连接 (Accept Loop)
     while (true) {
@@ -92,11 +159,16 @@ int RunTCPServer(TCPServerCallback ServerFunction, int nPort, int nLengthOfQueue
         char clientIP[INET_ADDRSTRLEN];
         inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
 
+        std::cout << "[Server] Client connected from: " << clientIP << std::endl;
+
         // 6. 调用回调函数处理业务逻辑
-        ServerFunction(nConnectedSocket, clientIP);
+        // 阻塞套接字上 read 不会返回 EAGAIN，回调一直处理到连接结束
+        while (ServerFunction(nConnectedSocket, clientIP)) {
+        }
 
         // 7. 处理完毕，关闭已连接套接字
         ::close(nConnectedSocket);
+        std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
     }
 
     // 关闭监听套接字 (实际上在这个无限循环中很难执行到这里)
@@ -104,16 +176,162 @@ int RunTCPServer(TCPServerCallback ServerFunction, int nPort, int nLengthOfQueue
     return 0;
 }
 
+/**
+ * @brief 基于 epoll 的事件循环（Reactor），单线程同时服务大量连接
+ * 监听套接字与已连接套接字均为非阻塞、边沿触发 (EPOLLET)
+ * 每当已连接套接字可读时调用一次 ServerFunction；回复写不完时注册 EPOLLOUT，
+ * 可写时继续发送，事件循环从不阻塞在单个连接上
+ * @param ServerFunction 用户自定义的业务逻辑回调函数
+ * @param nPort 监听端口号
+ * @param nLengthOfQueueOfListen 监听队列最大长度，默认100
+ * @param strBoundIP 绑定的IP地址，NULL表示绑定所有本地IP (INADDR_ANY)
+ * @return int 成功返回0，失败返回-1
+ */
+int RunTCPServerEventLoop(TCPServerCallback ServerFunction, int nPort, int nLengthOfQueueOfListen = 100, const char *strBoundIP = NULL) {
+    // 忽略 SIGPIPE，对端异常断开时 write 返回错误而不是终止进程
+    signal(SIGPIPE, SIG_IGN);
+
+    // 将文件描述符软限制提升到硬限制，以支持上千个并发连接
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int nListenSocket = CreateListenSocket(nPort, nLengthOfQueueOfListen, strBoundIP);
+    if (-1 == nListenSocket) {
+        return -1;
+    }
+    SetNonBlocking(nListenSocket);
+
+    // 1. 创建 epoll 实例并注册监听套接字
+    int nEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == nEpoll) {
+        std::cerr << "[Error] epoll_create1 failed: " << strerror(errno) << std::endl;
+        ::close(nListenSocket);
+        return -1;
+    }
+
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = nListenSocket;
+    if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nListenSocket, &ev) == -1) {
+        std::cerr << "[Error] epoll_ctl failed: " << strerror(errno) << std::endl;
+        ::close(nEpoll);
+        ::close(nListenSocket);
+        return -1;
+    }
+
+    // 连接的输出缓冲区与事件循环同生命周期，回调中的 SendData 通过它排队
+    // 连接表记录客户端IP与读写状态（单线程访问）
+    CSendQueue sendQueue(nEpoll, EPOLLIN | EPOLLRDHUP | EPOLLET);
+    std::unordered_map<int, CONNECTION_STATE> mapConnections;
+    epoll_event events[MAX_EPOLL_EVENTS];
+
+    // 2. 事件循环
+    while (true) {
+        int nReady = ::epoll_wait(nEpoll, events, MAX_EPOLL_EVENTS, -1);
+        if (-1 == nReady) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[Error] epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < nReady; i++) {
+            int fd = events[i].data.fd;
+
+            // 3. 新连接：边沿触发下必须 accept 到 EAGAIN 为止
+            if (fd == nListenSocket) {
+                while (true) {
+                    sockaddr_in ClientAddress;
+                    socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+                    int nConnectedSocket = ::accept4(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (-1 == nConnectedSocket) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                            std::cerr << "[Error] Accept failed: " << strerror(errno) << std::endl;
+                        }
+                        break;
+                    }
+
+                    char clientIP[INET_ADDRSTRLEN];
+                    inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+
+                    epoll_event evConn;
+                    evConn.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+                    evConn.data.fd = nConnectedSocket;
+                    if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nConnectedSocket, &evConn) == -1) {
+                        std::cerr << "[Error] epoll_ctl failed: " << strerror(errno) << std::endl;
+                        ::close(nConnectedSocket);
+                        continue;
+                    }
+                    // 记录每个连接的客户端IP，并为其创建输出缓冲区
+                    CONNECTION_STATE &state = mapConnections[nConnectedSocket];
+                    state.strClientIP = clientIP;
+                    state.bReadPaused = false;
+                    state.bClosing = false;
+                    sendQueue.AddConnection(nConnectedSocket);
+                    std::cout << "[Server] Client connected from: " << clientIP << std::endl;
+                }
+                continue;
+            }
+
+            auto it = mapConnections.find(fd);
+            if (it == mapConnections.end()) {
+                continue;
+            }
+            CONNECTION_STATE &state = it->second;
+            bool bKeepAlive = !(events[i].events & EPOLLERR);
+
+            // 4. 可写：先写出积压的数据
+            if (bKeepAlive && (events[i].events & EPOLLOUT)) {
+                bKeepAlive = sendQueue.Flush(fd);
+            }
+
+            // 5. 可读（或对端关闭），或积压刚降到上限以下：调用回调处理业务逻辑
+            // 暂停期间未读的数据还在接收缓冲区中，边沿触发不会再通知，需要主动恢复读取
+            bool bReadable = (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0;
+            bool bResume = state.bReadPaused && !IsSendBacklogged(fd);
+            if (bKeepAlive && !state.bClosing && (bReadable || bResume)) {
+                bKeepAlive = ServerFunction(fd, state.strClientIP.c_str());
+                state.bReadPaused = bKeepAlive && IsSendBacklogged(fd);
+
+                // 回调要求关闭但还有积压数据：先写完再关闭，写出失败则立即关闭
+                if (!bKeepAlive && sendQueue.GetPendingSize(fd) > 0) {
+                    state.bClosing = true;
+                    bKeepAlive = sendQueue.Flush(fd);
+                }
+            }
+
+            // 6. 连接出错、回调要求关闭且积压已写完：close 会自动把 fd 从 epoll 中移除
+            if (!bKeepAlive || (state.bClosing && sendQueue.GetPendingSize(fd) == 0)) {
+                std::cout << "[Server] Client disconnected: " << state.strClientIP << std::endl;
+                sendQueue.RemoveConnection(fd);
+                mapConnections.erase(it);
+                ::close(fd);
+            }
+        }
+    }
+
+    ::close(nEpoll);
+    ::close(nListenSocket);
+    return 0;
+}
+
 /**
  * @brief 用户自定义的业务逻辑：Echo服务
  * 接收客户端发送的数据，打印并原样发回
+ * 读到 EAGAIN 说明本次数据已取完，返回 true 等待下一次可读事件
+ * 对端只发不收导致回复积压过多时暂停读取，剩余数据留在接收缓冲区，由 TCP 流控限制对端继续发送
  */
-void MyEchoServer(int nConnectedSocket, const char *clientIP) {
-    std::cout << "[Server] Client connected from: " << clientIP << std::endl;
-
+bool MyEchoServer(int nConnectedSocket, const char *clientIP) {
     char buf[MAX_BUFFER_SIZE];
 
-    while (true) {
+    while (!IsSendBacklogged(nConnectedSocket)) {
         memset(buf, 0, MAX_BUFFER_SIZE);
         // 读取数据
         ssize_t bytesRead = ::read(nConnectedSocket, buf, MAX_BUFFER_SIZE - 1);
@@ -121,22 +339,33 @@ void MyEchoServer(int nConnectedSocket, const char *clientIP) {
         if (bytesRead > 0) {
             std::cout << "[Recv from " << clientIP << "]: " << buf;
             // Echo回写数据
-            ssize_t bytesWrite = ::write(nConnectedSocket, buf, bytesRead);
-            assert(bytesRead == bytesWrite);
+            if (!SendData(nConnectedSocket, buf, bytesRead)) {
+                std::cerr << "[Error] Write error." << std::endl;
+                return false;
+            }
         } else if (bytesRead == 0) {
             // read返回0表示对端关闭连接
-            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
-            break;
+            return false;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // 非阻塞套接字上的数据已读完
+            return true;
+        } else if (errno == EINTR) {
+            continue;
         } else {
             std::cerr << "[Error] Read error." << std::endl;
-            break;
+            return false;
         }
     }
+    return true;
 }
 
-int main() {
+int main(int argc, char **argv) {
     // 启动服务器，使用端口5000
-    // 删除了原代码中导致死循环的 while(true) {}
-    RunTCPServer(MyEchoServer, DEFAULT_PORT);
+    // 默认使用 epoll 事件循环；传入 "block" 参数时使用原有的阻塞模式
+    if (argc > 1 && strcmp(argv[1], "block") == 0) {
+        RunTCPServer(MyEchoServer, DEFAULT_PORT);
+    } else {
+        RunTCPServerEventLoop(MyEchoServer, DEFAULT_PORT);
+    }
     return 0;
 }
\ No newline at end of file
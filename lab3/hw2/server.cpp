@@ -4,15 +4,23 @@
  * 功能: 封装TCP服务端类，通过继承和多态实现Echo服务器
  *************************************************************************/
 #include <arpa/inet.h>
-#include <cassert>
+#include <cerrno>
+#include <csignal>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <netinet/in.h>
 #include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
 #include <unistd.h>
+#include <unordered_map>
+
+#include "../common/CSendQueue.hpp"
 
 #define MAX_BUFFER_SIZE 1024
 #define DEFAULT_PORT 5000
+#define MAX_EPOLL_EVENTS 256
 
 // 基类：CTCPServer
 // 负责底层的Socket创建、绑定、监听和连接接受
@@ -36,8 +44,205 @@ public:
     }
 
 public:
-    // 核心运行逻辑
+    // 核心运行逻辑（阻塞兼容模式）：一次只服务一个客户端
     int Run() {
+        int nListenSocket = CreateListenSocket();
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+
+        // 5. 循环处理客户端连接
+        while (true) {
+            sockaddr_in ClientAddress;
+            socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+
+            // 阻塞等待连接
+            int nConnectedSocket = ::accept(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress);
+            if (-1 == nConnectedSocket) {
+                std::cerr << "[Error] accept error" << std::endl;
+                continue; // 继续等待下一个连接
+            }
+
+            // 打印客户端信息
+            char clientIP[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+            std::cout << "[Server] Client connected: " << clientIP << std::endl;
+
+            // 6. 多态调用：调用派生类实现的具体业务逻辑
+            // 阻塞套接字上 read 不会返回 EAGAIN，ServerFunction 一直处理到连接结束
+            while (ServerFunction(nConnectedSocket, nListenSocket)) {
+            }
+
+            // 业务处理完毕，关闭连接
+            ::close(nConnectedSocket);
+            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
+        }
+
+        ::close(nListenSocket);
+        return 0;
+    }
+
+    // 基于 epoll 的事件循环（Reactor）：单线程同时服务大量连接
+    // 套接字均为非阻塞、边沿触发，每次可读事件多态调用一次 ServerFunction
+    // 回复写不完时暂存在连接的输出缓冲区并注册 EPOLLOUT，事件循环从不阻塞在单个连接上
+    int RunEventLoop() {
+        // 忽略 SIGPIPE，对端异常断开时 write 返回错误而不是终止进程
+        signal(SIGPIPE, SIG_IGN);
+
+        // 将文件描述符软限制提升到硬限制，以支持上千个并发连接
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+
+        int nListenSocket = CreateListenSocket();
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+        SetNonBlocking(nListenSocket);
+
+        // 1. 创建 epoll 实例并注册监听套接字
+        int nEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+        if (-1 == nEpoll) {
+            std::cerr << "[Error] epoll_create1 error: " << strerror(errno) << std::endl;
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = nListenSocket;
+        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nListenSocket, &ev) == -1) {
+            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+            ::close(nEpoll);
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        // 连接的输出缓冲区与事件循环同生命周期，ServerFunction 中的 Send 通过它排队
+        CSendQueue sendQueue(nEpoll, EPOLLIN | EPOLLRDHUP | EPOLLET);
+        epoll_event events[MAX_EPOLL_EVENTS];
+
+        // 2. 事件循环
+        while (true) {
+            int nReady = ::epoll_wait(nEpoll, events, MAX_EPOLL_EVENTS, -1);
+            if (-1 == nReady) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "[Error] epoll_wait error: " << strerror(errno) << std::endl;
+                break;
+            }
+
+            for (int i = 0; i < nReady; i++) {
+                int fd = events[i].data.fd;
+
+                // 3. 新连接：边沿触发下必须 accept 到 EAGAIN 为止
+                if (fd == nListenSocket) {
+                    while (true) {
+                        sockaddr_in ClientAddress;
+                        socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+                        int nConnectedSocket = ::accept4(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                        if (-1 == nConnectedSocket) {
+                            if (errno == EINTR) {
+                                continue;
+                            }
+                            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                                std::cerr << "[Error] accept error: " << strerror(errno) << std::endl;
+                            }
+                            break;
+                        }
+
+                        char clientIP[INET_ADDRSTRLEN];
+                        inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+
+                        epoll_event evConn;
+                        evConn.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+                        evConn.data.fd = nConnectedSocket;
+                        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nConnectedSocket, &evConn) == -1) {
+                            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+                            ::close(nConnectedSocket);
+                            continue;
+                        }
+                        CConnection &conn = m_mapConnections[nConnectedSocket];
+                        conn.strClientIP = clientIP;
+                        conn.bReadPaused = false;
+                        conn.bClosing = false;
+                        sendQueue.AddConnection(nConnectedSocket);
+                        std::cout << "[Server] Client connected: " << clientIP << std::endl;
+                    }
+                    continue;
+                }
+
+                auto it = m_mapConnections.find(fd);
+                if (it == m_mapConnections.end()) {
+                    continue;
+                }
+                CConnection &conn = it->second;
+                bool bKeepAlive = !(events[i].events & EPOLLERR);
+
+                // 4. 可写：先写出积压的数据
+                if (bKeepAlive && (events[i].events & EPOLLOUT)) {
+                    bKeepAlive = sendQueue.Flush(fd);
+                }
+
+                // 5. 可读（或对端关闭），或积压刚降到上限以下：多态调用业务逻辑
+                // 暂停期间未读的数据还在接收缓冲区中，边沿触发不会再通知，需要主动恢复读取
+                bool bReadable = (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0;
+                bool bResume = conn.bReadPaused && !IsSendBacklogged(fd);
+                if (bKeepAlive && !conn.bClosing && (bReadable || bResume)) {
+                    bKeepAlive = ServerFunction(fd, nListenSocket);
+                    conn.bReadPaused = bKeepAlive && IsSendBacklogged(fd);
+
+                    // 业务要求关闭但还有积压数据：先写完再关闭，写出失败则立即关闭
+                    if (!bKeepAlive && sendQueue.GetPendingSize(fd) > 0) {
+                        conn.bClosing = true;
+                        bKeepAlive = sendQueue.Flush(fd);
+                    }
+                }
+
+                // 6. 连接出错、业务要求关闭且积压已写完：close 会自动把 fd 从 epoll 中移除
+                if (!bKeepAlive || (conn.bClosing && sendQueue.GetPendingSize(fd) == 0)) {
+                    std::cout << "[Server] Client disconnected: " << conn.strClientIP << std::endl;
+                    sendQueue.RemoveConnection(fd);
+                    m_mapConnections.erase(it);
+                    ::close(fd);
+                }
+            }
+        }
+
+        m_mapConnections.clear();
+        ::close(nEpoll);
+        ::close(nListenSocket);
+        return 0;
+    }
+
+protected:
+    // 发送数据，供派生类的 ServerFunction 使用
+    // 事件循环中不阻塞：套接字写不下的部分追加到连接的输出缓冲区，注册 EPOLLOUT 后由事件循环继续发送
+    // 阻塞模式下（连接不在事件循环中）完整写出；连接出错返回 false
+    bool Send(int nSocket, const char *pBuf, size_t nLen) {
+        return CSendQueue::Send(nSocket, pBuf, nLen);
+    }
+
+    // 连接积压的待发送数据是否已超过上限
+    // 返回 true 时 ServerFunction 应停止读取并返回 true，积压写出后基类会再次调用它
+    bool IsSendBacklogged(int nSocket) const {
+        return CSendQueue::IsBacklogged(nSocket);
+    }
+
+private:
+    // 事件循环中每个已连接套接字的状态
+    // 待发送数据的输出缓冲区由 CSendQueue 管理
+    struct CConnection {
+        std::string strClientIP;
+        bool bReadPaused; // 积压超过上限，ServerFunction 已暂停读取
+        bool bClosing;    // 业务已要求关闭，写完积压数据后再关闭
+    };
+
+    // 创建、绑定并监听套接字，失败返回 -1
+    int CreateListenSocket() {
         // 1. 创建监听套接字
         int nListenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
         if (-1 == nListenSocket) {
@@ -78,47 +283,33 @@ public:
         }
 
         std::cout << "[Server] Listening on port " << m_nServerPort << "..." << std::endl;
+        return nListenSocket;
+    }
 
-        // 5. 循环处理客户端连接
-        while (true) {
-            sockaddr_in ClientAddress;
-            socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
-
-            // 阻塞等待连接
-            int nConnectedSocket = ::accept(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress);
-            if (-1 == nConnectedSocket) {
-                std::cerr << "[Error] accept error" << std::endl;
-                continue; // 继续等待下一个连接
-            }
-
-            // 打印客户端信息
-            char clientIP[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
-            std::cout << "[Server] Client connected: " << clientIP << std::endl;
-
-            // 6. 多态调用：调用派生类实现的具体业务逻辑
-            ServerFunction(nConnectedSocket, nListenSocket);
-
-            // 业务处理完毕，关闭连接
-            ::close(nConnectedSocket);
-            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
+    static bool SetNonBlocking(int nSocket) {
+        int nFlags = ::fcntl(nSocket, F_GETFL, 0);
+        if (-1 == nFlags) {
+            return false;
         }
-
-        ::close(nListenSocket);
-        return 0;
+        return ::fcntl(nSocket, F_SETFL, nFlags | O_NONBLOCK) != -1;
     }
 
-private:
     // 纯虚函数或虚函数：由派生类实现具体业务
     // 对应 PPT 中 3.14 节的类图结构
-    virtual void ServerFunction(int nConnectedSocket, int nListenSocket) {
+    // 每次套接字可读时被调用，需把数据读到 EAGAIN 为止，或在 IsSendBacklogged 返回 true 时提前返回
+    // 返回 true 保持连接，返回 false 由基类关闭连接
+    virtual bool ServerFunction(int nConnectedSocket, int nListenSocket) {
         // 基类中不做具体处理
+        return false;
     }
 
 private:
     int m_nServerPort;
     std::string m_strBoundIP; // 使用 string 替代 char*
     int m_nLengthOfQueueOfListen;
+
+    // 事件循环中的连接表，阻塞模式下为空
+    std::unordered_map<int, CConnection> m_mapConnections;
 };
 
 // 派生类：CMyTCPServer
@@ -134,10 +325,11 @@ public:
 
 private:
     // 重写父类的虚函数，实现 Echo 服务逻辑
-    virtual void ServerFunction(int nConnectedSocket, int nListenSocket) {
+    // 对端只发不收导致回复积压过多时暂停读取，剩余数据留在接收缓冲区，由 TCP 流控限制对端继续发送
+    virtual bool ServerFunction(int nConnectedSocket, int nListenSocket) {
         char buf[MAX_BUFFER_SIZE];
 
-        while (true) {
+        while (!IsSendBacklogged(nConnectedSocket)) {
             memset(buf, 0, MAX_BUFFER_SIZE);
             // 读取客户端数据
             ssize_t bytesRead = ::read(nConnectedSocket, buf, MAX_BUFFER_SIZE - 1);
@@ -145,23 +337,36 @@ private:
             if (bytesRead > 0) {
                 std::cout << "[Recv]: " << buf;
                 // 将接收到的数据原样发回 (Echo)
-                ssize_t bytesWrite = ::write(nConnectedSocket, buf, bytesRead);
-                assert(bytesRead == bytesWrite);
+                if (!Send(nConnectedSocket, buf, bytesRead)) {
+                    std::cerr << "[Error] write error" << std::endl;
+                    return false;
+                }
             } else if (bytesRead == 0) {
                 // 客户端关闭连接
-                break;
+                return false;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 本次可读事件的数据已取完
+                return true;
+            } else if (errno == EINTR) {
+                continue;
             } else {
                 std::cerr << "[Error] read error" << std::endl;
-                break;
+                return false;
             }
         }
+        return true;
     }
 };
 
-int main() {
+int main(int argc, char **argv) {
     // 实例化派生类对象
     CMyTCPServer myserver(5000);
     // 调用基类的 Run 方法，Run 方法内部会多态调用 ServerFunction
-    myserver.Run();
+    // 默认使用 epoll 事件循环；传入 "block" 参数时使用原有的阻塞模式
+    if (argc > 1 && strcmp(argv[1], "block") == 0) {
+        myserver.Run();
+    } else {
+        myserver.RunEventLoop();
+    }
     return 0;
-}
\ No newline at end of file
+}
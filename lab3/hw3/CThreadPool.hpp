@@ -0,0 +1,198 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CThreadPool.hpp
+ * 功能: 有界的工作窃取 (work-stealing) 线程池
+ *       每个工作线程拥有自己的任务队列，空闲时从其他线程的队列尾部窃取任务；
+ *       排队任务总数受 nQueueDepth 限制，队列满时按背压策略处理
+ *************************************************************************/
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 队列满时的背压策略
+enum EBackpressurePolicy {
+    BACKPRESSURE_BLOCK,  // 阻塞提交者，直到有空位（服务端表现为暂停 accept，由内核监听队列缓冲）
+    BACKPRESSURE_REJECT, // 立即拒绝，由提交者处理（服务端表现为直接关闭新连接）
+    BACKPRESSURE_GROW    // 扩充一个工作线程后继续入队，达到线程上限后退化为 BLOCK
+};
+
+class CThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    // nThreads: 初始工作线程数
+    // nQueueDepth: 所有队列中等待执行的任务总数上限
+    // nMaxThreads: GROW 策略下的线程数上限，小于 nThreads 时取 nThreads
+    CThreadPool(int nThreads, size_t nQueueDepth, EBackpressurePolicy policy = BACKPRESSURE_BLOCK, int nMaxThreads = 0) {
+        if (nThreads < 1) {
+            nThreads = 1;
+        }
+        if (nMaxThreads < nThreads) {
+            nMaxThreads = nThreads;
+        }
+        m_nQueueDepth = nQueueDepth > 0 ? nQueueDepth : 1;
+        m_policy = policy;
+        m_nMaxThreads = nMaxThreads;
+        m_nQueued = 0;
+        m_nThreads = 0;
+        m_nNextQueue = 0;
+        m_bStop = false;
+
+        // 预先分配到线程上限，扩容时不必移动已有队列
+        for (int i = 0; i < m_nMaxThreads; i++) {
+            m_vQueues.push_back(std::unique_ptr<CWorkerQueue>(new CWorkerQueue));
+        }
+        for (int i = 0; i < nThreads; i++) {
+            AddWorker();
+        }
+    }
+
+    // 析构时等待已排队的任务执行完毕
+    virtual ~CThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mtxWait);
+            m_bStop = true;
+        }
+        m_cvWork.notify_all();
+        m_cvSpace.notify_all();
+
+        std::lock_guard<std::mutex> lock(m_mtxThreads);
+        for (auto &worker : m_vThreads) {
+            worker.join();
+        }
+    }
+
+public:
+    // 提交任务，被拒绝（REJECT 策略且队列已满）或线程池已停止时返回 false
+    bool Submit(Task task) {
+        {
+            // 在等待锁内检查容量并占位：先计数再入队，工作线程取走任务后的递减不会早于这里的递增
+            std::unique_lock<std::mutex> lock(m_mtxWait);
+            while (!m_bStop && m_nQueued.load() >= m_nQueueDepth) {
+                if (m_policy == BACKPRESSURE_REJECT) {
+                    return false;
+                }
+                if (m_policy == BACKPRESSURE_GROW && m_nThreads.load() < m_nMaxThreads) {
+                    // 扩充线程后直接入队，新线程会取走多出的任务
+                    lock.unlock();
+                    AddWorker();
+                    lock.lock();
+                    break;
+                }
+                m_cvSpace.wait(lock);
+            }
+            if (m_bStop) {
+                return false;
+            }
+            m_nQueued++;
+        }
+
+        // 轮询选择目标队列，分散到各工作线程
+        int nIndex = (int)(m_nNextQueue.fetch_add(1) % (unsigned)m_nThreads.load());
+        try {
+            std::lock_guard<std::mutex> lock(m_vQueues[nIndex]->mtx);
+            m_vQueues[nIndex]->dqTasks.push_back(std::move(task));
+        } catch (...) {
+            // 入队失败（内存不足）：归还占用的名额
+            {
+                std::lock_guard<std::mutex> lock(m_mtxWait);
+                m_nQueued--;
+            }
+            m_cvSpace.notify_one();
+            return false;
+        }
+        m_cvWork.notify_one();
+        return true;
+    }
+
+    int GetThreadCount() const {
+        return m_nThreads.load();
+    }
+
+    size_t GetQueuedCount() const {
+        return m_nQueued.load();
+    }
+
+private:
+    struct CWorkerQueue {
+        std::mutex mtx;
+        std::deque<Task> dqTasks;
+    };
+
+    void AddWorker() {
+        std::lock_guard<std::mutex> lock(m_mtxThreads);
+        int nIndex = m_nThreads.load();
+        if (nIndex >= m_nMaxThreads) {
+            return;
+        }
+        m_vThreads.emplace_back(&CThreadPool::WorkerLoop, this, nIndex);
+        m_nThreads++;
+    }
+
+    // 先从自己队列的头部取任务（先来先服务），再从其他队列的尾部窃取
+    bool TryPop(int nIndex, Task &task) {
+        int nThreads = m_nThreads.load();
+        for (int i = 0; i < nThreads; i++) {
+            CWorkerQueue &queue = *m_vQueues[(nIndex + i) % nThreads];
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            if (queue.dqTasks.empty()) {
+                continue;
+            }
+            if (i == 0) {
+                task = std::move(queue.dqTasks.front());
+                queue.dqTasks.pop_front();
+            } else {
+                task = std::move(queue.dqTasks.back());
+                queue.dqTasks.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void WorkerLoop(int nIndex) {
+        while (true) {
+            Task task;
+            if (TryPop(nIndex, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mtxWait);
+                    m_nQueued--;
+                }
+                m_cvSpace.notify_one();
+                task();
+                continue;
+            }
+
+            // 没有可执行的任务：等待新任务或停止信号
+            std::unique_lock<std::mutex> lock(m_mtxWait);
+            m_cvWork.wait(lock, [this]() { return m_bStop || m_nQueued.load() > 0; });
+            if (m_bStop && m_nQueued.load() == 0) {
+                break;
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<CWorkerQueue>> m_vQueues;
+    std::vector<std::thread> m_vThreads;
+    std::mutex m_mtxThreads; // 保护 m_vThreads
+
+    std::mutex m_mtxWait;
+    std::condition_variable m_cvWork;  // 有新任务
+    std::condition_variable m_cvSpace; // 队列出现空位
+
+    std::atomic<size_t> m_nQueued;       // 所有队列中等待执行的任务数
+    std::atomic<int> m_nThreads;         // 当前工作线程数
+    std::atomic<unsigned> m_nNextQueue;  // 轮询提交位置
+    std::atomic<bool> m_bStop;
+
+    size_t m_nQueueDepth;
+    EBackpressurePolicy m_policy;
+    int m_nMaxThreads;
+};
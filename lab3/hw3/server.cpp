@@ -4,15 +4,28 @@
  * 功能: 封装TCP服务端通信库，通过Observer接口分离业务逻辑，实现Echo服务
  *************************************************************************/
 #include <arpa/inet.h>
-#include <cassert>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <netinet/in.h>
 #include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
 #include <unistd.h>
+#include <unordered_map>
+
+#include "../common/CSendQueue.hpp"
+#include "CThreadPool.hpp"
 
 #define MAX_BUFFER_SIZE 1024
 #define DEFAULT_PORT 5000
+#define MAX_EPOLL_EVENTS 256
+// 线程池模式下命令行允许的初始线程数上限（GROW 策略最多扩充到其 4 倍）
+#define MAX_POOL_THREADS 256
 
 // -----------------------------------------------------------
 // 1. 定义接口类 (Observer Interface)
@@ -24,8 +37,21 @@ public:
 
 public:
     // 纯虚函数：定义服务端业务逻辑的规范
-    // 当连接建立成功后，通信库会回调此函数
-    virtual void ServerFunction(int nConnectedSocket, int nListenSocket) = 0;
+    // 当已连接套接字可读时，通信库会回调此函数，需把数据读到 EAGAIN 为止，
+    // 或在 IsSendBacklogged 返回 true 时提前返回，积压写出后通信库会再次回调
+    // 返回 true 保持连接，返回 false 由通信库关闭连接
+    virtual bool ServerFunction(int nConnectedSocket, int nListenSocket) = 0;
+
+protected:
+    // 发送回复，事件循环中不阻塞；连接出错返回 false
+    static bool Send(int nSocket, const char *pBuf, size_t nLen) {
+        return CSendQueue::Send(nSocket, pBuf, nLen);
+    }
+
+    // 回复积压是否已超过上限
+    static bool IsSendBacklogged(int nSocket) {
+        return CSendQueue::IsBacklogged(nSocket);
+    }
 };
 
 // -----------------------------------------------------------
@@ -51,8 +77,273 @@ public:
     }
 
 public:
-    // 核心运行逻辑：负责 Socket 的生命周期管理
+    // 核心运行逻辑（阻塞兼容模式）：负责 Socket 的生命周期管理
     int Run() {
+        int nListenSocket = CreateListenSocket();
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+
+        // 5. 循环处理客户端连接
+        while (true) {
+            sockaddr_in ClientAddress;
+            socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+
+            // 阻塞等待连接
+            int nConnectedSocket = ::accept(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress);
+            if (-1 == nConnectedSocket) {
+                std::cerr << "[Error] accept error" << std::endl;
+                continue;
+            }
+
+            // 获取客户端IP用于日志
+            char clientIP[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+            std::cout << "[Server] Client connected: " << clientIP << std::endl;
+
+            // 6. 调用接口方法处理业务
+            // 具体执行的是 CMyTCPServer::ServerFunction
+            // 阻塞套接字上 read 不会返回 EAGAIN，回调一直处理到连接结束
+            if (m_pObserver != NULL) {
+                while (m_pObserver->ServerFunction(nConnectedSocket, nListenSocket)) {
+                }
+            }
+
+            // 业务处理完毕，关闭当前连接
+            ::close(nConnectedSocket);
+            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
+        }
+
+        ::close(nListenSocket);
+        return 0;
+    }
+
+    // 线程池模式：主线程运行非阻塞的 epoll 前端，只负责 accept 和分发就绪事件，
+    // 每个就绪事件提交一个任务，由工作线程读取数据、调用观察者的 ServerFunction 并写回复
+    // 工作线程只在连接有数据时被占用，空闲的长连接不占线程，少量线程即可服务大量长连接
+    // 连接以 EPOLLONESHOT 注册：事件交出后即停止通知，任务结束时重新注册，同一连接同时只在一个线程上处理
+    // 注意：同一观察者对象会被多个工作线程并发回调，其实现必须是线程安全的
+    // nThreads: 初始工作线程数；nQueueDepth: 等待处理的就绪事件数上限
+    // policy: 队列满时的背压策略（BLOCK 暂停分发事件，REJECT 关闭该连接）；nMaxThreads: GROW 策略下的线程数上限
+    int RunThreadPool(int nThreads, size_t nQueueDepth = 64, EBackpressurePolicy policy = BACKPRESSURE_BLOCK, int nMaxThreads = 0) {
+        // 忽略 SIGPIPE，对端异常断开时 write 返回错误而不是终止进程
+        signal(SIGPIPE, SIG_IGN);
+
+        // 将文件描述符软限制提升到硬限制，以支持上千个并发连接
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+
+        int nListenSocket = CreateListenSocket();
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+        SetNonBlocking(nListenSocket);
+
+        int nEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+        if (-1 == nEpoll) {
+            std::cerr << "[Error] epoll_create1 error: " << strerror(errno) << std::endl;
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        // 监听套接字的 data.ptr 为 NULL，已连接套接字的 data.ptr 指向其 CPoolConnection
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.ptr = NULL;
+        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nListenSocket, &ev) == -1) {
+            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+            ::close(nEpoll);
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        CThreadPool pool(nThreads, nQueueDepth, policy, nMaxThreads);
+        std::cout << "[Server] Thread pool started with " << pool.GetThreadCount() << " workers" << std::endl;
+        epoll_event events[MAX_EPOLL_EVENTS];
+
+        while (true) {
+            int nReady = ::epoll_wait(nEpoll, events, MAX_EPOLL_EVENTS, -1);
+            if (-1 == nReady) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "[Error] epoll_wait error: " << strerror(errno) << std::endl;
+                break;
+            }
+
+            for (int i = 0; i < nReady; i++) {
+                CPoolConnection *pConn = static_cast<CPoolConnection *>(events[i].data.ptr);
+
+                // 新连接：边沿触发下必须 accept 到 EAGAIN 为止
+                if (pConn == NULL) {
+                    AcceptPoolConnections(nEpoll, nListenSocket);
+                    continue;
+                }
+
+                // 就绪事件交给线程池；EPOLLONESHOT 下连接此后不再通知，直到任务重新注册
+                uint32_t nEvents = events[i].events;
+                bool bAccepted = pool.Submit([this, pConn, nEvents, nEpoll, nListenSocket]() {
+                    ServePoolEvent(pConn, nEvents, nEpoll, nListenSocket);
+                });
+
+                if (!bAccepted) {
+                    // REJECT 策略下队列已满：关闭该连接
+                    std::cerr << "[Warning] Queue full, dropping client: " << pConn->strClientIP << std::endl;
+                    ::close(pConn->fd);
+                    delete pConn;
+                } else if (pool.GetThreadCount() > nThreads) {
+                    std::cout << "[Server] Pool grown to " << pool.GetThreadCount() << " workers" << std::endl;
+                    nThreads = pool.GetThreadCount();
+                }
+            }
+        }
+
+        ::close(nEpoll);
+        ::close(nListenSocket);
+        return 0;
+    }
+
+    // 基于 epoll 的事件循环（Reactor）：单线程同时服务大量连接
+    // 套接字均为非阻塞、边沿触发，每次可读事件回调一次观察者的 ServerFunction
+    // 回复写不完时注册 EPOLLOUT，可写时继续发送，事件循环从不阻塞在单个连接上
+    int RunEventLoop() {
+        // 忽略 SIGPIPE，对端异常断开时 write 返回错误而不是终止进程
+        signal(SIGPIPE, SIG_IGN);
+
+        // 将文件描述符软限制提升到硬限制，以支持上千个并发连接
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+
+        int nListenSocket = CreateListenSocket();
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+        SetNonBlocking(nListenSocket);
+
+        // 1. 创建 epoll 实例并注册监听套接字
+        int nEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+        if (-1 == nEpoll) {
+            std::cerr << "[Error] epoll_create1 error: " << strerror(errno) << std::endl;
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = nListenSocket;
+        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nListenSocket, &ev) == -1) {
+            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+            ::close(nEpoll);
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        CSendQueue sendQueue(nEpoll, EPOLLIN | EPOLLRDHUP | EPOLLET);
+        std::unordered_map<int, CConnection> mapConnections;
+        epoll_event events[MAX_EPOLL_EVENTS];
+
+        // 2. 事件循环
+        while (true) {
+            int nReady = ::epoll_wait(nEpoll, events, MAX_EPOLL_EVENTS, -1);
+            if (-1 == nReady) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "[Error] epoll_wait error: " << strerror(errno) << std::endl;
+                break;
+            }
+
+            for (int i = 0; i < nReady; i++) {
+                int fd = events[i].data.fd;
+
+                // 3. 新连接：边沿触发下必须 accept 到 EAGAIN 为止
+                if (fd == nListenSocket) {
+                    while (true) {
+                        sockaddr_in ClientAddress;
+                        socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+                        int nConnectedSocket = ::accept4(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                        if (-1 == nConnectedSocket) {
+                            if (errno == EINTR) {
+                                continue;
+                            }
+                            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                                std::cerr << "[Error] accept error: " << strerror(errno) << std::endl;
+                            }
+                            break;
+                        }
+
+                        char clientIP[INET_ADDRSTRLEN];
+                        inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+
+                        epoll_event evConn;
+                        evConn.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+                        evConn.data.fd = nConnectedSocket;
+                        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nConnectedSocket, &evConn) == -1) {
+                            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+                            ::close(nConnectedSocket);
+                            continue;
+                        }
+                        CConnection &conn = mapConnections[nConnectedSocket];
+                        conn.strClientIP = clientIP;
+                        conn.bReadPaused = false;
+                        conn.bClosing = false;
+                        sendQueue.AddConnection(nConnectedSocket);
+                        std::cout << "[Server] Client connected: " << clientIP << std::endl;
+                    }
+                    continue;
+                }
+
+                auto it = mapConnections.find(fd);
+                if (it == mapConnections.end()) {
+                    continue;
+                }
+                CConnection &conn = it->second;
+                bool bKeepAlive = !(events[i].events & EPOLLERR) && m_pObserver != NULL;
+
+                // 4. 可写：先写出积压的回复
+                if (bKeepAlive && (events[i].events & EPOLLOUT)) {
+                    bKeepAlive = sendQueue.Flush(fd);
+                }
+
+                // 5. 可读（或对端关闭），或积压刚降到上限以下：调用接口方法处理业务
+                // 暂停期间未读的数据还在接收缓冲区中，边沿触发不会再通知，需要主动恢复读取
+                bool bReadable = (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0;
+                bool bResume = conn.bReadPaused && !CSendQueue::IsBacklogged(fd);
+                if (bKeepAlive && !conn.bClosing && (bReadable || bResume)) {
+                    bKeepAlive = m_pObserver->ServerFunction(fd, nListenSocket);
+                    conn.bReadPaused = bKeepAlive && CSendQueue::IsBacklogged(fd);
+
+                    // 业务要求关闭但还有积压的回复：先写完再关闭，写出失败则立即关闭
+                    if (!bKeepAlive && sendQueue.GetPendingSize(fd) > 0) {
+                        conn.bClosing = true;
+                        bKeepAlive = sendQueue.Flush(fd);
+                    }
+                }
+
+                // 6. 连接出错、业务要求关闭且积压已写完：close 会自动把 fd 从 epoll 中移除
+                if (!bKeepAlive || (conn.bClosing && sendQueue.GetPendingSize(fd) == 0)) {
+                    std::cout << "[Server] Client disconnected: " << conn.strClientIP << std::endl;
+                    sendQueue.RemoveConnection(fd);
+                    mapConnections.erase(it);
+                    ::close(fd);
+                }
+            }
+        }
+
+        ::close(nEpoll);
+        ::close(nListenSocket);
+        return 0;
+    }
+
+private:
+    // 创建、绑定并监听套接字，失败返回 -1
+    int CreateListenSocket() {
         // 1. 创建监听套接字
         int nListenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
         if (-1 == nListenSocket) {
@@ -93,40 +384,121 @@ public:
         }
 
         std::cout << "[Server] Listening on port " << m_nServerPort << "..." << std::endl;
+        return nListenSocket;
+    }
 
-        // 5. 循环处理客户端连接
+    static bool SetNonBlocking(int nSocket) {
+        int nFlags = ::fcntl(nSocket, F_GETFL, 0);
+        if (-1 == nFlags) {
+            return false;
+        }
+        return ::fcntl(nSocket, F_SETFL, nFlags | O_NONBLOCK) != -1;
+    }
+
+private:
+    // 事件循环中每个已连接套接字的状态
+    struct CConnection {
+        std::string strClientIP;
+        bool bReadPaused; // 积压超过上限，观察者已暂停读取
+        bool bClosing;    // 观察者已要求关闭，写完积压的回复后再关闭
+    };
+
+    // 线程池模式中每个已连接套接字的状态，由处理它的任务独占访问
+    struct CPoolConnection {
+        int fd;
+        std::string strClientIP;
+        CSendQueue sendQueue; // 该连接的输出缓冲区，只在处理它的任务中启用
+        bool bReadPaused;
+        bool bClosing;
+
+        CPoolConnection(int nSocket, const char *clientIP)
+            : fd(nSocket), strClientIP(clientIP), sendQueue(-1, 0, NULL, false), bReadPaused(false), bClosing(false) {
+            sendQueue.AddConnection(fd);
+        }
+    };
+
+    // 线程池模式的连接注册事件
+    static const uint32_t POOL_EVENTS = EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+
+    // 线程池模式：接受全部新连接并以 EPOLLONESHOT 注册
+    void AcceptPoolConnections(int nEpoll, int nListenSocket) {
         while (true) {
             sockaddr_in ClientAddress;
             socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
-
-            // 阻塞等待连接
-            int nConnectedSocket = ::accept(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress);
+            int nConnectedSocket = ::accept4(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress, SOCK_NONBLOCK | SOCK_CLOEXEC);
             if (-1 == nConnectedSocket) {
-                std::cerr << "[Error] accept error" << std::endl;
-                continue;
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    std::cerr << "[Error] accept error: " << strerror(errno) << std::endl;
+                }
+                return;
             }
 
-            // 获取客户端IP用于日志
             char clientIP[INET_ADDRSTRLEN];
             inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+            CPoolConnection *pConn = new CPoolConnection(nConnectedSocket, clientIP);
+
+            epoll_event evConn;
+            evConn.events = POOL_EVENTS;
+            evConn.data.ptr = pConn;
+            if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nConnectedSocket, &evConn) == -1) {
+                std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+                ::close(nConnectedSocket);
+                delete pConn;
+                continue;
+            }
             std::cout << "[Server] Client connected: " << clientIP << std::endl;
+        }
+    }
 
-            // 6. 调用接口方法处理业务
-            // 具体执行的是 CMyTCPServer::ServerFunction
-            if (m_pObserver != NULL) {
-                m_pObserver->ServerFunction(nConnectedSocket, nListenSocket);
+    // 线程池模式：在工作线程上处理一个就绪事件，步骤与 RunEventLoop 相同
+    // 结束时关闭连接，或重新注册事件；重新注册之后其他线程可能立即接手该连接，不能再访问 pConn
+    void ServePoolEvent(CPoolConnection *pConn, uint32_t nEvents, int nEpoll, int nListenSocket) {
+        int fd = pConn->fd;
+        bool bKeepAlive = !(nEvents & EPOLLERR) && m_pObserver != NULL;
+        {
+            CSendQueue::CActivation activation(pConn->sendQueue);
+
+            // 可写：先写出积压的回复
+            if (bKeepAlive && (nEvents & EPOLLOUT)) {
+                bKeepAlive = pConn->sendQueue.Flush(fd);
             }
 
-            // 业务处理完毕，关闭当前连接
-            ::close(nConnectedSocket);
-            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
+            // 可读（或对端关闭），或积压刚降到上限以下：调用接口方法处理业务
+            bool bReadable = (nEvents & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0;
+            bool bResume = pConn->bReadPaused && !CSendQueue::IsBacklogged(fd);
+            if (bKeepAlive && !pConn->bClosing && (bReadable || bResume)) {
+                bKeepAlive = m_pObserver->ServerFunction(fd, nListenSocket);
+                pConn->bReadPaused = bKeepAlive && CSendQueue::IsBacklogged(fd);
+
+                // 业务要求关闭但还有积压的回复：先写完再关闭，写出失败则立即关闭
+                if (!bKeepAlive && pConn->sendQueue.GetPendingSize(fd) > 0) {
+                    pConn->bClosing = true;
+                    bKeepAlive = pConn->sendQueue.Flush(fd);
+                }
+            }
         }
 
-        ::close(nListenSocket);
-        return 0;
+        size_t nPending = pConn->sendQueue.GetPendingSize(fd);
+        if (bKeepAlive && !(pConn->bClosing && nPending == 0)) {
+            // 有积压时同时等待可写；暂停读取期间只要可写就会再次调度，积压写出后恢复读取
+            epoll_event ev;
+            ev.events = POOL_EVENTS | (nPending > 0 ? (uint32_t)EPOLLOUT : 0u);
+            ev.data.ptr = pConn;
+            if (::epoll_ctl(nEpoll, EPOLL_CTL_MOD, fd, &ev) == 0) {
+                return;
+            }
+            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+        }
+
+        // 连接出错、业务要求关闭且积压已写完：close 会自动把 fd 从 epoll 中移除
+        std::cout << "[Server] Client disconnected: " << pConn->strClientIP << std::endl;
+        ::close(fd);
+        delete pConn;
     }
 
-private:
     int m_nServerPort;
     std::string m_strBoundIP;
     int m_nLengthOfQueueOfListen;
@@ -143,31 +515,39 @@ public:
 
 private:
     // 实现接口定义的纯虚函数，编写具体的 Echo 逻辑
-    virtual void ServerFunction(int nConnectedSocket, int nListenSocket) {
+    // 对端只发不收导致回复积压过多时暂停读取，剩余数据留在接收缓冲区，由 TCP 流控限制对端继续发送
+    virtual bool ServerFunction(int nConnectedSocket, int nListenSocket) {
         char buf[MAX_BUFFER_SIZE];
 
-        // 循环接收数据
-        while (true) {
+        // 循环接收数据，直到本次可读事件的数据取完
+        while (!IsSendBacklogged(nConnectedSocket)) {
             memset(buf, 0, MAX_BUFFER_SIZE);
             ssize_t bytesRead = ::read(nConnectedSocket, buf, MAX_BUFFER_SIZE - 1);
 
             if (bytesRead > 0) {
                 std::cout << "[Recv]: " << buf;
                 // 将数据原样回传 (Echo)
-                ssize_t bytesWrite = ::write(nConnectedSocket, buf, bytesRead);
-                assert(bytesRead == bytesWrite);
+                if (!Send(nConnectedSocket, buf, bytesRead)) {
+                    std::cerr << "[Error] Write failed" << std::endl;
+                    return false;
+                }
             } else if (bytesRead == 0) {
                 // 客户端断开连接
-                break;
+                return false;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            } else if (errno == EINTR) {
+                continue;
             } else {
                 std::cerr << "[Error] Read failed" << std::endl;
-                break;
+                return false;
             }
         }
+        return true;
     }
 };
 
-int main() {
+int main(int argc, char **argv) {
     // 1. 创建业务对象 (Observer)
     CMyTCPServer myserver;
 
@@ -175,7 +555,29 @@ int main() {
     CTCPServer tcpserver(&myserver, DEFAULT_PORT);
 
     // 3. 运行服务
-    tcpserver.Run();
+    // 默认使用 epoll 事件循环；传入 "block" 参数时使用原有的阻塞模式
+    // 线程池模式: ./server-hw3 pool [线程数] [队列深度] [block|reject|grow]
+    if (argc > 1 && strcmp(argv[1], "block") == 0) {
+        tcpserver.Run();
+    } else if (argc > 1 && strcmp(argv[1], "pool") == 0) {
+        int nThreads = argc > 2 ? atoi(argv[2]) : 4;
+        int nQueueDepth = argc > 3 ? atoi(argv[3]) : 64;
+        // 负数或非数字的队列深度转成 size_t 后会变成极大的值，线程数过大则 nThreads * 4 可能溢出
+        if (nThreads < 1 || nThreads > MAX_POOL_THREADS || nQueueDepth < 1) {
+            std::cerr << "[Error] thread count must be 1.." << MAX_POOL_THREADS << " and queue depth must be positive" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " pool [threads] [queue depth] [block|reject|grow]" << std::endl;
+            return 1;
+        }
+        EBackpressurePolicy policy = BACKPRESSURE_BLOCK;
+        if (argc > 4 && strcmp(argv[4], "reject") == 0) {
+            policy = BACKPRESSURE_REJECT;
+        } else if (argc > 4 && strcmp(argv[4], "grow") == 0) {
+            policy = BACKPRESSURE_GROW;
+        }
+        tcpserver.RunThreadPool(nThreads, (size_t)nQueueDepth, policy, nThreads * 4);
+    } else {
+        tcpserver.RunEventLoop();
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -4,15 +4,39 @@
  * 功能: 使用静态多态封装TCP服务端，实现Echo服务
  *************************************************************************/
 #include <arpa/inet.h>
-#include <cassert>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <memory>
 #include <netinet/in.h>
 #include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <thread>
 #include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/CSendQueue.hpp"
 
 #define MAX_BUFFER_SIZE 1024
 #define DEFAULT_PORT 5000
+#define MAX_EPOLL_EVENTS 256
+
+// 多 Reactor 模式下每个工作线程的统计计数
+// 按缓存行对齐，避免不同线程的计数器落在同一缓存行造成伪共享
+struct alignas(64) CWorkerStats {
+    std::atomic<uint64_t> nConnections{0};  // 累计接受的连接数
+    std::atomic<uint64_t> nActive{0};       // 当前活跃连接数
+    std::atomic<uint64_t> nBytesRead{0};    // 累计读取字节数
+    std::atomic<uint64_t> nBytesWritten{0}; // 累计写出字节数
+};
 
 // 模板基类：使用 CRTP (Curiously Recurring Template Pattern)
 // T 是具体的子类类型
@@ -37,7 +61,285 @@ public:
     }
 
 public:
+    // 阻塞兼容模式：一次只服务一个客户端
     int Run() {
+        int nListenSocket = CreateListenSocket(false);
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+
+        // 4. 循环处理连接
+        while (true) {
+            sockaddr_in ClientAddress;
+            socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+
+            int nConnectedSocket = ::accept(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress);
+            if (-1 == nConnectedSocket) {
+                std::cerr << "[Error] accept error" << std::endl;
+                continue;
+            }
+
+            char clientIP[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+            std::cout << "[Server] Client connected: " << clientIP << std::endl;
+
+            // 5. 静态多态调用 (CRTP的核心)
+            // 将 this 指针强制转换为子类指针 T*，并在编译期确定调用 T::ServerFunction
+            // 阻塞套接字上 read 不会返回 EAGAIN，ServerFunction 一直处理到连接结束
+            T *pT = static_cast<T *>(this);
+            while (pT->ServerFunction(nConnectedSocket, nListenSocket)) {
+            }
+
+            ::close(nConnectedSocket);
+            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
+        }
+
+        ::close(nListenSocket);
+        return 0;
+    }
+
+    // 基于 epoll 的事件循环（Reactor）：单线程同时服务大量连接
+    // 套接字均为非阻塞、边沿触发，每次可读事件静态分派一次 T::ServerFunction
+    // 回复写不完时注册 EPOLLOUT，可写时继续发送，事件循环从不阻塞在单个连接上
+    int RunEventLoop() {
+        // 忽略 SIGPIPE，对端异常断开时 write 返回错误而不是终止进程
+        signal(SIGPIPE, SIG_IGN);
+        RaiseFileLimit();
+
+        int nListenSocket = CreateListenSocket(false);
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+        return EventLoop(nListenSocket, NULL);
+    }
+
+    // 多 Reactor 模式：启动 nThreads 个工作线程，每个线程拥有独立的
+    // SO_REUSEPORT 监听套接字和独立的 epoll 事件循环，由内核在各监听套接字间
+    // 分配新连接，不存在共享的 accept 锁
+    // 注意：T::ServerFunction 会被多个工作线程并发调用，必须是线程安全的
+    // nReportIntervalSec: 主线程打印各工作线程统计信息的间隔（秒）
+    int Run(int nThreads, int nReportIntervalSec = 5) {
+        if (nThreads <= 0) {
+            std::cerr << "[Error] invalid thread count: " << nThreads << std::endl;
+            return -1;
+        }
+
+        // 忽略 SIGPIPE，对端异常断开时 write 返回错误而不是终止进程
+        signal(SIGPIPE, SIG_IGN);
+        RaiseFileLimit();
+
+        // 先在主线程中创建全部监听套接字，任何一个失败都直接退出
+        std::vector<int> vListenSockets;
+        for (int i = 0; i < nThreads; i++) {
+            int nListenSocket = CreateListenSocket(true);
+            if (-1 == nListenSocket) {
+                for (int fd : vListenSockets) {
+                    ::close(fd);
+                }
+                return -1;
+            }
+            vListenSockets.push_back(nListenSocket);
+        }
+
+        // std::atomic 不可移动，用 unique_ptr 数组保存每个工作线程的统计
+        std::unique_ptr<CWorkerStats[]> pStats(new CWorkerStats[nThreads]);
+        std::atomic<int> nRunning(nThreads);
+        std::vector<std::thread> vWorkers;
+        for (int i = 0; i < nThreads; i++) {
+            vWorkers.emplace_back([this, &vListenSockets, &pStats, &nRunning, i]() {
+                EventLoop(vListenSockets[i], &pStats[i]);
+                nRunning--;
+            });
+        }
+        std::cout << "[Server] " << nThreads << " reactors started with SO_REUSEPORT" << std::endl;
+
+        // 主线程周期性打印统计，用于确认负载是否均衡
+        while (nRunning > 0) {
+            std::this_thread::sleep_for(std::chrono::seconds(nReportIntervalSec));
+
+            uint64_t nTotalConnections = 0;
+            for (int i = 0; i < nThreads; i++) {
+                nTotalConnections += pStats[i].nConnections;
+            }
+            for (int i = 0; i < nThreads; i++) {
+                uint64_t nConnections = pStats[i].nConnections;
+                std::cout << "[Stats] worker " << i
+                          << ": connections=" << nConnections
+                          << " (" << (nTotalConnections ? nConnections * 100 / nTotalConnections : 0) << "%)"
+                          << " active=" << pStats[i].nActive
+                          << " rx=" << pStats[i].nBytesRead
+                          << " tx=" << pStats[i].nBytesWritten << std::endl;
+            }
+        }
+
+        for (auto &worker : vWorkers) {
+            worker.join();
+        }
+        return 0;
+    }
+
+    // 基类定义接口，但不实现，也不需要是 virtual
+    // 每次套接字可读时被调用，需把数据读到 EAGAIN 为止，或在 IsSendBacklogged 返回 true 时提前返回
+    // 返回 true 保持连接，返回 false 由基类关闭连接
+    bool ServerFunction(int nConnectedSocket, int nListenSocket) {
+        // 默认实现为空，或者抛出编译期错误
+        return false;
+    }
+
+protected:
+    // 读取数据，并计入当前工作线程的统计
+    static ssize_t Read(int nSocket, char *pBuf, size_t nLen) {
+        ssize_t bytesRead = ::read(nSocket, pBuf, nLen);
+        if (bytesRead > 0 && s_pWorkerStats != NULL) {
+            s_pWorkerStats->nBytesRead.fetch_add(bytesRead, std::memory_order_relaxed);
+        }
+        return bytesRead;
+    }
+
+    // 发送回复，事件循环中不阻塞，并计入当前工作线程的统计；连接出错返回 false
+    static bool Send(int nSocket, const char *pBuf, size_t nLen) {
+        return CSendQueue::Send(nSocket, pBuf, nLen);
+    }
+
+    // 回复积压是否已超过上限
+    static bool IsSendBacklogged(int nSocket) {
+        return CSendQueue::IsBacklogged(nSocket);
+    }
+
+private:
+    // 单个 Reactor 的事件循环，pStats 为 NULL 时不做统计
+    // 返回时关闭 nListenSocket
+    int EventLoop(int nListenSocket, CWorkerStats *pStats) {
+        s_pWorkerStats = pStats;
+        SetNonBlocking(nListenSocket);
+
+        // 1. 创建 epoll 实例并注册监听套接字
+        int nEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+        if (-1 == nEpoll) {
+            std::cerr << "[Error] epoll_create1 error: " << strerror(errno) << std::endl;
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = nListenSocket;
+        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nListenSocket, &ev) == -1) {
+            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+            ::close(nEpoll);
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        CSendQueue sendQueue(nEpoll, EPOLLIN | EPOLLRDHUP | EPOLLET, pStats != NULL ? &pStats->nBytesWritten : NULL);
+        std::unordered_map<int, CConnection> mapConnections;
+        epoll_event events[MAX_EPOLL_EVENTS];
+
+        // 2. 事件循环
+        while (true) {
+            int nReady = ::epoll_wait(nEpoll, events, MAX_EPOLL_EVENTS, -1);
+            if (-1 == nReady) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "[Error] epoll_wait error: " << strerror(errno) << std::endl;
+                break;
+            }
+
+            for (int i = 0; i < nReady; i++) {
+                int fd = events[i].data.fd;
+
+                // 3. 新连接：边沿触发下必须 accept 到 EAGAIN 为止
+                if (fd == nListenSocket) {
+                    while (true) {
+                        sockaddr_in ClientAddress;
+                        socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+                        int nConnectedSocket = ::accept4(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                        if (-1 == nConnectedSocket) {
+                            if (errno == EINTR) {
+                                continue;
+                            }
+                            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                                std::cerr << "[Error] accept error: " << strerror(errno) << std::endl;
+                            }
+                            break;
+                        }
+
+                        char clientIP[INET_ADDRSTRLEN];
+                        inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+
+                        epoll_event evConn;
+                        evConn.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+                        evConn.data.fd = nConnectedSocket;
+                        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nConnectedSocket, &evConn) == -1) {
+                            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+                            ::close(nConnectedSocket);
+                            continue;
+                        }
+                        CConnection &conn = mapConnections[nConnectedSocket];
+                        conn.strClientIP = clientIP;
+                        conn.bReadPaused = false;
+                        conn.bClosing = false;
+                        sendQueue.AddConnection(nConnectedSocket);
+                        if (pStats != NULL) {
+                            pStats->nConnections.fetch_add(1, std::memory_order_relaxed);
+                            pStats->nActive.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        std::cout << "[Server] Client connected: " << clientIP << std::endl;
+                    }
+                    continue;
+                }
+
+                auto it = mapConnections.find(fd);
+                if (it == mapConnections.end()) {
+                    continue;
+                }
+                CConnection &conn = it->second;
+                bool bKeepAlive = !(events[i].events & EPOLLERR);
+
+                // 4. 可写：先写出积压的回复
+                if (bKeepAlive && (events[i].events & EPOLLOUT)) {
+                    bKeepAlive = sendQueue.Flush(fd);
+                }
+
+                // 5. 可读（或对端关闭），或积压刚降到上限以下：编译期确定调用 T::ServerFunction
+                // 暂停期间未读的数据还在接收缓冲区中，边沿触发不会再通知，需要主动恢复读取
+                bool bReadable = (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0;
+                bool bResume = conn.bReadPaused && !CSendQueue::IsBacklogged(fd);
+                if (bKeepAlive && !conn.bClosing && (bReadable || bResume)) {
+                    T *pT = static_cast<T *>(this);
+                    bKeepAlive = pT->ServerFunction(fd, nListenSocket);
+                    conn.bReadPaused = bKeepAlive && CSendQueue::IsBacklogged(fd);
+
+                    // 业务要求关闭但还有积压的回复：先写完再关闭，写出失败则立即关闭
+                    if (!bKeepAlive && sendQueue.GetPendingSize(fd) > 0) {
+                        conn.bClosing = true;
+                        bKeepAlive = sendQueue.Flush(fd);
+                    }
+                }
+
+                // 6. 连接出错、业务要求关闭且积压已写完：close 会自动把 fd 从 epoll 中移除
+                if (!bKeepAlive || (conn.bClosing && sendQueue.GetPendingSize(fd) == 0)) {
+                    std::cout << "[Server] Client disconnected: " << conn.strClientIP << std::endl;
+                    sendQueue.RemoveConnection(fd);
+                    mapConnections.erase(it);
+                    ::close(fd);
+                    if (pStats != NULL) {
+                        pStats->nActive.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        ::close(nEpoll);
+        ::close(nListenSocket);
+        return 0;
+    }
+
+private:
+    // 创建、绑定并监听套接字，失败返回 -1
+    // bReusePort 为 true 时开启 SO_REUSEPORT，允许多个套接字绑定同一端口
+    int CreateListenSocket(bool bReusePort) {
         // 1. 创建 Socket
         int nListenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
         if (-1 == nListenSocket) {
@@ -45,6 +347,16 @@ public:
             return -1;
         }
 
+        if (bReusePort) {
+            int on = 1;
+            setsockopt(nListenSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (setsockopt(nListenSocket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1) {
+                std::cerr << "[Error] SO_REUSEPORT error: " << strerror(errno) << std::endl;
+                ::close(nListenSocket);
+                return -1;
+            }
+        }
+
         // 2. 绑定地址
         sockaddr_in ServerAddress;
         memset(&ServerAddress, 0, sizeof(sockaddr_in));
@@ -75,46 +387,45 @@ public:
         }
 
         std::cout << "[Server] Listening on port " << m_nServerPort << "..." << std::endl;
+        return nListenSocket;
+    }
 
-        // 4. 循环处理连接
-        while (true) {
-            sockaddr_in ClientAddress;
-            socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
-
-            int nConnectedSocket = ::accept(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress);
-            if (-1 == nConnectedSocket) {
-                std::cerr << "[Error] accept error" << std::endl;
-                continue;
-            }
-
-            char clientIP[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
-            std::cout << "[Server] Client connected: " << clientIP << std::endl;
-
-            // 5. 静态多态调用 (CRTP的核心)
-            // 将 this 指针强制转换为子类指针 T*，并在编译期确定调用 T::ServerFunction
-            T *pT = static_cast<T *>(this);
-            pT->ServerFunction(nConnectedSocket, nListenSocket);
-
-            ::close(nConnectedSocket);
-            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
+    // 将文件描述符软限制提升到硬限制，以支持上千个并发连接
+    static void RaiseFileLimit() {
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
         }
-
-        ::close(nListenSocket);
-        return 0;
     }
 
-    // 基类定义接口，但不实现，也不需要是 virtual
-    void ServerFunction(int nConnectedSocket, int nListenSocket) {
-        // 默认实现为空，或者抛出编译期错误
+    static bool SetNonBlocking(int nSocket) {
+        int nFlags = ::fcntl(nSocket, F_GETFL, 0);
+        if (-1 == nFlags) {
+            return false;
+        }
+        return ::fcntl(nSocket, F_SETFL, nFlags | O_NONBLOCK) != -1;
     }
 
 private:
+    // 事件循环中每个已连接套接字的状态
+    struct CConnection {
+        std::string strClientIP;
+        bool bReadPaused; // 积压超过上限，ServerFunction 已暂停读取
+        bool bClosing;    // 业务已要求关闭，写完积压的回复后再关闭
+    };
+
     int m_nServerPort;
     std::string m_strBoundIP;
     int m_nLengthOfQueueOfListen;
+
+    // 当前线程所属 Reactor 的统计，单 Reactor 模式下为 NULL
+    static thread_local CWorkerStats *s_pWorkerStats;
 };
 
+template <typename T>
+thread_local CWorkerStats *CTCPServer<T>::s_pWorkerStats = NULL;
+
 // 子类继承自 模板基类<子类>
 class CMyTCPServer : public CTCPServer<CMyTCPServer> {
 public:
@@ -127,25 +438,40 @@ public:
 
     // 实现具体的业务逻辑 (Echo)
     // 注意：这里不需要 virtual 关键字
-    void ServerFunction(int nConnectedSocket, int nListenSocket) {
+    // 对端只发不收导致回复积压过多时暂停读取，剩余数据留在接收缓冲区，由 TCP 流控限制对端继续发送
+    bool ServerFunction(int nConnectedSocket, int nListenSocket) {
         char buf[MAX_BUFFER_SIZE];
-        while (true) {
+        while (!IsSendBacklogged(nConnectedSocket)) {
             memset(buf, 0, MAX_BUFFER_SIZE);
-            ssize_t bytesRead = ::read(nConnectedSocket, buf, MAX_BUFFER_SIZE - 1);
+            ssize_t bytesRead = Read(nConnectedSocket, buf, MAX_BUFFER_SIZE - 1);
 
             if (bytesRead > 0) {
                 std::cout << "[Recv]: " << buf;
-                ssize_t bytesWrite = ::write(nConnectedSocket, buf, bytesRead); // Echo back
-                assert(bytesRead == bytesWrite);
+                if (!Send(nConnectedSocket, buf, bytesRead)) { // Echo back
+                    return false;
+                }
+            } else if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true; // Drained, wait for next event
+            } else if (bytesRead == -1 && errno == EINTR) {
+                continue;
             } else {
-                break; // Connection closed or error
+                return false; // Connection closed or error
             }
         }
+        return true; // Backlogged, resumed once the replies drain
     }
 };
 
-int main() {
+int main(int argc, char **argv) {
     CMyTCPServer myserver(5000);
-    myserver.Run();
+    // 默认使用 epoll 事件循环；传入 "block" 参数时使用原有的阻塞模式
+    // 传入正整数 N 时启动 N 个 SO_REUSEPORT 工作线程（多 Reactor 模式）
+    if (argc > 1 && strcmp(argv[1], "block") == 0) {
+        myserver.Run();
+    } else if (argc > 1 && atoi(argv[1]) > 0) {
+        myserver.Run(atoi(argv[1]));
+    } else {
+        myserver.RunEventLoop();
+    }
     return 0;
 }
\ No newline at end of file
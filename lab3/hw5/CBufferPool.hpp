@@ -0,0 +1,238 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CBufferPool.hpp
+ * 功能: 连接缓冲区的分级池化分配器
+ *       按 2 的幂划分尺寸等级（256B ~ 16MB），每个等级一条空闲链表；
+ *       小等级从 64KB 的 slab 中切分，块按缓存行对齐，释放后回到空闲链表复用，
+ *       稳态下收发消息不再调用 malloc
+ *       每个线程持有独立的池（CBufferPool::Local()），无锁；slab 由使用它的线程首次写入，
+ *       在默认的 first-touch 策略下内存分配在该线程所在的 NUMA 节点
+ * 注意: 缓冲区必须在申请它的线程上释放（epoll 单线程 Reactor 与每线程一个 Reactor 的模型均满足）
+ *************************************************************************/
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#define CACHE_LINE_SIZE 64
+#define POOL_MIN_CLASS_SHIFT 8  // 最小等级 256B
+#define POOL_MAX_CLASS_SHIFT 24 // 最大等级 16MB，更大的请求直接向系统申请
+#define POOL_CLASS_COUNT (POOL_MAX_CLASS_SHIFT - POOL_MIN_CLASS_SHIFT + 1)
+#define POOL_SLAB_SIZE (64 * 1024)
+
+// 分配统计
+struct CBufferPoolStats {
+    uint64_t nAcquires;      // Acquire 调用次数
+    uint64_t nReleases;      // Release 调用次数
+    uint64_t nSlabAllocs;    // 向系统申请 slab 的次数（稳态下应保持不变）
+    uint64_t nLargeAllocs;   // 超过最大等级、直接向系统申请的次数
+    uint64_t nBytesInUse;    // 已借出的字节数（按等级容量计）
+    uint64_t nBytesReserved; // 池持有的全部 slab 字节数
+};
+
+class CBufferPool {
+public:
+    CBufferPool() {
+        memset(m_pFree, 0, sizeof(m_pFree));
+        memset(&m_stats, 0, sizeof(m_stats));
+    }
+
+    virtual ~CBufferPool() {
+        for (void *pSlab : m_vSlabs) {
+            free(pSlab);
+        }
+    }
+
+    CBufferPool(const CBufferPool &) = delete;
+    CBufferPool &operator=(const CBufferPool &) = delete;
+
+    // 当前线程的缓冲池
+    static CBufferPool &Local() {
+        static thread_local CBufferPool pool;
+        return pool;
+    }
+
+public:
+    // 申请至少 nSize 字节，实际容量（等级大小）写入 nCapacity，释放时需原样传回
+    // 与 new 一样，内存不足时抛出 std::bad_alloc，不返回 NULL
+    char *Acquire(size_t nSize, size_t &nCapacity) {
+        int nClass = ClassOf(nSize);
+        if (nClass < 0) {
+            // 超大请求：按缓存行对齐直接申请（nSize 接近 SIZE_MAX 时向上取整会回绕，按失败处理）
+            size_t nAligned = (nSize + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+            char *pData = nAligned >= nSize ? (char *)aligned_alloc(CACHE_LINE_SIZE, nAligned) : NULL;
+            if (pData == NULL) {
+                throw std::bad_alloc();
+            }
+            nCapacity = nAligned;
+            m_stats.nAcquires++;
+            m_stats.nLargeAllocs++;
+            m_stats.nBytesInUse += nCapacity;
+            return pData;
+        }
+
+        if (m_pFree[nClass] == NULL && !Refill(nClass)) {
+            throw std::bad_alloc();
+        }
+        nCapacity = ClassSize(nClass);
+        m_stats.nAcquires++;
+        CFreeBlock *pBlock = m_pFree[nClass];
+        m_pFree[nClass] = pBlock->pNext;
+        m_stats.nBytesInUse += nCapacity;
+        return (char *)pBlock;
+    }
+
+    void Release(char *pData, size_t nCapacity) {
+        if (pData == NULL) {
+            return;
+        }
+        m_stats.nReleases++;
+        m_stats.nBytesInUse -= nCapacity;
+        int nClass = ClassOf(nCapacity);
+        if (nClass < 0) {
+            free(pData);
+            return;
+        }
+        CFreeBlock *pBlock = (CFreeBlock *)pData;
+        pBlock->pNext = m_pFree[nClass];
+        m_pFree[nClass] = pBlock;
+    }
+
+    const CBufferPoolStats &GetStats() const {
+        return m_stats;
+    }
+
+    void PrintStats(const char *pTitle) const {
+        printf("%s acquires=%llu releases=%llu slab allocs=%llu large allocs=%llu in use=%lluB reserved=%lluB\n", pTitle,
+               (unsigned long long)m_stats.nAcquires, (unsigned long long)m_stats.nReleases,
+               (unsigned long long)m_stats.nSlabAllocs, (unsigned long long)m_stats.nLargeAllocs,
+               (unsigned long long)m_stats.nBytesInUse, (unsigned long long)m_stats.nBytesReserved);
+    }
+
+private:
+    struct CFreeBlock {
+        CFreeBlock *pNext;
+    };
+
+    static size_t ClassSize(int nClass) {
+        return (size_t)1 << (nClass + POOL_MIN_CLASS_SHIFT);
+    }
+
+    // 返回能容纳 nSize 的最小等级，超过最大等级返回 -1
+    static int ClassOf(size_t nSize) {
+        if (nSize <= ((size_t)1 << POOL_MIN_CLASS_SHIFT)) {
+            return 0;
+        }
+        if (nSize > ((size_t)1 << POOL_MAX_CLASS_SHIFT)) {
+            return -1;
+        }
+        int nShift = 64 - __builtin_clzll(nSize - 1);
+        return nShift - POOL_MIN_CLASS_SHIFT;
+    }
+
+    // 申请一个 slab 并切分成该等级的块；不小于 slab 的等级每个 slab 只有一块
+    bool Refill(int nClass) {
+        size_t nBlockSize = ClassSize(nClass);
+        size_t nSlabSize = nBlockSize < POOL_SLAB_SIZE ? POOL_SLAB_SIZE : nBlockSize;
+        char *pSlab = (char *)aligned_alloc(CACHE_LINE_SIZE, nSlabSize);
+        if (pSlab == NULL) {
+            return false;
+        }
+        try {
+            m_vSlabs.push_back(pSlab);
+        } catch (...) {
+            free(pSlab);
+            throw;
+        }
+        m_stats.nSlabAllocs++;
+        m_stats.nBytesReserved += nSlabSize;
+
+        // 倒序入链，使链表头为 slab 中地址最低的块
+        for (size_t nOffset = nSlabSize; nOffset >= nBlockSize; nOffset -= nBlockSize) {
+            CFreeBlock *pBlock = (CFreeBlock *)(pSlab + nOffset - nBlockSize);
+            pBlock->pNext = m_pFree[nClass];
+            m_pFree[nClass] = pBlock;
+        }
+        return true;
+    }
+
+private:
+    CFreeBlock *m_pFree[POOL_CLASS_COUNT];
+    std::vector<void *> m_vSlabs;
+    CBufferPoolStats m_stats;
+};
+
+// -----------------------------------------------------------
+// 从当前线程缓冲池借出的缓冲区，析构时自动归还
+// -----------------------------------------------------------
+class CPooledBuffer {
+public:
+    CPooledBuffer() : m_pData(NULL), m_nCapacity(0) {
+    }
+
+    explicit CPooledBuffer(size_t nSize) {
+        m_pData = CBufferPool::Local().Acquire(nSize, m_nCapacity);
+    }
+
+    CPooledBuffer(CPooledBuffer &&other) : m_pData(other.m_pData), m_nCapacity(other.m_nCapacity) {
+        other.m_pData = NULL;
+        other.m_nCapacity = 0;
+    }
+
+    CPooledBuffer &operator=(CPooledBuffer &&other) {
+        if (this != &other) {
+            Release();
+            m_pData = other.m_pData;
+            m_nCapacity = other.m_nCapacity;
+            other.m_pData = NULL;
+            other.m_nCapacity = 0;
+        }
+        return *this;
+    }
+
+    CPooledBuffer(const CPooledBuffer &) = delete;
+    CPooledBuffer &operator=(const CPooledBuffer &) = delete;
+
+    virtual ~CPooledBuffer() {
+        Release();
+    }
+
+public:
+    char *Data() const {
+        return m_pData;
+    }
+
+    size_t Capacity() const {
+        return m_nCapacity;
+    }
+
+    // 扩容到至少 nSize 字节，保留前 nKeep 字节的内容；申请失败时抛出 std::bad_alloc，原缓冲区不变
+    void Grow(size_t nSize, size_t nKeep) {
+        if (nSize <= m_nCapacity) {
+            return;
+        }
+        size_t nCapacity;
+        char *pData = CBufferPool::Local().Acquire(nSize, nCapacity);
+        if (nKeep > 0) {
+            memcpy(pData, m_pData, nKeep);
+        }
+        Release();
+        m_pData = pData;
+        m_nCapacity = nCapacity;
+    }
+
+    void Release() {
+        if (m_pData != NULL) {
+            CBufferPool::Local().Release(m_pData, m_nCapacity);
+            m_pData = NULL;
+            m_nCapacity = 0;
+        }
+    }
+
+private:
+    char *m_pData;
+    size_t m_nCapacity;
+};
@@ -0,0 +1,345 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CFraming.hpp
+ * 功能: 长度前缀分帧切面，可织入 CTCPServer / CTCPClient 与业务类之间
+ *       帧格式: 4 字节网络字节序长度 + 负载
+ *       CFramedServer<Business>: 以连接为单位维护可增长的读缓冲区，拆出完整消息后
+ *                                调用 Business::OnMessage；同一批读取产生的全部回复
+ *                                通过 writev 合并为尽量少的系统调用发出，写不下的部分交给 CSendQueue，
+ *                                回复积压超过上限时暂停读取
+ *       CFramedClient<Business>: 为 Business::OnConnected 提供按消息收发的 CFramedChannel
+ *       读缓冲区与拷贝的回复均从 CBufferPool 借出，连接断开时归还，稳态下每条消息不调用 malloc
+ * 用法: CTCPServer<CFramedServer<CMyFramedServer>> / CTCPClient<CFramedClient<CMyFramedClient>>
+ * 注意: 面向 read/write 通路（阻塞模式与 epoll 事件循环），不支持 io_uring 切面
+ *************************************************************************/
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits.h>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/CSendQueue.hpp"
+#include "CBufferPool.hpp"
+
+#define FRAME_HEADER_SIZE 4
+// 单帧负载上限，超过视为协议错误，防止恶意长度耗尽内存
+#define FRAME_MAX_SIZE (16 * 1024 * 1024)
+// 读缓冲区的初始大小与每次读取前保证的最小空闲空间
+#define FRAME_READ_CHUNK 4096
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// -----------------------------------------------------------
+// 可增长的读缓冲区：[m_nBegin, m_nEnd) 为尚未解析的数据
+// -----------------------------------------------------------
+class CFrameBuffer {
+public:
+    CFrameBuffer() : m_buffer(FRAME_READ_CHUNK), m_nBegin(0), m_nEnd(0), m_nMissing(0) {
+    }
+
+    // 从 fd 读取一次数据到缓冲区尾部，返回值同 read
+    // 只有这里会移动或扩容缓冲区，因此 NextFrame 取出的消息在下一次 ReadFrom 之前保持有效
+    ssize_t ReadFrom(int fd) {
+        // 已知半条消息还缺多少字节时一次扩容到位，避免大消息逐块多次增长
+        Reserve(m_nMissing > FRAME_READ_CHUNK ? m_nMissing : FRAME_READ_CHUNK);
+        ssize_t n = ::read(fd, m_buffer.Data() + m_nEnd, m_buffer.Capacity() - m_nEnd);
+        if (n > 0) {
+            m_nEnd += n;
+        }
+        return n;
+    }
+
+    // 取出下一条完整消息，消息数据在下一次 ReadFrom 之前有效
+    // 返回 1 表示取到消息，0 表示数据不足，-1 表示长度非法
+    int NextFrame(const char *&pData, size_t &nLen) {
+        size_t nAvail = m_nEnd - m_nBegin;
+        if (nAvail < FRAME_HEADER_SIZE) {
+            return 0;
+        }
+        uint32_t nNetLen;
+        memcpy(&nNetLen, m_buffer.Data() + m_nBegin, FRAME_HEADER_SIZE);
+        uint32_t nFrameLen = ntohl(nNetLen);
+        if (nFrameLen > FRAME_MAX_SIZE) {
+            return -1;
+        }
+        if (nAvail < FRAME_HEADER_SIZE + (size_t)nFrameLen) {
+            m_nMissing = FRAME_HEADER_SIZE + nFrameLen - nAvail;
+            return 0;
+        }
+        m_nMissing = 0;
+        pData = m_buffer.Data() + m_nBegin + FRAME_HEADER_SIZE;
+        nLen = nFrameLen;
+        m_nBegin += FRAME_HEADER_SIZE + nFrameLen;
+        return 1;
+    }
+
+private:
+    // 保证尾部至少有 nMin 字节空闲：先把未解析数据搬到头部，不够再换用更大等级的缓冲区
+    void Reserve(size_t nMin) {
+        if (m_buffer.Capacity() - m_nEnd >= nMin) {
+            return;
+        }
+        if (m_nBegin > 0) {
+            memmove(m_buffer.Data(), m_buffer.Data() + m_nBegin, m_nEnd - m_nBegin);
+            m_nEnd -= m_nBegin;
+            m_nBegin = 0;
+        }
+        m_buffer.Grow(m_nEnd + nMin, m_nEnd);
+    }
+
+private:
+    CPooledBuffer m_buffer;
+    size_t m_nBegin;
+    size_t m_nEnd;
+    size_t m_nMissing; // 当前半条消息还缺少的字节数
+};
+
+// -----------------------------------------------------------
+// 待发送消息队列：Flush 时以 writev 一次提交多条消息的头部与负载
+// -----------------------------------------------------------
+class CFrameWriter {
+public:
+    // 拷贝一份负载（存放在池化缓冲区中）后排队
+    void Send(const char *pData, size_t nLen) {
+        m_vOwned.push_back(CPooledBuffer(nLen));
+        memcpy(m_vOwned.back().Data(), pData, nLen);
+        SendRef(m_vOwned.back().Data(), nLen);
+    }
+
+    // 直接引用负载，调用方保证 pData 在 Flush 之前有效（如回显 OnMessage 收到的数据）
+    void SendRef(const char *pData, size_t nLen) {
+        CPending pending;
+        pending.nHeader = htonl((uint32_t)nLen);
+        pending.pData = pData;
+        pending.nLen = nLen;
+        m_vPending.push_back(pending);
+    }
+
+    size_t GetPendingCount() const {
+        return m_vPending.size();
+    }
+
+    // 发送全部排队的消息，套接字写不下的部分经 CSendQueue 发送（事件循环中暂存，阻塞模式下等待可写）
+    bool Flush(int fd) {
+        bool bOk = true;
+        size_t nIndex = 0;
+
+        while (bOk && nIndex < m_vPending.size()) {
+            // 每次最多组装 IOV_MAX 个 iovec（每条消息占两个）
+            m_vIov.clear();
+            for (; nIndex < m_vPending.size() && m_vIov.size() + 2 <= IOV_MAX; nIndex++) {
+                CPending &pending = m_vPending[nIndex];
+                iovec iovHeader = {&pending.nHeader, FRAME_HEADER_SIZE};
+                m_vIov.push_back(iovHeader);
+                if (pending.nLen > 0) {
+                    iovec iovData = {(void *)pending.pData, pending.nLen};
+                    m_vIov.push_back(iovData);
+                }
+            }
+            bOk = WritevAll(fd, &m_vIov[0], (int)m_vIov.size());
+        }
+
+        // clear 保留 vector 的容量，池化缓冲区在析构时归还，下一批消息无需再申请内存
+        m_vPending.clear();
+        m_vOwned.clear();
+        return bOk;
+    }
+
+private:
+    static bool WritevAll(int fd, iovec *pIov, int nCount) {
+        // 连接已有积压时不能直接写，全部追加到输出缓冲区以保持顺序
+        bool bQueue = CSendQueue::HasPending(fd);
+        while (nCount > 0 && !bQueue) {
+            ssize_t n = ::writev(fd, pIov, nCount);
+            if (n > 0) {
+                // 跳过已完整写出的 iovec，调整部分写出的那一个
+                size_t nWritten = n;
+                while (nCount > 0 && nWritten >= pIov->iov_len) {
+                    nWritten -= pIov->iov_len;
+                    pIov++;
+                    nCount--;
+                }
+                if (nCount > 0) {
+                    pIov->iov_base = (char *)pIov->iov_base + nWritten;
+                    pIov->iov_len -= nWritten;
+                }
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                bQueue = true;
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+
+        // 剩余部分拷贝一份交给 CSendQueue，引用的负载在 Flush 返回后即可失效
+        for (; nCount > 0; pIov++, nCount--) {
+            if (!CSendQueue::Send(fd, (const char *)pIov->iov_base, pIov->iov_len)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct CPending {
+        uint32_t nHeader; // 网络字节序长度
+        const char *pData;
+        size_t nLen;
+    };
+
+    std::vector<CPending> m_vPending;
+    std::vector<CPooledBuffer> m_vOwned; // Send 拷贝的负载，vector 扩容只移动句柄，数据地址不变
+    std::vector<iovec> m_vIov;
+};
+
+// -----------------------------------------------------------
+// 服务端分帧切面：把连接上的字节流拆成消息交给业务类
+// Business 需提供: bool OnMessage(const char *pData, size_t nLen, CFrameWriter &writer)
+//   返回 false 表示关闭连接；pData 仅在本次调用及随后的 Flush 之前有效
+// -----------------------------------------------------------
+template <typename Business>
+class CFramedServer : public Business {
+public:
+    CFramedServer() : m_bPrintPoolStats(false) {
+    }
+
+    // 开启后每当最后一个连接关闭、池中缓冲区应已全部归还时打印一次缓冲池统计（in use 应为 0）
+    void EnablePoolStats() {
+        m_bPrintPoolStats = true;
+    }
+
+    // 当前线程缓冲池的统计，供调用方按需输出
+    const CBufferPoolStats &GetPoolStats() const {
+        return CBufferPool::Local().GetStats();
+    }
+
+    // 每次套接字可读时被调用，返回 true 保持连接，返回 false 由连接切面关闭连接
+    // 回复积压超过上限时暂停读取，积压写出后连接切面会再次调用
+    bool ServerFunction(int nConnectedSocket, int /*nListenSocket*/) {
+        CConnection &conn = m_mapConnections[nConnectedSocket];
+
+        while (!CSendQueue::IsBacklogged(nConnectedSocket)) {
+            ssize_t n = conn.readBuffer.ReadFrom(nConnectedSocket);
+            if (n > 0) {
+                // 本次读到的所有完整消息的回复合并后统一发送；业务要求关闭时也先发出已产生的回复
+                bool bKeepAlive = Dispatch(conn);
+                bool bFlushed = conn.writer.Flush(nConnectedSocket);
+                if (!bKeepAlive || !bFlushed) {
+                    CloseConnection(nConnectedSocket);
+                    return false;
+                }
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else {
+                CloseConnection(nConnectedSocket);
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    // 释放连接状态，缓冲区归还到池中供后续连接复用
+    void CloseConnection(int nConnectedSocket) {
+        m_mapConnections.erase(nConnectedSocket);
+        if (m_bPrintPoolStats && m_mapConnections.empty()) {
+            CBufferPool::Local().PrintStats("[Pool]");
+        }
+    }
+
+    struct CConnection {
+        CFrameBuffer readBuffer;
+        CFrameWriter writer;
+    };
+
+    bool Dispatch(CConnection &conn) {
+        Business *pBusiness = static_cast<Business *>(this);
+        const char *pData;
+        size_t nLen;
+        int nRet;
+        while ((nRet = conn.readBuffer.NextFrame(pData, nLen)) == 1) {
+            if (!pBusiness->OnMessage(pData, nLen, conn.writer)) {
+                return false;
+            }
+        }
+        return nRet == 0;
+    }
+
+private:
+    std::unordered_map<int, CConnection> m_mapConnections;
+    bool m_bPrintPoolStats;
+};
+
+// -----------------------------------------------------------
+// 客户端消息通道：按消息发送与接收（阻塞套接字）
+// -----------------------------------------------------------
+class CFramedChannel {
+public:
+    explicit CFramedChannel(int fd) : m_fd(fd) {
+    }
+
+    // 排队一条消息，Flush 或 Recv 时才真正发出
+    void Send(const char *pData, size_t nLen) {
+        m_writer.Send(pData, nLen);
+    }
+
+    bool Flush() {
+        return m_writer.Flush(m_fd);
+    }
+
+    // 接收一条完整消息（会先发出排队的消息），连接关闭或协议错误时返回 false
+    bool Recv(std::string &strMessage) {
+        if (m_writer.GetPendingCount() > 0 && !Flush()) {
+            return false;
+        }
+        while (true) {
+            const char *pData;
+            size_t nLen;
+            int nRet = m_readBuffer.NextFrame(pData, nLen);
+            if (nRet == 1) {
+                strMessage.assign(pData, nLen);
+                return true;
+            }
+            if (nRet == -1) {
+                return false;
+            }
+            ssize_t n = m_readBuffer.ReadFrom(m_fd);
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+        }
+    }
+
+private:
+    int m_fd;
+    CFrameBuffer m_readBuffer;
+    CFrameWriter m_writer;
+};
+
+// -----------------------------------------------------------
+// 客户端分帧切面
+// Business 需提供: void OnConnected(CFramedChannel &channel)
+// -----------------------------------------------------------
+template <typename Business>
+class CFramedClient : public Business {
+public:
+    void ClientFunction(int nConnectedSocket) {
+        CFramedChannel channel(nConnectedSocket);
+        Business *pBusiness = static_cast<Business *>(this);
+        pBusiness->OnConnected(channel);
+    }
+};
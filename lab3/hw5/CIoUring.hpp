@@ -0,0 +1,302 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CIoUring.hpp
+ * 功能: 基于原始系统调用的最小 io_uring 封装（不依赖 liburing）
+ *       提供 SQ/CQ 环操作、常用 SQE 准备函数以及提供缓冲区环 (provided buffer ring)
+ *************************************************************************/
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+class CIoUring {
+public:
+    CIoUring() {
+        m_nRingFd = -1;
+        m_pSqRing = NULL;
+        m_pCqRing = NULL;
+        m_pSqes = NULL;
+        m_nSqRingSize = 0;
+        m_nCqRingSize = 0;
+        m_nSqesSize = 0;
+        m_nSqTail = 0;
+        m_nSqSubmitted = 0;
+        m_pBufRing = NULL;
+        m_nBufRingSize = 0;
+        m_nBufRingMask = 0;
+        m_nBufTail = 0;
+        m_nBufGroup = 0;
+        m_pBufBase = NULL;
+        m_nBufSize = 0;
+    }
+
+    ~CIoUring() {
+        Close();
+    }
+
+    // 创建 io_uring 实例并映射 SQ/CQ 环
+    // 失败返回 false，errno 保留系统调用的错误码（如内核不支持时为 ENOSYS）
+    bool Init(unsigned nEntries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        m_nRingFd = (int)::syscall(__NR_io_uring_setup, nEntries, &params);
+        if (m_nRingFd < 0) {
+            m_nRingFd = -1;
+            return false;
+        }
+
+        // 1. 映射 SQ 环与 CQ 环（支持 SINGLE_MMAP 的内核上二者共用一次映射）
+        m_nSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_nCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool bSingleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (bSingleMmap) {
+            if (m_nCqRingSize > m_nSqRingSize) {
+                m_nSqRingSize = m_nCqRingSize;
+            }
+            m_nCqRingSize = m_nSqRingSize;
+        }
+
+        m_pSqRing = (char *)::mmap(NULL, m_nSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_nRingFd, IORING_OFF_SQ_RING);
+        if (m_pSqRing == MAP_FAILED) {
+            m_pSqRing = NULL;
+            Close();
+            return false;
+        }
+
+        if (bSingleMmap) {
+            m_pCqRing = m_pSqRing;
+        } else {
+            m_pCqRing = (char *)::mmap(NULL, m_nCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_nRingFd, IORING_OFF_CQ_RING);
+            if (m_pCqRing == MAP_FAILED) {
+                m_pCqRing = NULL;
+                Close();
+                return false;
+            }
+        }
+
+        // 2. 映射 SQE 数组
+        m_nSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_pSqes = (io_uring_sqe *)::mmap(NULL, m_nSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_nRingFd, IORING_OFF_SQES);
+        if (m_pSqes == MAP_FAILED) {
+            m_pSqes = NULL;
+            Close();
+            return false;
+        }
+
+        m_pSqHead = (unsigned *)(m_pSqRing + params.sq_off.head);
+        m_pSqTail = (unsigned *)(m_pSqRing + params.sq_off.tail);
+        m_nSqMask = *(unsigned *)(m_pSqRing + params.sq_off.ring_mask);
+        m_nSqEntries = params.sq_entries;
+        m_pCqHead = (unsigned *)(m_pCqRing + params.cq_off.head);
+        m_pCqTail = (unsigned *)(m_pCqRing + params.cq_off.tail);
+        m_nCqMask = *(unsigned *)(m_pCqRing + params.cq_off.ring_mask);
+        m_pCqes = (io_uring_cqe *)(m_pCqRing + params.cq_off.cqes);
+
+        // SQ 索引数组采用恒等映射，之后无需再修改
+        unsigned *pArray = (unsigned *)(m_pSqRing + params.sq_off.array);
+        for (unsigned i = 0; i < m_nSqEntries; i++) {
+            pArray[i] = i;
+        }
+        m_nSqTail = *m_pSqTail;
+        m_nSqSubmitted = m_nSqTail;
+        return true;
+    }
+
+    void Close() {
+        if (m_pBufRing != NULL) {
+            ::munmap(m_pBufRing, m_nBufRingSize);
+            m_pBufRing = NULL;
+        }
+        if (m_pSqes != NULL) {
+            ::munmap(m_pSqes, m_nSqesSize);
+            m_pSqes = NULL;
+        }
+        if (m_pCqRing != NULL && m_pCqRing != m_pSqRing) {
+            ::munmap(m_pCqRing, m_nCqRingSize);
+        }
+        m_pCqRing = NULL;
+        if (m_pSqRing != NULL) {
+            ::munmap(m_pSqRing, m_nSqRingSize);
+            m_pSqRing = NULL;
+        }
+        if (m_nRingFd != -1) {
+            ::close(m_nRingFd);
+            m_nRingFd = -1;
+        }
+    }
+
+public:
+    // 取一个空闲 SQE（已清零），SQ 满时返回 NULL，调用方应先 Submit
+    io_uring_sqe *GetSqe() {
+        unsigned nHead = __atomic_load_n(m_pSqHead, __ATOMIC_ACQUIRE);
+        if (m_nSqTail - nHead >= m_nSqEntries) {
+            return NULL;
+        }
+        io_uring_sqe *pSqe = &m_pSqes[m_nSqTail & m_nSqMask];
+        memset(pSqe, 0, sizeof(io_uring_sqe));
+        m_nSqTail++;
+        return pSqe;
+    }
+
+    // 提交所有未提交的 SQE，并至少等待 nWaitNr 个完成事件
+    // 提交与等待合并为一次 io_uring_enter 系统调用
+    int Submit(unsigned nWaitNr) {
+        __atomic_store_n(m_pSqTail, m_nSqTail, __ATOMIC_RELEASE);
+        unsigned nToSubmit = m_nSqTail - m_nSqSubmitted;
+        unsigned nFlags = nWaitNr > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+        int nRet = (int)::syscall(__NR_io_uring_enter, m_nRingFd, nToSubmit, nWaitNr, nFlags, NULL, 0);
+        if (nRet >= 0) {
+            m_nSqSubmitted += nRet;
+        }
+        return nRet;
+    }
+
+    // 查看下一个完成事件，没有时返回 NULL
+    io_uring_cqe *PeekCqe() {
+        unsigned nHead = *m_pCqHead;
+        if (nHead == __atomic_load_n(m_pCqTail, __ATOMIC_ACQUIRE)) {
+            return NULL;
+        }
+        return &m_pCqes[nHead & m_nCqMask];
+    }
+
+    // 标记当前完成事件已处理
+    void SeenCqe() {
+        __atomic_store_n(m_pCqHead, *m_pCqHead + 1, __ATOMIC_RELEASE);
+    }
+
+public:
+    // 注册提供缓冲区环：nEntries（须为 2 的幂）个大小为 nBufSize 的缓冲区，起始地址为 pBufBase
+    // 接收时由内核从环中挑选缓冲区，完成事件中携带缓冲区编号 (bid)
+    bool RegisterBufRing(unsigned short nBufGroup, unsigned nEntries, char *pBufBase, unsigned nBufSize) {
+        m_nBufRingSize = nEntries * sizeof(io_uring_buf);
+        void *pRing = ::mmap(NULL, m_nBufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pRing == MAP_FAILED) {
+            return false;
+        }
+        // 注意：C++ 中 io_uring_buf_ring::bufs 的偏移与 C 不同（空结构体占 1 字节），
+        // 这里直接把环视为 io_uring_buf 数组，环尾与 bufs[0].resv 重叠
+        m_pBufRing = (io_uring_buf *)pRing;
+        memset(m_pBufRing, 0, m_nBufRingSize); // 环尾初始为 0
+
+        io_uring_buf_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = (unsigned long)m_pBufRing;
+        reg.ring_entries = nEntries;
+        reg.bgid = nBufGroup;
+        if (::syscall(__NR_io_uring_register, m_nRingFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+            int nErr = errno;
+            ::munmap(m_pBufRing, m_nBufRingSize);
+            m_pBufRing = NULL;
+            errno = nErr;
+            return false;
+        }
+
+        m_nBufRingMask = nEntries - 1;
+        m_nBufTail = 0;
+        m_nBufGroup = nBufGroup;
+        m_pBufBase = pBufBase;
+        m_nBufSize = nBufSize;
+        for (unsigned i = 0; i < nEntries; i++) {
+            AddBuffer((unsigned short)i);
+        }
+        CommitBuffers();
+        return true;
+    }
+
+    // 取得缓冲区编号对应的地址
+    char *GetBuffer(unsigned short nBid) {
+        return m_pBufBase + (size_t)nBid * m_nBufSize;
+    }
+
+    // 把缓冲区放回环中（需调用 CommitBuffers 后对内核可见）
+    void AddBuffer(unsigned short nBid) {
+        io_uring_buf *pBuf = &m_pBufRing[m_nBufTail & m_nBufRingMask];
+        pBuf->addr = (unsigned long)GetBuffer(nBid);
+        pBuf->len = m_nBufSize;
+        pBuf->bid = nBid;
+        m_nBufTail++;
+    }
+
+    void CommitBuffers() {
+        __atomic_store_n(&m_pBufRing[0].resv, (unsigned short)m_nBufTail, __ATOMIC_RELEASE);
+    }
+
+    unsigned short GetBufGroup() const {
+        return m_nBufGroup;
+    }
+
+public:
+    // 多次触发的 accept：一次提交，每个新连接产生一个完成事件
+    static void PrepMultishotAccept(io_uring_sqe *pSqe, int nListenSocket, unsigned long long nUserData) {
+        pSqe->opcode = IORING_OP_ACCEPT;
+        pSqe->fd = nListenSocket;
+        pSqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        pSqe->accept_flags = SOCK_CLOEXEC;
+        pSqe->user_data = nUserData;
+    }
+
+    // 多次触发的 recv：数据写入从缓冲区组 nBufGroup 中挑选的缓冲区
+    static void PrepMultishotRecv(io_uring_sqe *pSqe, int nSocket, unsigned short nBufGroup, unsigned long long nUserData) {
+        pSqe->opcode = IORING_OP_RECV;
+        pSqe->fd = nSocket;
+        pSqe->ioprio = IORING_RECV_MULTISHOT;
+        pSqe->flags = IOSQE_BUFFER_SELECT;
+        pSqe->buf_group = nBufGroup;
+        pSqe->user_data = nUserData;
+    }
+
+    // send：MSG_WAITALL 让内核在短写时继续发送，保证要么全部写出要么报错
+    static void PrepSend(io_uring_sqe *pSqe, int nSocket, const char *pBuf, unsigned nLen, unsigned long long nUserData) {
+        pSqe->opcode = IORING_OP_SEND;
+        pSqe->fd = nSocket;
+        pSqe->addr = (unsigned long)pBuf;
+        pSqe->len = nLen;
+        pSqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+        pSqe->user_data = nUserData;
+    }
+
+    // 取消 user_data 为 nTargetUserData 的请求（如停止一个多次触发的 recv），被取消的请求以 -ECANCELED 结束
+    static void PrepCancel(io_uring_sqe *pSqe, unsigned long long nTargetUserData, unsigned long long nUserData) {
+        pSqe->opcode = IORING_OP_ASYNC_CANCEL;
+        pSqe->fd = -1;
+        pSqe->addr = nTargetUserData;
+        pSqe->user_data = nUserData;
+    }
+
+private:
+    int m_nRingFd;
+
+    char *m_pSqRing;
+    char *m_pCqRing;
+    io_uring_sqe *m_pSqes;
+    size_t m_nSqRingSize;
+    size_t m_nCqRingSize;
+    size_t m_nSqesSize;
+
+    unsigned *m_pSqHead;
+    unsigned *m_pSqTail;
+    unsigned m_nSqMask;
+    unsigned m_nSqEntries;
+    unsigned m_nSqTail;      // 本地 SQ 尾指针，Submit 时才对内核可见
+    unsigned m_nSqSubmitted; // 已提交给内核的 SQE 计数
+
+    unsigned *m_pCqHead;
+    unsigned *m_pCqTail;
+    unsigned m_nCqMask;
+    io_uring_cqe *m_pCqes;
+
+    io_uring_buf *m_pBufRing;
+    size_t m_nBufRingSize;
+    unsigned m_nBufRingMask;
+    unsigned m_nBufTail;
+    unsigned short m_nBufGroup;
+    char *m_pBufBase;
+    unsigned m_nBufSize;
+};
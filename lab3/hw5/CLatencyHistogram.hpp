@@ -0,0 +1,120 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CLatencyHistogram.hpp
+ * 功能: HdrHistogram 风格的对数-线性延迟直方图
+ *       [0, 2^S) 线性计数；之后每个 2 的幂区间再均分为 2^(S-1) 个子桶，
+ *       相对误差不超过 1/2^(S-1)。记录为 O(1)，内存固定，可合并多个线程的结果
+ *************************************************************************/
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// 子桶精度位数，8 位对应相对误差 < 1%
+#define HISTOGRAM_SUB_BUCKET_BITS 8
+
+class CLatencyHistogram {
+public:
+    CLatencyHistogram() : m_vCounts(IndexOf(UINT64_MAX) + 1, 0), m_nCount(0), m_nSum(0), m_nMin(UINT64_MAX), m_nMax(0) {
+    }
+
+    void Record(uint64_t nValue) {
+        m_vCounts[IndexOf(nValue)]++;
+        m_nCount++;
+        m_nSum += nValue;
+        if (nValue < m_nMin) {
+            m_nMin = nValue;
+        }
+        if (nValue > m_nMax) {
+            m_nMax = nValue;
+        }
+    }
+
+    void Merge(const CLatencyHistogram &other) {
+        for (size_t i = 0; i < m_vCounts.size(); i++) {
+            m_vCounts[i] += other.m_vCounts[i];
+        }
+        m_nCount += other.m_nCount;
+        m_nSum += other.m_nSum;
+        if (other.m_nMin < m_nMin) {
+            m_nMin = other.m_nMin;
+        }
+        if (other.m_nMax > m_nMax) {
+            m_nMax = other.m_nMax;
+        }
+    }
+
+    // 返回第 dPercentile 百分位的值（所在桶的上界，不超过最大记录值）
+    uint64_t Percentile(double dPercentile) const {
+        if (m_nCount == 0) {
+            return 0;
+        }
+        uint64_t nTarget = (uint64_t)(dPercentile / 100.0 * m_nCount + 0.5);
+        if (nTarget < 1) {
+            nTarget = 1;
+        }
+        uint64_t nSeen = 0;
+        for (size_t i = 0; i < m_vCounts.size(); i++) {
+            nSeen += m_vCounts[i];
+            if (nSeen >= nTarget) {
+                uint64_t nValue = HighestEquivalent(i);
+                return nValue < m_nMax ? nValue : m_nMax;
+            }
+        }
+        return m_nMax;
+    }
+
+    uint64_t GetCount() const {
+        return m_nCount;
+    }
+
+    uint64_t GetMin() const {
+        return m_nCount > 0 ? m_nMin : 0;
+    }
+
+    uint64_t GetMax() const {
+        return m_nMax;
+    }
+
+    double GetMean() const {
+        return m_nCount > 0 ? (double)m_nSum / m_nCount : 0.0;
+    }
+
+    // 以微秒打印常用百分位（记录值单位为纳秒）
+    void PrintMicros(const char *pTitle) const {
+        printf("%s: count=%llu  min=%.1f  mean=%.1f  p50=%.1f  p90=%.1f  p99=%.1f  p999=%.1f  max=%.1f (us)\n",
+               pTitle, (unsigned long long)m_nCount, GetMin() / 1e3, GetMean() / 1e3,
+               Percentile(50) / 1e3, Percentile(90) / 1e3, Percentile(99) / 1e3,
+               Percentile(99.9) / 1e3, GetMax() / 1e3);
+    }
+
+private:
+    static const int SUB_BUCKET_BITS = HISTOGRAM_SUB_BUCKET_BITS;
+    static const uint64_t SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;
+    static const uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+
+    static size_t IndexOf(uint64_t nValue) {
+        if (nValue < SUB_BUCKET_COUNT) {
+            return (size_t)nValue;
+        }
+        int nExponent = (63 - __builtin_clzll(nValue)) - (SUB_BUCKET_BITS - 1);
+        uint64_t nSub = nValue >> nExponent; // 落在 [2^(S-1), 2^S)
+        return (size_t)(nExponent * SUB_BUCKET_HALF + nSub);
+    }
+
+    static uint64_t HighestEquivalent(size_t nIndex) {
+        if (nIndex < SUB_BUCKET_COUNT) {
+            return nIndex;
+        }
+        int nExponent = (int)(nIndex / SUB_BUCKET_HALF) - 1;
+        uint64_t nSub = nIndex - nExponent * SUB_BUCKET_HALF;
+        return ((nSub + 1) << nExponent) - 1;
+    }
+
+private:
+    std::vector<uint64_t> m_vCounts;
+    uint64_t m_nCount;
+    uint64_t m_nSum;
+    uint64_t m_nMin;
+    uint64_t m_nMax;
+};
@@ -0,0 +1,375 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CLoadGenerator.hpp
+ * 功能: 流水线压测客户端，适用于 lab3 中任一 Echo 服务端
+ *       每个线程以边缘触发 epoll 驱动若干连接，每条连接保持 nDepth 个请求在途；
+ *       未发出的请求数据合并为一次 send，回显字节按请求顺序（FIFO）确认完成
+ *       统计吞吐量以及 p50/p99/p999 延迟（CLatencyHistogram）
+ * 注意: 服务端逐条打印消息时终端输出会成为瓶颈，建议配合 splice / zerocopy 模式或重定向输出
+ *************************************************************************/
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "CLatencyHistogram.hpp"
+
+#define LOADGEN_MAX_EVENTS 256
+// 发送数据来源的循环缓冲区大小，单次 send 最多发送这么多字节
+#define LOADGEN_PATTERN_SIZE (256 * 1024)
+// 负载大小上限
+#define LOADGEN_MAX_PAYLOAD (1024 * 1024)
+// 停止发新请求后等待在途请求完成的最长时间
+#define LOADGEN_DRAIN_MS 2000
+
+// 负载大小分布
+// "N": 固定 N 字节；"A-B": [A, B] 均匀分布；"exp:M": 均值为 M 的指数分布
+class CPayloadSize {
+public:
+    CPayloadSize() : m_nType(FIXED), m_nA(64), m_nB(64) {
+    }
+
+    bool Parse(const std::string &strSpec) {
+        if (strSpec.compare(0, 4, "exp:") == 0) {
+            m_nType = EXPONENTIAL;
+            m_nA = strtoul(strSpec.c_str() + 4, NULL, 10);
+            return m_nA > 0;
+        }
+        size_t nDash = strSpec.find('-');
+        if (nDash != std::string::npos) {
+            m_nType = UNIFORM;
+            m_nA = strtoul(strSpec.substr(0, nDash).c_str(), NULL, 10);
+            m_nB = strtoul(strSpec.substr(nDash + 1).c_str(), NULL, 10);
+            return m_nA > 0 && m_nA <= m_nB;
+        }
+        m_nType = FIXED;
+        m_nA = m_nB = strtoul(strSpec.c_str(), NULL, 10);
+        return m_nA > 0;
+    }
+
+    size_t Next(std::mt19937_64 &rng) const {
+        size_t nSize = m_nA;
+        if (m_nType == UNIFORM) {
+            nSize = std::uniform_int_distribution<size_t>(m_nA, m_nB)(rng);
+        } else if (m_nType == EXPONENTIAL) {
+            nSize = (size_t)std::llround(std::exponential_distribution<double>(1.0 / m_nA)(rng));
+        }
+        if (nSize < 1) {
+            nSize = 1;
+        }
+        return nSize < LOADGEN_MAX_PAYLOAD ? nSize : LOADGEN_MAX_PAYLOAD;
+    }
+
+private:
+    enum { FIXED, UNIFORM, EXPONENTIAL } m_nType;
+    size_t m_nA;
+    size_t m_nB;
+};
+
+class CLoadGenerator {
+public:
+    struct CConfig {
+        std::string strServerIP;
+        int nServerPort;
+        int nConnections;   // 总连接数
+        int nDepth;         // 每条连接的在途请求数
+        int nSeconds;       // 压测时长
+        int nThreads;       // 驱动连接的线程数
+        CPayloadSize payload;
+    };
+
+    explicit CLoadGenerator(const CConfig &config) : m_config(config), m_dRequestsPerSecond(0) {
+        if (m_config.nThreads < 1) {
+            m_config.nThreads = 1;
+        }
+        if (m_config.nThreads > m_config.nConnections) {
+            m_config.nThreads = m_config.nConnections;
+        }
+        if (m_config.nDepth < 1) {
+            m_config.nDepth = 1;
+        }
+    }
+
+    virtual ~CLoadGenerator() {
+    }
+
+public:
+    int Run() {
+        if (m_config.nConnections < 1) {
+            fprintf(stderr, "[Error] connection count must be positive\n");
+            return -1;
+        }
+
+        printf("[LoadGen] %s:%d connections=%d depth=%d threads=%d duration=%ds\n", m_config.strServerIP.c_str(),
+               m_config.nServerPort, m_config.nConnections, m_config.nDepth, m_config.nThreads, m_config.nSeconds);
+
+        std::vector<CWorkerResult> vResults(m_config.nThreads);
+        std::vector<std::thread> vThreads;
+        auto tStart = std::chrono::steady_clock::now();
+        m_tDeadline = tStart + std::chrono::seconds(m_config.nSeconds);
+
+        for (int i = 0; i < m_config.nThreads; i++) {
+            // 连接尽量均分到各线程
+            int nConns = m_config.nConnections / m_config.nThreads + (i < m_config.nConnections % m_config.nThreads ? 1 : 0);
+            vThreads.emplace_back(&CLoadGenerator::WorkerLoop, this, i, nConns, std::ref(vResults[i]));
+        }
+        for (auto &worker : vThreads) {
+            worker.join();
+        }
+        double dElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
+
+        m_histogram = CLatencyHistogram();
+        uint64_t nBytes = 0;
+        int nErrors = 0;
+        for (auto &result : vResults) {
+            m_histogram.Merge(result.histogram);
+            nBytes += result.nBytes;
+            nErrors += result.nErrors;
+        }
+        m_dRequestsPerSecond = m_histogram.GetCount() / dElapsed;
+
+        printf("[LoadGen] requests=%llu  %.0f req/s  %.2f MB/s  connection errors=%d\n",
+               (unsigned long long)m_histogram.GetCount(), m_dRequestsPerSecond,
+               nBytes / dElapsed / (1024.0 * 1024.0), nErrors);
+        m_histogram.PrintMicros("[LoadGen] latency");
+        return 0;
+    }
+
+    // 最近一次 Run 的结果
+    const CLatencyHistogram &GetHistogram() const {
+        return m_histogram;
+    }
+
+    double GetRequestsPerSecond() const {
+        return m_dRequestsPerSecond;
+    }
+
+private:
+    struct CRequest {
+        size_t nRemaining;   // 尚未收到回显的字节数
+        std::chrono::steady_clock::time_point tStart;
+    };
+
+    struct CConnection {
+        int fd;
+        bool bClosed;
+        size_t nUnsent;      // 已入队但尚未写出的字节数
+        uint64_t nSendOffset;// 已写出的总字节数，决定下次从模式缓冲区哪里取数据
+        std::deque<CRequest> dqInflight;
+    };
+
+    struct CWorkerResult {
+        CLatencyHistogram histogram;
+        uint64_t nBytes;
+        int nErrors;
+        CWorkerResult() : nBytes(0), nErrors(0) {
+        }
+    };
+
+    void WorkerLoop(int nIndex, int nConns, CWorkerResult &result) {
+        std::mt19937_64 rng(0x9E3779B97F4A7C15ULL + nIndex);
+        std::vector<char> vPattern(LOADGEN_PATTERN_SIZE);
+        for (size_t i = 0; i < vPattern.size(); i++) {
+            vPattern[i] = 'a' + i % 26;
+        }
+        std::vector<char> vRecv(LOADGEN_PATTERN_SIZE);
+
+        int nEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+        std::vector<CConnection> vConns(nConns);
+        int nOpen = 0;
+        for (int i = 0; i < nConns; i++) {
+            CConnection &conn = vConns[i];
+            conn.bClosed = true;
+            conn.nUnsent = 0;
+            conn.nSendOffset = 0;
+            conn.fd = Connect();
+            if (conn.fd == -1) {
+                result.nErrors++;
+                continue;
+            }
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.u32 = i;
+            ::epoll_ctl(nEpoll, EPOLL_CTL_ADD, conn.fd, &ev);
+            conn.bClosed = false;
+            nOpen++;
+            TopUp(conn, rng);
+        }
+
+        epoll_event events[LOADGEN_MAX_EVENTS];
+        bool bStopping = false;
+        auto tDrainDeadline = m_tDeadline;
+        while (nOpen > 0) {
+            auto tNow = std::chrono::steady_clock::now();
+            if (!bStopping && tNow >= m_tDeadline) {
+                // 到时后不再发新请求，等待在途请求完成
+                bStopping = true;
+                tDrainDeadline = tNow + std::chrono::milliseconds(LOADGEN_DRAIN_MS);
+                for (auto &conn : vConns) {
+                    if (!conn.bClosed && conn.dqInflight.empty()) {
+                        CloseConnection(conn, nOpen);
+                    }
+                }
+                continue;
+            }
+            if (bStopping && tNow >= tDrainDeadline) {
+                break;
+            }
+
+            int nReady = ::epoll_wait(nEpoll, events, LOADGEN_MAX_EVENTS, 50);
+            if (nReady == -1 && errno != EINTR) {
+                perror("epoll_wait");
+                break;
+            }
+            for (int i = 0; i < nReady; i++) {
+                CConnection &conn = vConns[events[i].data.u32];
+                if (conn.bClosed) {
+                    continue;
+                }
+                if (!ReadEchoes(conn, vRecv, result) || !Flush(conn, vPattern)) {
+                    result.nErrors++;
+                    CloseConnection(conn, nOpen);
+                    continue;
+                }
+                if (!bStopping) {
+                    TopUp(conn, rng);
+                    if (!Flush(conn, vPattern)) {
+                        result.nErrors++;
+                        CloseConnection(conn, nOpen);
+                    }
+                } else if (conn.dqInflight.empty()) {
+                    CloseConnection(conn, nOpen);
+                }
+            }
+        }
+
+        for (auto &conn : vConns) {
+            if (!conn.bClosed) {
+                CloseConnection(conn, nOpen);
+            }
+        }
+        ::close(nEpoll);
+    }
+
+    int Connect() {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            perror("socket");
+            return -1;
+        }
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(m_config.nServerPort);
+        if (::inet_pton(AF_INET, m_config.strServerIP.c_str(), &addr.sin_addr) != 1
+            || ::connect(fd, (sockaddr *)&addr, sizeof(addr)) == -1) {
+            perror("connect");
+            ::close(fd);
+            return -1;
+        }
+        // 流水线中的小请求不能被 Nagle 算法延迟
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        return fd;
+    }
+
+    // 补足在途请求到 nDepth 个
+    void TopUp(CConnection &conn, std::mt19937_64 &rng) {
+        while ((int)conn.dqInflight.size() < m_config.nDepth) {
+            CRequest request;
+            request.nRemaining = m_config.payload.Next(rng);
+            request.tStart = std::chrono::steady_clock::now();
+            conn.nUnsent += request.nRemaining;
+            conn.dqInflight.push_back(request);
+        }
+    }
+
+    // 把所有未写出的请求字节一次性写出，直到写完或发送缓冲区满
+    static bool Flush(CConnection &conn, const std::vector<char> &vPattern) {
+        while (conn.nUnsent > 0) {
+            size_t nOffset = conn.nSendOffset % vPattern.size();
+            size_t nLen = vPattern.size() - nOffset;
+            if (nLen > conn.nUnsent) {
+                nLen = conn.nUnsent;
+            }
+            ssize_t n = ::send(conn.fd, &vPattern[nOffset], nLen, MSG_NOSIGNAL);
+            if (n > 0) {
+                conn.nUnsent -= n;
+                conn.nSendOffset += n;
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 读取回显，按 FIFO 顺序把字节记到在途请求上，收齐的请求记录延迟
+    static bool ReadEchoes(CConnection &conn, std::vector<char> &vRecv, CWorkerResult &result) {
+        while (true) {
+            ssize_t n = ::recv(conn.fd, vRecv.data(), vRecv.size(), 0);
+            if (n > 0) {
+                size_t nLeft = n;
+                auto tNow = std::chrono::steady_clock::now();
+                while (nLeft > 0 && !conn.dqInflight.empty()) {
+                    CRequest &head = conn.dqInflight.front();
+                    size_t nTake = nLeft < head.nRemaining ? nLeft : head.nRemaining;
+                    head.nRemaining -= nTake;
+                    nLeft -= nTake;
+                    result.nBytes += nTake;
+                    if (head.nRemaining == 0) {
+                        uint64_t nNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(tNow - head.tStart).count();
+                        result.histogram.Record(nNanos);
+                        conn.dqInflight.pop_front();
+                    }
+                }
+                if (nLeft > 0) {
+                    // 收到的字节多于发出的，说明服务端不是 Echo
+                    fprintf(stderr, "[Error] unexpected extra bytes from server\n");
+                    return false;
+                }
+            } else if (n == 0) {
+                return false;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            } else if (errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    static void CloseConnection(CConnection &conn, int &nOpen) {
+        ::close(conn.fd);
+        conn.bClosed = true;
+        nOpen--;
+    }
+
+private:
+    CConfig m_config;
+    std::chrono::steady_clock::time_point m_tDeadline;
+    CLatencyHistogram m_histogram;
+    double m_dRequestsPerSecond;
+};
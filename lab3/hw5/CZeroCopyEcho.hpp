@@ -0,0 +1,382 @@
+#pragma once
+
+/*************************************************************************
+ * 文件名: CZeroCopyEcho.hpp
+ * 功能: 零拷贝 Echo 业务类，可像 CMyTCPServer 一样织入 CTCPServer 切面
+ *       CSpliceEchoServer:   socket -> pipe -> socket，数据始终留在内核中
+ *       CZeroCopyEchoServer: 大块数据以 MSG_ZEROCOPY 发送，通过错误队列的完成通知
+ *                            确认内核不再引用缓冲区后才复用它
+ *       套接字写不下时剩余数据拷贝一份交给 CSendQueue，回复积压超过上限时暂停读取
+ * 注意: 两个类都按单线程事件循环设计，不能被多个线程并发调用
+ *************************************************************************/
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/CSendQueue.hpp"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+// 单次 splice / recv 的数据块大小
+#define ZEROCOPY_CHUNK_SIZE (64 * 1024)
+// 不小于该大小的数据块才使用 MSG_ZEROCOPY，小块数据直接拷贝更便宜
+#define ZEROCOPY_THRESHOLD (16 * 1024)
+
+// -----------------------------------------------------------
+// splice 零拷贝 Echo：套接字数据先移入管道，再从管道移到套接字
+// 每次 ServerFunction 返回前管道都会被排空，因此所有连接可共用一个管道
+// -----------------------------------------------------------
+class CSpliceEchoServer {
+public:
+    CSpliceEchoServer() : m_vCopyBuffer(ZEROCOPY_CHUNK_SIZE) {
+        OpenPipe();
+    }
+
+    virtual ~CSpliceEchoServer() {
+        ClosePipe();
+    }
+
+    // 每次套接字可读时被调用，返回 true 保持连接，返回 false 由切面关闭连接
+    // 回复积压超过上限时暂停读取，积压写出后切面会再次调用
+    bool ServerFunction(int nConnectedSocket, int /*nListenSocket*/) {
+        if (m_pipe[0] == -1) {
+            return false;
+        }
+
+        while (!CSendQueue::IsBacklogged(nConnectedSocket)) {
+            ssize_t nIn = ::splice(nConnectedSocket, NULL, m_pipe[1], NULL, ZEROCOPY_CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (nIn > 0) {
+                if (!DrainPipe(nConnectedSocket, (size_t)nIn)) {
+                    // 管道中可能残留本连接的数据，重建管道避免串到其他连接
+                    ClosePipe();
+                    OpenPipe();
+                    return false;
+                }
+            } else if (nIn == 0) {
+                return false;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            } else if (errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    // 把管道中的 nLen 字节全部移出，返回前管道总是被排空
+    // 事件循环中套接字写不下（或连接已有积压）时，剩余数据读回用户态交给 CSendQueue，不等待可写
+    bool DrainPipe(int nSocket, size_t nLen) {
+        bool bCopy = CSendQueue::HasPending(nSocket);
+        while (nLen > 0 && !bCopy) {
+            ssize_t nOut = ::splice(m_pipe[0], NULL, nSocket, NULL, nLen, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (nOut > 0) {
+                nLen -= nOut;
+            } else if (nOut == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (CSendQueue::IsAttached(nSocket)) {
+                    bCopy = true;
+                } else {
+                    pollfd pfd = {nSocket, POLLOUT, 0};
+                    ::poll(&pfd, 1, -1);
+                }
+            } else if (nOut == -1 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+
+        while (nLen > 0) {
+            size_t nChunk = nLen < m_vCopyBuffer.size() ? nLen : m_vCopyBuffer.size();
+            ssize_t nIn = ::read(m_pipe[0], m_vCopyBuffer.data(), nChunk);
+            if (nIn > 0) {
+                if (!CSendQueue::Send(nSocket, m_vCopyBuffer.data(), (size_t)nIn)) {
+                    return false;
+                }
+                nLen -= nIn;
+            } else if (nIn == -1 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void OpenPipe() {
+        if (::pipe2(m_pipe, O_CLOEXEC) == -1) {
+            perror("pipe2");
+            m_pipe[0] = m_pipe[1] = -1;
+            return;
+        }
+        ::fcntl(m_pipe[1], F_SETPIPE_SZ, ZEROCOPY_CHUNK_SIZE);
+    }
+
+    void ClosePipe() {
+        if (m_pipe[0] != -1) {
+            ::close(m_pipe[0]);
+            ::close(m_pipe[1]);
+            m_pipe[0] = m_pipe[1] = -1;
+        }
+    }
+
+private:
+    int m_pipe[2];
+    std::vector<char> m_vCopyBuffer; // 套接字写不下时从管道读回数据的中转缓冲区
+};
+
+// -----------------------------------------------------------
+// MSG_ZEROCOPY Echo：发送时内核直接引用用户缓冲区的页面
+// 每次成功的零拷贝 send 占用一个递增的序号，完成通知以 [lo, hi] 序号区间
+// 出现在套接字错误队列中（epoll 上表现为 EPOLLERR），区间覆盖后缓冲区才可复用
+// -----------------------------------------------------------
+class CZeroCopyEchoServer {
+public:
+    // 完成通知统计，用于确认内核是否真的走了零拷贝（回环设备上内核会退化为拷贝）
+    struct CStats {
+        uint64_t nZeroCopySends;   // 带 MSG_ZEROCOPY 的 send 次数
+        uint64_t nCopySends;       // 小块数据或 ENOBUFS 时的普通 send 次数
+        uint64_t nCompletions;     // 收到的完成序号个数
+        uint64_t nCopiedByKernel;  // 其中被内核标记为 SO_EE_CODE_ZEROCOPY_COPIED 的个数
+    };
+
+    CZeroCopyEchoServer() {
+        m_stats = CStats();
+    }
+
+    virtual ~CZeroCopyEchoServer() {
+    }
+
+    // 每次套接字可读（或错误队列中有完成通知）时被调用
+    // 回复积压超过上限时暂停读取，积压写出后切面会再次调用
+    bool ServerFunction(int nConnectedSocket, int /*nListenSocket*/) {
+        CConnection &conn = GetConnection(nConnectedSocket);
+        ReapCompletions(nConnectedSocket, conn);
+        if (conn.bClosing) {
+            return CloseConnection(nConnectedSocket);
+        }
+
+        while (!CSendQueue::IsBacklogged(nConnectedSocket)) {
+            std::unique_ptr<char[]> pBuf = AcquireBuffer();
+            ssize_t bytesRead = ::read(nConnectedSocket, pBuf.get(), ZEROCOPY_CHUNK_SIZE);
+
+            if (bytesRead > 0) {
+                if (!SendChunk(nConnectedSocket, conn, std::move(pBuf), (size_t)bytesRead)) {
+                    return CloseConnection(nConnectedSocket);
+                }
+            } else {
+                m_vFreeBuffers.push_back(std::move(pBuf));
+                if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    return true;
+                }
+                if (bytesRead == -1 && errno == EINTR) {
+                    continue;
+                }
+                return CloseConnection(nConnectedSocket);
+            }
+        }
+        return true;
+    }
+
+    const CStats &GetStats() const {
+        return m_stats;
+    }
+
+private:
+    // 一个仍被内核引用的缓冲区及其占用的序号区间
+    struct CInflight {
+        uint32_t nFirstSeq;
+        uint32_t nLastSeq;
+        uint32_t nPending; // 尚未收到完成通知的序号个数（各完成区间互不重叠）
+        std::unique_ptr<char[]> pBuf;
+    };
+
+    struct CConnection {
+        uint32_t nNextSeq;
+        bool bClosing; // 对端已关闭或出错，等待在途缓冲区的完成通知后再关闭
+        std::vector<CInflight> vInflight;
+    };
+
+    CConnection &GetConnection(int nSocket) {
+        auto it = m_mapConnections.find(nSocket);
+        if (it != m_mapConnections.end()) {
+            return it->second;
+        }
+        int on = 1;
+        if (::setsockopt(nSocket, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == -1) {
+            perror("setsockopt SO_ZEROCOPY");
+        }
+        CConnection &conn = m_mapConnections[nSocket];
+        conn.nNextSeq = 0;
+        conn.bClosing = false;
+        return conn;
+    }
+
+    std::unique_ptr<char[]> AcquireBuffer() {
+        if (m_vFreeBuffers.empty()) {
+            return std::unique_ptr<char[]>(new char[ZEROCOPY_CHUNK_SIZE]);
+        }
+        std::unique_ptr<char[]> pBuf = std::move(m_vFreeBuffers.back());
+        m_vFreeBuffers.pop_back();
+        return pBuf;
+    }
+
+    // 发送一个数据块：大块使用 MSG_ZEROCOPY 并把缓冲区挂到在途列表，小块直接拷贝发送
+    // 事件循环中套接字写不下（或连接已有积压）时，剩余部分拷贝一份交给 CSendQueue，不等待可写
+    bool SendChunk(int nSocket, CConnection &conn, std::unique_ptr<char[]> pBuf, size_t nLen) {
+        bool bZeroCopy = nLen >= ZEROCOPY_THRESHOLD;
+        uint32_t nFirstSeq = conn.nNextSeq;
+        size_t nOffset = 0;
+        bool bOk = true;
+        bool bCopy = CSendQueue::HasPending(nSocket);
+
+        while (nOffset < nLen && !bCopy) {
+            int nFlags = MSG_NOSIGNAL | (bZeroCopy ? MSG_ZEROCOPY : 0);
+            ssize_t nSent = ::send(nSocket, pBuf.get() + nOffset, nLen - nOffset, nFlags);
+            if (nSent > 0) {
+                nOffset += nSent;
+                if (bZeroCopy) {
+                    conn.nNextSeq++;
+                    m_stats.nZeroCopySends++;
+                } else {
+                    m_stats.nCopySends++;
+                }
+            } else if (nSent == -1 && errno == ENOBUFS && bZeroCopy) {
+                // 超出 optmem 限制：剩余部分退化为普通拷贝发送
+                bZeroCopy = false;
+            } else if (nSent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (CSendQueue::IsAttached(nSocket)) {
+                    bCopy = true;
+                } else {
+                    pollfd pfd = {nSocket, POLLOUT, 0};
+                    ::poll(&pfd, 1, -1);
+                    ReapCompletions(nSocket, conn);
+                }
+            } else if (nSent == -1 && errno == EINTR) {
+                continue;
+            } else {
+                bOk = false;
+                break;
+            }
+        }
+        if (bOk && nOffset < nLen) {
+            bOk = CSendQueue::Send(nSocket, pBuf.get() + nOffset, nLen - nOffset);
+        }
+
+        // 出错时也要登记已经零拷贝发出的部分：内核仍可能引用缓冲区
+
+        uint32_t nSeqs = conn.nNextSeq - nFirstSeq;
+        if (nSeqs == 0) {
+            m_vFreeBuffers.push_back(std::move(pBuf));
+        } else {
+            CInflight inflight;
+            inflight.nFirstSeq = nFirstSeq;
+            inflight.nLastSeq = conn.nNextSeq - 1;
+            inflight.nPending = nSeqs;
+            inflight.pBuf = std::move(pBuf);
+            conn.vInflight.push_back(std::move(inflight));
+        }
+        return bOk;
+    }
+
+    // 读取错误队列中的全部完成通知，回收序号区间已全部完成的缓冲区
+    void ReapCompletions(int nSocket, CConnection &conn) {
+        while (!conn.vInflight.empty()) {
+            char control[128];
+            msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if (::recvmsg(nSocket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+                break;
+            }
+
+            for (cmsghdr *pCmsg = CMSG_FIRSTHDR(&msg); pCmsg != NULL; pCmsg = CMSG_NXTHDR(&msg, pCmsg)) {
+                bool bRecvErr = (pCmsg->cmsg_level == SOL_IP && pCmsg->cmsg_type == IP_RECVERR)
+                                || (pCmsg->cmsg_level == SOL_IPV6 && pCmsg->cmsg_type == IPV6_RECVERR);
+                if (!bRecvErr) {
+                    continue;
+                }
+                sock_extended_err *pErr = (sock_extended_err *)CMSG_DATA(pCmsg);
+                if (pErr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || pErr->ee_errno != 0) {
+                    continue;
+                }
+
+                uint32_t nLo = pErr->ee_info;
+                uint32_t nHi = pErr->ee_data;
+                uint64_t nCount = (uint64_t)(nHi - nLo) + 1;
+                m_stats.nCompletions += nCount;
+                if (pErr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                    m_stats.nCopiedByKernel += nCount;
+                }
+
+                // 完成区间与每个在途缓冲区的序号区间求交集
+                for (auto &inflight : conn.vInflight) {
+                    uint32_t nFrom = nLo > inflight.nFirstSeq ? nLo : inflight.nFirstSeq;
+                    uint32_t nTo = nHi < inflight.nLastSeq ? nHi : inflight.nLastSeq;
+                    if (nFrom <= nTo) {
+                        inflight.nPending -= (nTo - nFrom + 1);
+                    }
+                }
+            }
+
+            // 回收已全部完成的缓冲区
+            for (size_t i = 0; i < conn.vInflight.size();) {
+                if (conn.vInflight[i].nPending == 0) {
+                    m_vFreeBuffers.push_back(std::move(conn.vInflight[i].pBuf));
+                    conn.vInflight[i] = std::move(conn.vInflight.back());
+                    conn.vInflight.pop_back();
+                } else {
+                    i++;
+                }
+            }
+        }
+    }
+
+    // 连接需要关闭：返回值即 ServerFunction 的返回值
+    // 完成通知只能从仍然打开的套接字的错误队列中读取，关闭后内核可能仍在发送在途缓冲区中的数据，
+    // 因此还有在途缓冲区时推迟关闭：通知到达时（EPOLLERR）切面会再次调用 ServerFunction，全部回收后才返回 false
+    bool CloseConnection(int nSocket) {
+        auto it = m_mapConnections.find(nSocket);
+        if (it == m_mapConnections.end()) {
+            return false;
+        }
+        CConnection &conn = it->second;
+        conn.bClosing = true;
+        ReapCompletions(nSocket, conn);
+
+        // 不在事件循环中时没有人会再次调用，直接等待错误队列可读（POLLERR 总会报告）
+        while (!conn.vInflight.empty() && !CSendQueue::IsAttached(nSocket)) {
+            pollfd pfd = {nSocket, 0, 0};
+            ::poll(&pfd, 1, -1);
+            ReapCompletions(nSocket, conn);
+        }
+        if (!conn.vInflight.empty()) {
+            return true;
+        }
+        m_mapConnections.erase(it);
+        return false;
+    }
+
+private:
+    std::unordered_map<int, CConnection> m_mapConnections;
+    std::vector<std::unique_ptr<char[]>> m_vFreeBuffers;
+    CStats m_stats;
+};
@@ -0,0 +1,215 @@
+/*************************************************************************
+ * 文件名: bench_zerocopy.cpp
+ * 功能: 大块数据 Echo 基准测试，比较拷贝通路与零拷贝通路每 GB 消耗的服务端 CPU 时间
+ *       copy-1k:  与 CMyTCPServer::ServerFunction 相同的 read/write 通路（去掉打印）
+ *       copy-64k: 同上，但使用 64KB 缓冲区，用于区分系统调用次数与内存拷贝的开销
+ *       splice:   CSpliceEchoServer
+ *       zerocopy: CZeroCopyEchoServer
+ * 用法: ./bench-zerocopy-hw5 [MB，默认 1024]
+ * 注意: 回环设备上 MSG_ZEROCOPY 的数据在内核中仍会被拷贝（完成通知带 COPIED 标记），
+ *       真实网卡上才能体现全部收益
+ *************************************************************************/
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "CZeroCopyEcho.hpp"
+
+#define MAX_EPOLL_EVENTS 16
+#define CLIENT_CHUNK_SIZE (1024 * 1024)
+
+// 拷贝通路基线：逐块 read 到用户缓冲区，再 write 回去
+template <size_t BufferSize>
+class CCopyEchoServer {
+public:
+    bool ServerFunction(int nConnectedSocket, int /*nListenSocket*/) {
+        static char buf[BufferSize];
+        while (true) {
+            ssize_t bytesRead = ::read(nConnectedSocket, buf, BufferSize);
+            if (bytesRead > 0) {
+                if (!WriteAll(nConnectedSocket, buf, bytesRead)) {
+                    return false;
+                }
+            } else if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else if (bytesRead == -1 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+    }
+
+private:
+    static bool WriteAll(int nSocket, const char *pData, size_t nLen) {
+        while (nLen > 0) {
+            ssize_t n = ::send(nSocket, pData, nLen, MSG_NOSIGNAL);
+            if (n > 0) {
+                pData += n;
+                nLen -= n;
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd pfd = {nSocket, POLLOUT, 0};
+                ::poll(&pfd, 1, -1);
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static double ThreadCpuSeconds() {
+    timespec ts;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 服务端线程：接受一个连接，以边缘触发 epoll 驱动业务类，直到业务类要求关闭
+template <typename Business>
+static void ServeOne(Business &business, int nListenSocket, double &dCpuSeconds) {
+    int nConnectedSocket = ::accept4(nListenSocket, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (nConnectedSocket == -1) {
+        perror("accept4");
+        return;
+    }
+
+    double dStart = ThreadCpuSeconds();
+    int nEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    ev.data.fd = nConnectedSocket;
+    ::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nConnectedSocket, &ev);
+
+    bool bKeepAlive = true;
+    epoll_event events[MAX_EPOLL_EVENTS];
+    while (bKeepAlive) {
+        int nReady = ::epoll_wait(nEpoll, events, MAX_EPOLL_EVENTS, -1);
+        if (nReady == -1 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < nReady && bKeepAlive; i++) {
+            bKeepAlive = business.ServerFunction(nConnectedSocket, nListenSocket);
+        }
+    }
+    dCpuSeconds = ThreadCpuSeconds() - dStart;
+
+    ::close(nEpoll);
+    ::close(nConnectedSocket);
+}
+
+// 额外输出业务类自身的统计，默认无
+template <typename Business>
+static void PrintStats(const Business &) {
+}
+
+static void PrintStats(const CZeroCopyEchoServer &business) {
+    const CZeroCopyEchoServer::CStats &stats = business.GetStats();
+    printf("           zerocopy sends=%llu  copy sends=%llu  completions=%llu  copied by kernel=%llu\n",
+           (unsigned long long)stats.nZeroCopySends, (unsigned long long)stats.nCopySends,
+           (unsigned long long)stats.nCompletions, (unsigned long long)stats.nCopiedByKernel);
+}
+
+// 运行一轮测试：客户端一边发送 nTotalBytes，一边接收回显
+template <typename Business>
+static void RunBench(const char *pName, size_t nTotalBytes) {
+    int nListenSocket = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t nAddrLen = sizeof(addr);
+    if (::bind(nListenSocket, (sockaddr *)&addr, sizeof(addr)) == -1 || ::listen(nListenSocket, 1) == -1
+        || ::getsockname(nListenSocket, (sockaddr *)&addr, &nAddrLen) == -1) {
+        perror("listen");
+        ::close(nListenSocket);
+        return;
+    }
+
+    Business business;
+    double dServerCpu = 0;
+    std::thread server(ServeOne<Business>, std::ref(business), nListenSocket, std::ref(dServerCpu));
+
+    int nClientSocket = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (::connect(nClientSocket, (sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror("connect");
+        ::close(nClientSocket);
+        ::shutdown(nListenSocket, SHUT_RDWR);
+        server.join();
+        ::close(nListenSocket);
+        return;
+    }
+
+    auto tStart = std::chrono::steady_clock::now();
+
+    // 发送线程：发完后半关闭，服务端读到 EOF 后结束
+    std::thread writer([nClientSocket, nTotalBytes]() {
+        std::vector<char> vChunk(CLIENT_CHUNK_SIZE, 'z');
+        size_t nSent = 0;
+        while (nSent < nTotalBytes) {
+            size_t nLen = nTotalBytes - nSent < vChunk.size() ? nTotalBytes - nSent : vChunk.size();
+            ssize_t n = ::send(nClientSocket, vChunk.data(), nLen, MSG_NOSIGNAL);
+            if (n <= 0) {
+                if (n == -1 && errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            nSent += n;
+        }
+        ::shutdown(nClientSocket, SHUT_WR);
+    });
+
+    std::vector<char> vRecv(CLIENT_CHUNK_SIZE);
+    size_t nReceived = 0;
+    while (nReceived < nTotalBytes) {
+        ssize_t n = ::recv(nClientSocket, vRecv.data(), vRecv.size(), 0);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        nReceived += n;
+    }
+
+    writer.join();
+    double dWall = std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
+    ::close(nClientSocket);
+    server.join();
+    ::close(nListenSocket);
+
+    double dGB = nReceived / (1024.0 * 1024.0 * 1024.0);
+    printf("%-10s %8.2f GB  wall=%7.3fs  %7.2f GB/s  server cpu=%7.3fs  %7.3f cpu-s/GB%s\n",
+           pName, dGB, dWall, dGB / dWall, dServerCpu, dGB > 0 ? dServerCpu / dGB : 0.0,
+           nReceived == nTotalBytes ? "" : "  [incomplete]");
+    PrintStats(business);
+}
+
+int main(int argc, char **argv) {
+    size_t nMegaBytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 1024;
+    if (nMegaBytes == 0) {
+        nMegaBytes = 1024;
+    }
+    size_t nTotalBytes = nMegaBytes * 1024 * 1024;
+
+    RunBench<CCopyEchoServer<1024>>("copy-1k", nTotalBytes);
+    RunBench<CCopyEchoServer<64 * 1024>>("copy-64k", nTotalBytes);
+    RunBench<CSpliceEchoServer>("splice", nTotalBytes);
+    RunBench<CZeroCopyEchoServer>("zerocopy", nTotalBytes);
+    return 0;
+}
@@ -12,6 +12,9 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "CFraming.hpp"
+#include "CLoadGenerator.hpp"
+
 #define MAX_BUFFER_SIZE 1024
 #define SERVER_PORT 5000
 #define SERVER_IP "127.0.0.1"
@@ -135,7 +138,61 @@ public:
     }
 };
 
-int main() {
+// -----------------------------------------------------------
+// 核心业务类：CMyFramedClient
+// 职责：与 CMyTCPClient 相同的交互，但以完整消息收发，织入 CFramedClient 分帧切面
+// -----------------------------------------------------------
+class CMyFramedClient {
+public:
+    void OnConnected(CFramedChannel &channel) {
+        std::string strLine;
+        std::string strEcho;
+
+        std::cout << "Please input message (type 'quit' to exit):" << std::endl;
+
+        while (true) {
+            std::cout << "Input: ";
+            if (!std::getline(std::cin, strLine) || strLine == "quit") {
+                break;
+            }
+
+            // 消息长度不再受固定缓冲区限制
+            channel.Send(strLine.data(), strLine.size());
+            if (!channel.Recv(strEcho)) {
+                std::cout << "[Client] Server disconnected." << std::endl;
+                break;
+            }
+            std::cout << "Echo from Server: " << strEcho << std::endl;
+        }
+    }
+};
+
+int main(int argc, char **argv) {
+    // 压测模式: ./client-hw5 load [连接数] [在途深度] [秒数] [负载大小: N | A-B | exp:M] [线程数]
+    if (argc > 1 && strcmp(argv[1], "load") == 0) {
+        CLoadGenerator::CConfig config;
+        config.strServerIP = SERVER_IP;
+        config.nServerPort = SERVER_PORT;
+        config.nConnections = argc > 2 ? atoi(argv[2]) : 64;
+        config.nDepth = argc > 3 ? atoi(argv[3]) : 8;
+        config.nSeconds = argc > 4 ? atoi(argv[4]) : 10;
+        if (argc > 5 && !config.payload.Parse(argv[5])) {
+            std::cerr << "[Error] invalid payload size: " << argv[5] << std::endl;
+            return 1;
+        }
+        config.nThreads = argc > 6 ? atoi(argv[6]) : 1;
+
+        CLoadGenerator generator(config);
+        return generator.Run() == 0 ? 0 : 1;
+    }
+
+    // 传入 "framed" 参数时使用长度前缀分帧协议，需配合 ./server-hw5 framed
+    if (argc > 1 && strcmp(argv[1], "framed") == 0) {
+        CTCPClient<CFramedClient<CMyFramedClient>> client(SERVER_PORT, SERVER_IP);
+        client.Run();
+        return 0;
+    }
+
     // AOP 组合：客户端业务 + 网络连接框架
     // 注意：这里端口修改为 5000 以匹配服务端
     CTCPClient<CMyTCPClient> client(SERVER_PORT, SERVER_IP);
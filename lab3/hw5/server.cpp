@@ -4,16 +4,35 @@
  * 功能: 封装TCP服务端，分离连接逻辑(Aspect)与业务逻辑(Core)，实现Echo服务
  *************************************************************************/
 #include <arpa/inet.h>
+#include <cerrno>
 #include <cstdio>
+#include <fcntl.h>
 #include <iostream>
 #include <netinet/in.h>
 #include <signal.h>
 #include <string.h>
 #include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
 #include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/CSendQueue.hpp"
+#include "CFraming.hpp"
+#include "CIoUring.hpp"
+#include "CZeroCopyEcho.hpp"
 
 #define MAX_BUFFER_SIZE 1024
 #define DEFAULT_PORT 5000
+#define MAX_EPOLL_EVENTS 256
+// io_uring 提交队列深度与提供缓冲区个数（须为 2 的幂）
+#define URING_ENTRIES 1024
+#define URING_BUFFER_COUNT 1024
+// 单个连接最多占用的提供缓冲区个数（待发送 + 发送中），达到后暂停该连接的 recv，
+// 防止只发不收的客户端占满整个缓冲区环，使其他连接收到 ENOBUFS
+// 取消生效前内核仍可能为该连接多填充一批缓冲区，因此上限取缓冲区总数的一小部分
+#define URING_CONN_BUFFER_LIMIT (URING_BUFFER_COUNT / 32)
 
 // -----------------------------------------------------------
 // AOP 切面类：CTCPServer
@@ -41,11 +60,195 @@ public:
     }
 
 public:
-    // 运行连接逻辑（Aspect Logic）
+    // 运行连接逻辑（Aspect Logic），阻塞兼容模式：一次只服务一个客户端
     int Run() {
         // 忽略 SIGPIPE 信号，防止客户端异常断开导致服务端退出
         signal(SIGPIPE, SIG_IGN);
 
+        int nListenSocket = CreateListenSocket();
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+
+        // 4. 循环处理连接
+        while (true) {
+            sockaddr_in ClientAddress;
+            socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+
+            // 阻塞等待连接
+            int nConnectedSocket = ::accept(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress);
+            if (-1 == nConnectedSocket) {
+                perror("accept");
+                continue;
+            }
+
+            // 打印客户端信息
+            char clientIP[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+            std::cout << "[Server] Client connected: " << clientIP << std::endl;
+
+            // 5. 织入业务逻辑 (Weaving)
+            // 调用父类（业务类）的方法处理具体数据
+            // 这里体现了分离：CTCPServer只管连接，CMyTCPServer只管数据
+            // 阻塞套接字上 read 不会返回 EAGAIN，ServerFunction 一直处理到连接结束
+            ConnectionProcessor *pProcessor = static_cast<ConnectionProcessor *>(this);
+            while (pProcessor->ServerFunction(nConnectedSocket, nListenSocket)) {
+            }
+
+            // 关闭连接
+            ::close(nConnectedSocket);
+            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
+        }
+
+        ::close(nListenSocket);
+        return 0;
+    }
+
+    // 基于 epoll 的事件循环（Reactor）：单线程同时服务大量连接
+    // 套接字均为非阻塞、边沿触发，每次可读事件织入一次业务类的 ServerFunction
+    // 业务类经 CSendQueue 发送的回复写不完时注册 EPOLLOUT，可写时由切面继续发送
+    int RunEventLoop() {
+        // 忽略 SIGPIPE 信号，防止客户端异常断开导致服务端退出
+        signal(SIGPIPE, SIG_IGN);
+
+        // 将文件描述符软限制提升到硬限制，以支持上千个并发连接
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+
+        int nListenSocket = CreateListenSocket();
+        if (-1 == nListenSocket) {
+            return -1;
+        }
+        SetNonBlocking(nListenSocket);
+
+        // 1. 创建 epoll 实例并注册监听套接字
+        int nEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+        if (-1 == nEpoll) {
+            std::cerr << "[Error] epoll_create1 error: " << strerror(errno) << std::endl;
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = nListenSocket;
+        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nListenSocket, &ev) == -1) {
+            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+            ::close(nEpoll);
+            ::close(nListenSocket);
+            return -1;
+        }
+
+        CSendQueue sendQueue(nEpoll, EPOLLIN | EPOLLRDHUP | EPOLLET);
+        std::unordered_map<int, CConnection> mapConnections;
+        epoll_event events[MAX_EPOLL_EVENTS];
+
+        // 2. 事件循环
+        while (true) {
+            int nReady = ::epoll_wait(nEpoll, events, MAX_EPOLL_EVENTS, -1);
+            if (-1 == nReady) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "[Error] epoll_wait error: " << strerror(errno) << std::endl;
+                break;
+            }
+
+            for (int i = 0; i < nReady; i++) {
+                int fd = events[i].data.fd;
+
+                // 3. 新连接：边沿触发下必须 accept 到 EAGAIN 为止
+                if (fd == nListenSocket) {
+                    while (true) {
+                        sockaddr_in ClientAddress;
+                        socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+                        int nConnectedSocket = ::accept4(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                        if (-1 == nConnectedSocket) {
+                            if (errno == EINTR) {
+                                continue;
+                            }
+                            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                                std::cerr << "[Error] accept error: " << strerror(errno) << std::endl;
+                            }
+                            break;
+                        }
+
+                        char clientIP[INET_ADDRSTRLEN];
+                        inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+
+                        epoll_event evConn;
+                        evConn.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+                        evConn.data.fd = nConnectedSocket;
+                        if (::epoll_ctl(nEpoll, EPOLL_CTL_ADD, nConnectedSocket, &evConn) == -1) {
+                            std::cerr << "[Error] epoll_ctl error: " << strerror(errno) << std::endl;
+                            ::close(nConnectedSocket);
+                            continue;
+                        }
+                        CConnection &conn = mapConnections[nConnectedSocket];
+                        conn.strClientIP = clientIP;
+                        conn.bReadPaused = false;
+                        conn.bClosing = false;
+                        sendQueue.AddConnection(nConnectedSocket);
+                        std::cout << "[Server] Client connected: " << clientIP << std::endl;
+                    }
+                    continue;
+                }
+
+                auto it = mapConnections.find(fd);
+                if (it == mapConnections.end()) {
+                    continue;
+                }
+                CConnection &conn = it->second;
+                bool bKeepAlive = true;
+                bool bWriteOk = true;
+
+                // 4. 可写：先写出积压的回复
+                if (events[i].events & EPOLLOUT) {
+                    bWriteOk = sendQueue.Flush(fd);
+                }
+
+                // 5. 可读、对端关闭、出错，或积压刚降到上限以下：织入业务逻辑
+                // EPOLLERR 也交给业务类：真正的错误会在 read 时返回，业务类借此清理连接状态；
+                // MSG_ZEROCOPY 的完成通知同样以 EPOLLERR 的形式出现，不能直接关闭连接
+                // 暂停期间未读的数据还在接收缓冲区中，边沿触发不会再通知，需要主动恢复读取
+                // 写出失败时同样交给业务类，由它清理连接状态并决定何时关闭（如等待零拷贝的完成通知）
+                bool bReadable = (events[i].events & ~EPOLLOUT) != 0;
+                bool bResume = conn.bReadPaused && !CSendQueue::IsBacklogged(fd);
+                if (!bWriteOk && conn.bClosing) {
+                    bKeepAlive = false;
+                } else if (!conn.bClosing && (bReadable || bResume || !bWriteOk)) {
+                    ConnectionProcessor *pProcessor = static_cast<ConnectionProcessor *>(this);
+                    bKeepAlive = pProcessor->ServerFunction(fd, nListenSocket);
+                    conn.bReadPaused = bKeepAlive && CSendQueue::IsBacklogged(fd);
+
+                    // 业务要求关闭但还有积压的回复：先写完再关闭，写出失败则立即关闭
+                    if (!bKeepAlive && sendQueue.GetPendingSize(fd) > 0) {
+                        conn.bClosing = true;
+                        bKeepAlive = sendQueue.Flush(fd);
+                    }
+                }
+
+                // 6. 连接出错、业务要求关闭且积压已写完：close 会自动把 fd 从 epoll 中移除
+                if (!bKeepAlive || (conn.bClosing && sendQueue.GetPendingSize(fd) == 0)) {
+                    std::cout << "[Server] Client disconnected: " << conn.strClientIP << std::endl;
+                    sendQueue.RemoveConnection(fd);
+                    mapConnections.erase(it);
+                    ::close(fd);
+                }
+            }
+        }
+
+        ::close(nEpoll);
+        ::close(nListenSocket);
+        return 0;
+    }
+
+protected:
+    // 创建、绑定并监听套接字，失败返回 -1
+    int CreateListenSocket() {
         // 1. 创建 Socket
         int nListenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
         if (-1 == nListenSocket) {
@@ -87,43 +290,321 @@ public:
         }
 
         std::cout << "[Server] Listening on port " << m_nServerPort << " ..." << std::endl;
+        return nListenSocket;
+    }
 
-        // 4. 循环处理连接
-        while (true) {
-            sockaddr_in ClientAddress;
-            socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+    static bool SetNonBlocking(int nSocket) {
+        int nFlags = ::fcntl(nSocket, F_GETFL, 0);
+        if (-1 == nFlags) {
+            return false;
+        }
+        return ::fcntl(nSocket, F_SETFL, nFlags | O_NONBLOCK) != -1;
+    }
 
-            // 阻塞等待连接
-            int nConnectedSocket = ::accept(nListenSocket, (sockaddr *)&ClientAddress, &LengthOfClientAddress);
-            if (-1 == nConnectedSocket) {
-                perror("accept");
-                continue;
-            }
+private:
+    // epoll 事件循环中每个已连接套接字的状态
+    struct CConnection {
+        std::string strClientIP;
+        bool bReadPaused; // 积压超过上限，业务类已暂停读取
+        bool bClosing;    // 业务类已要求关闭，写完积压的回复后再关闭
+    };
 
-            // 打印客户端信息
-            char clientIP[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
-            std::cout << "[Server] Client connected: " << clientIP << std::endl;
+    int m_nServerPort;
+    std::string m_strBoundIP; // 优化：使用string管理
+    int m_nLengthOfQueueOfListen;
+};
 
-            // 5. 织入业务逻辑 (Weaving)
-            // 调用父类（业务类）的方法处理具体数据
-            // 这里体现了分离：CTCPServer只管连接，CMyTCPServer只管数据
-            ConnectionProcessor *pProcessor = static_cast<ConnectionProcessor *>(this);
-            pProcessor->ServerFunction(nConnectedSocket, nListenSocket);
+// -----------------------------------------------------------
+// AOP 切面类：CTCPServerUring
+// 职责：与 CTCPServer 相同，负责连接管理，但数据通路基于 io_uring：
+//   多次触发 accept + 提供缓冲区环上的多次触发 recv + 按连接链接 (IOSQE_IO_LINK) 的 send，
+//   一次 io_uring_enter 同时完成一批提交与收割，数据不经过额外的拷贝
+// 业务类需提供 OnData(nConnectedSocket, pData, nLen)：在 pData 上原地处理数据，
+//   返回需要回发的字节数（从 pData 开始）
+// 内核不支持 io_uring 时退回到 CTCPServer 的 epoll + read/write 通路
+// -----------------------------------------------------------
+template <typename ConnectionProcessor>
+class CTCPServerUring : public CTCPServer<ConnectionProcessor> {
+public:
+    CTCPServerUring(int nServerPort, int nLengthOfQueueOfListen = 100, const char *strBoundIP = NULL)
+        : CTCPServer<ConnectionProcessor>(nServerPort, nLengthOfQueueOfListen, strBoundIP) {
+    }
 
-            // 关闭连接
-            ::close(nConnectedSocket);
-            std::cout << "[Server] Client disconnected: " << clientIP << std::endl;
+    virtual ~CTCPServerUring() {
+    }
+
+public:
+    int Run() {
+        signal(SIGPIPE, SIG_IGN);
+
+        // 1. 创建 io_uring 并注册提供缓冲区环，失败说明内核不支持，退回 read/write 通路
+        CIoUring ring;
+        if (!ring.Init(URING_ENTRIES)) {
+            std::cerr << "[Warning] io_uring unavailable (" << strerror(errno) << "), falling back to epoll" << std::endl;
+            return CTCPServer<ConnectionProcessor>::RunEventLoop();
+        }
+
+        std::vector<char> vBuffers((size_t)URING_BUFFER_COUNT * MAX_BUFFER_SIZE);
+        if (!ring.RegisterBufRing(0, URING_BUFFER_COUNT, vBuffers.data(), MAX_BUFFER_SIZE)) {
+            std::cerr << "[Warning] provided buffer ring unavailable (" << strerror(errno) << "), falling back to epoll" << std::endl;
+            ring.Close();
+            return CTCPServer<ConnectionProcessor>::RunEventLoop();
+        }
+
+        int nListenSocket = this->CreateListenSocket();
+        if (-1 == nListenSocket) {
+            return -1;
         }
 
+        int nRet = EventLoop(ring, nListenSocket);
         ::close(nListenSocket);
-        return 0;
+        if (nRet == -EINVAL) {
+            // 内核支持 io_uring 但不支持多次触发 accept
+            std::cerr << "[Warning] multishot accept unsupported, falling back to epoll" << std::endl;
+            ring.Close();
+            return CTCPServer<ConnectionProcessor>::RunEventLoop();
+        }
+        return nRet;
     }
 
 private:
-    int m_nServerPort;
-    std::string m_strBoundIP; // 优化：使用string管理
-    int m_nLengthOfQueueOfListen;
+    // user_data 布局：操作码(8 位) | 文件描述符(24 位) | 附加值(32 位)
+    // recv/send 的附加值为 连接代数(16 位) | 缓冲区编号(16 位，仅 send)，用于识别已关闭连接的过期完成事件
+    enum { OP_ACCEPT = 1, OP_RECV = 2, OP_SEND = 3, OP_CANCEL = 4 };
+
+    static unsigned long long MakeUserData(unsigned nOp, int fd, unsigned nTag) {
+        return ((unsigned long long)nOp << 56) | ((unsigned long long)(fd & 0xFFFFFF) << 32) | nTag;
+    }
+
+    // 单个连接的状态
+    struct CConnection {
+        bool bRecvArmed;   // 多次触发 recv 是否仍然有效
+        bool bRecvPaused;  // 占用的缓冲区达到上限，recv 已取消或不再重新提交，等 send 完成后恢复
+        bool bClosing;     // 对端已关闭或出错，不再接收；已收到数据的回发全部完成后关闭
+        unsigned nInflight; // 已提交、尚未完成的 send 个数
+        unsigned short nGeneration; // 连接代数：文件描述符被复用后，旧连接的完成事件与新连接区分开
+        std::vector<std::pair<unsigned short, unsigned>> vPending; // 待发送的 (缓冲区编号, 长度)
+        std::string strClientIP;
+
+        // 当前占用的提供缓冲区个数
+        size_t GetHeldBuffers() const {
+            return vPending.size() + nInflight;
+        }
+
+        // 该连接的 recv/send 使用的附加值
+        unsigned MakeTag(unsigned short nBid = 0) const {
+            return ((unsigned)nGeneration << 16) | nBid;
+        }
+    };
+
+    // 取 SQE，SQ 满时先把已有的提交出去
+    static io_uring_sqe *GetSqe(CIoUring &ring) {
+        io_uring_sqe *pSqe = ring.GetSqe();
+        while (pSqe == NULL) {
+            ring.Submit(0);
+            pSqe = ring.GetSqe();
+        }
+        return pSqe;
+    }
+
+    // 返回 0 表示正常结束，-EINVAL 表示多次触发 accept 不受支持，其他负值为错误
+    int EventLoop(CIoUring &ring, int nListenSocket) {
+        std::unordered_map<int, CConnection> mapConnections;
+        std::vector<int> vSendReady; // 本批次新增待发送数据的连接
+        std::vector<int> vStarved;   // 因缓冲区耗尽 (ENOBUFS) 而停止接收的连接
+        bool bAccepted = false;
+        unsigned short nNextGeneration = 0;
+
+        CIoUring::PrepMultishotAccept(GetSqe(ring), nListenSocket, MakeUserData(OP_ACCEPT, nListenSocket, 0));
+
+        while (true) {
+            // 2. 一次系统调用：提交本轮所有 SQE 并等待至少一个完成事件
+            if (ring.Submit(1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("io_uring_enter");
+                return -1;
+            }
+
+            bool bRecycled = false;
+            io_uring_cqe *pCqe;
+            while ((pCqe = ring.PeekCqe()) != NULL) {
+                unsigned long long nUserData = pCqe->user_data;
+                int nRes = pCqe->res;
+                unsigned nFlags = pCqe->flags;
+                ring.SeenCqe();
+
+                unsigned nOp = (unsigned)(nUserData >> 56);
+                int fd = (int)((nUserData >> 32) & 0xFFFFFF);
+
+                if (nOp == OP_ACCEPT) {
+                    // 3. 新连接：登记并为其挂上多次触发 recv
+                    if (nRes >= 0) {
+                        bAccepted = true;
+                        sockaddr_in ClientAddress;
+                        socklen_t LengthOfClientAddress = sizeof(sockaddr_in);
+                        char clientIP[INET_ADDRSTRLEN] = "";
+                        if (::getpeername(nRes, (sockaddr *)&ClientAddress, &LengthOfClientAddress) == 0) {
+                            inet_ntop(AF_INET, &ClientAddress.sin_addr, clientIP, INET_ADDRSTRLEN);
+                        }
+                        CConnection &conn = mapConnections[nRes];
+                        conn.bRecvArmed = true;
+                        conn.bRecvPaused = false;
+                        conn.bClosing = false;
+                        conn.nInflight = 0;
+                        conn.nGeneration = nNextGeneration++;
+                        conn.strClientIP = clientIP;
+                        std::cout << "[Server] Client connected: " << clientIP << std::endl;
+                        CIoUring::PrepMultishotRecv(GetSqe(ring), nRes, ring.GetBufGroup(), MakeUserData(OP_RECV, nRes, conn.MakeTag()));
+                    } else if (nRes == -EINVAL && !bAccepted) {
+                        return -EINVAL;
+                    } else {
+                        std::cerr << "[Error] accept error: " << strerror(-nRes) << std::endl;
+                    }
+                    if (!(nFlags & IORING_CQE_F_MORE)) {
+                        CIoUring::PrepMultishotAccept(GetSqe(ring), nListenSocket, MakeUserData(OP_ACCEPT, nListenSocket, 0));
+                    }
+                } else if (nOp == OP_RECV) {
+                    // 4. 收到数据：交给业务类原地处理，回发内容暂存到待发送队列
+                    //    连接已关闭（或文件描述符已被新连接复用）时丢弃过期的完成事件，只归还缓冲区
+                    auto it = mapConnections.find(fd);
+                    if (it == mapConnections.end() || it->second.MakeTag() != (unsigned)nUserData) {
+                        if (nFlags & IORING_CQE_F_BUFFER) {
+                            ring.AddBuffer((unsigned short)(nFlags >> IORING_CQE_BUFFER_SHIFT));
+                            bRecycled = true;
+                        }
+                        continue;
+                    }
+                    CConnection &conn = it->second;
+                    if (nRes > 0) {
+                        unsigned short nBid = (unsigned short)(nFlags >> IORING_CQE_BUFFER_SHIFT);
+                        ConnectionProcessor *pProcessor = static_cast<ConnectionProcessor *>(this);
+                        size_t nReply = pProcessor->OnData(fd, ring.GetBuffer(nBid), (size_t)nRes);
+                        if (nReply > 0 && !conn.bClosing) {
+                            if (conn.vPending.empty()) {
+                                vSendReady.push_back(fd);
+                            }
+                            conn.vPending.push_back(std::make_pair(nBid, (unsigned)nReply));
+                        } else {
+                            ring.AddBuffer(nBid);
+                            bRecycled = true;
+                        }
+                    } else if (nRes == -ENOBUFS) {
+                        vStarved.push_back(fd);
+                    } else if (nRes != -ECANCELED) {
+                        // 对端关闭 (0) 或出错；-ECANCELED 是因占用缓冲区过多而主动取消
+                        conn.bClosing = true;
+                    }
+
+                    // 占用的缓冲区达到上限：recv 仍有效时取消它，取消完成前到达的数据照常处理
+                    if (nRes > 0 && !conn.bClosing && !conn.bRecvPaused && conn.GetHeldBuffers() >= URING_CONN_BUFFER_LIMIT) {
+                        conn.bRecvPaused = true;
+                        if (nFlags & IORING_CQE_F_MORE) {
+                            CIoUring::PrepCancel(GetSqe(ring), MakeUserData(OP_RECV, fd, conn.MakeTag()), MakeUserData(OP_CANCEL, fd, 0));
+                        }
+                    }
+                    if (!(nFlags & IORING_CQE_F_MORE)) {
+                        conn.bRecvArmed = false;
+                        if ((nRes > 0 || nRes == -ECANCELED) && !conn.bClosing && !conn.bRecvPaused) {
+                            CIoUring::PrepMultishotRecv(GetSqe(ring), fd, ring.GetBufGroup(), MakeUserData(OP_RECV, fd, conn.MakeTag()));
+                            conn.bRecvArmed = true;
+                        }
+                    }
+                    CloseIfDone(mapConnections, fd);
+                } else if (nOp == OP_SEND) {
+                    // 5. 发送完成：归还缓冲区，链上若有失败则关闭连接；过期的完成事件只归还缓冲区
+                    ring.AddBuffer((unsigned short)(nUserData & 0xFFFF));
+                    bRecycled = true;
+                    auto it = mapConnections.find(fd);
+                    if (it == mapConnections.end() || it->second.MakeTag() != ((unsigned)nUserData & 0xFFFF0000u)) {
+                        continue;
+                    }
+                    CConnection &conn = it->second;
+                    conn.nInflight--;
+                    if (nRes < 0 && !conn.bClosing) {
+                        // 关闭读写两端，使仍然挂着的多次触发 recv 结束
+                        conn.bClosing = true;
+                        ::shutdown(fd, SHUT_RDWR);
+                    }
+                    if (conn.nInflight == 0 && !conn.vPending.empty()) {
+                        vSendReady.push_back(fd);
+                    }
+
+                    // 占用的缓冲区降到上限的一半以下时恢复接收；取消尚未完成时由 recv 的最后一个完成事件重新提交
+                    if (conn.bRecvPaused && !conn.bClosing && conn.GetHeldBuffers() <= URING_CONN_BUFFER_LIMIT / 2) {
+                        conn.bRecvPaused = false;
+                        if (!conn.bRecvArmed) {
+                            CIoUring::PrepMultishotRecv(GetSqe(ring), fd, ring.GetBufGroup(), MakeUserData(OP_RECV, fd, conn.MakeTag()));
+                            conn.bRecvArmed = true;
+                        }
+                    }
+                    CloseIfDone(mapConnections, fd);
+                }
+                // OP_CANCEL 的完成事件无需处理：结果体现在被取消的 recv 上
+            }
+
+            // 6. 每个连接同时只有一条 send 链在途：把累积的回发数据链接成一条新链
+            for (int nReadyFd : vSendReady) {
+                auto it = mapConnections.find(nReadyFd);
+                if (it == mapConnections.end() || it->second.nInflight > 0 || it->second.vPending.empty()) {
+                    continue;
+                }
+                // 对端半关闭后仍要回发已收到的数据；连接出错时 send 会立即失败并归还缓冲区
+                CConnection &conn = it->second;
+                for (size_t i = 0; i < conn.vPending.size(); i++) {
+                    unsigned short nBid = conn.vPending[i].first;
+                    io_uring_sqe *pSqe = GetSqe(ring);
+                    CIoUring::PrepSend(pSqe, nReadyFd, ring.GetBuffer(nBid), conn.vPending[i].second, MakeUserData(OP_SEND, nReadyFd, conn.MakeTag(nBid)));
+                    if (i + 1 < conn.vPending.size()) {
+                        pSqe->flags |= IOSQE_IO_LINK;
+                    }
+                }
+                conn.nInflight = (unsigned)conn.vPending.size();
+                conn.vPending.clear();
+            }
+            vSendReady.clear();
+
+            // 7. 归还的缓冲区对内核可见后，恢复因缓冲区耗尽而停止接收的连接
+            //    没有归还时，若占用缓冲区的连接都已暂停，环中仍可能有空闲缓冲区，此时同样恢复
+            bool bRetry = bRecycled;
+            if (!vStarved.empty() && !bRetry) {
+                size_t nHeld = 0;
+                for (auto &entry : mapConnections) {
+                    nHeld += entry.second.GetHeldBuffers();
+                }
+                bRetry = nHeld < URING_BUFFER_COUNT;
+            }
+            if (bRetry) {
+                if (bRecycled) {
+                    ring.CommitBuffers();
+                }
+                for (int nStarvedFd : vStarved) {
+                    auto it = mapConnections.find(nStarvedFd);
+                    if (it != mapConnections.end() && !it->second.bRecvArmed && !it->second.bRecvPaused) {
+                        CIoUring::PrepMultishotRecv(GetSqe(ring), nStarvedFd, ring.GetBufGroup(), MakeUserData(OP_RECV, nStarvedFd, it->second.MakeTag()));
+                        it->second.bRecvArmed = true;
+                    }
+                }
+                vStarved.clear();
+            }
+        }
+        return 0;
+    }
+
+    // recv 已结束、没有待发送和在途 send 时才真正关闭，保证文件描述符不会被提前复用，缓冲区全部归还
+    static void CloseIfDone(std::unordered_map<int, CConnection> &mapConnections, int fd) {
+        auto it = mapConnections.find(fd);
+        if (it == mapConnections.end()) {
+            return;
+        }
+        CConnection &conn = it->second;
+        if (conn.bClosing && !conn.bRecvArmed && conn.nInflight == 0 && conn.vPending.empty()) {
+            std::cout << "[Server] Client disconnected: " << conn.strClientIP << std::endl;
+            ::close(fd);
+            mapConnections.erase(it);
+        }
+    }
 };
 
 // -----------------------------------------------------------
@@ -132,33 +613,102 @@ private:
 // -----------------------------------------------------------
 class CMyTCPServer {
 public:
-    // 具体的 Echo 业务实现
-    void ServerFunction(int nConnectedSocket, int /*nListenSocket*/) {
+    // 具体的 Echo 业务实现：在 pData 上原地处理数据，返回需要回发的字节数
+    // 供 io_uring 切面直接调用，read/write 通路 ServerFunction 也复用它
+    size_t OnData(int /*nConnectedSocket*/, char *pData, size_t nLen) {
+        std::cout << "[Recv]: ";
+        std::cout.write(pData, nLen);
+        return nLen;
+    }
+
+    // read/write 通路：每次套接字可读时被调用，返回 true 保持连接，返回 false 由切面关闭连接
+    // 对端只发不收导致回复积压过多时暂停读取，积压写出后切面会再次调用
+    bool ServerFunction(int nConnectedSocket, int /*nListenSocket*/) {
         char buf[MAX_BUFFER_SIZE];
 
-        while (true) {
-            memset(buf, 0, MAX_BUFFER_SIZE);
-            // 读取数据
-            ssize_t bytesRead = ::read(nConnectedSocket, buf, MAX_BUFFER_SIZE - 1);
+        while (!CSendQueue::IsBacklogged(nConnectedSocket)) {
+            // 读取数据（按长度处理，无需每次清零缓冲区）
+            ssize_t bytesRead = ::read(nConnectedSocket, buf, MAX_BUFFER_SIZE);
 
             if (bytesRead > 0) {
-                std::cout << "[Recv]: " << buf;
+                size_t nReply = OnData(nConnectedSocket, buf, bytesRead);
                 // Echo 回发
-                ssize_t bytesWrite = ::write(nConnectedSocket, buf, bytesRead);
+                if (!CSendQueue::Send(nConnectedSocket, buf, nReply)) {
+                    perror("write");
+                    return false;
+                }
             } else if (bytesRead == 0) {
                 // 对端关闭
-                break;
+                return false;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 本次可读事件的数据已取完
+                return true;
+            } else if (errno == EINTR) {
+                continue;
             } else {
                 perror("read");
-                break;
+                return false;
             }
         }
+        return true;
+    }
+};
+
+// -----------------------------------------------------------
+// 核心业务类：CMyFramedServer
+// 职责：与 CMyTCPServer 相同的 Echo 业务，但以完整消息为单位处理，织入 CFramedServer 分帧切面
+// -----------------------------------------------------------
+class CMyFramedServer {
+public:
+    // 每条完整消息调用一次，返回 false 时关闭连接
+    bool OnMessage(const char *pData, size_t nLen, CFrameWriter &writer) {
+        std::cout << "[Recv]: ";
+        std::cout.write(pData, nLen);
+        std::cout << std::endl;
+        // 回显数据在本批回复发送前一直有效，直接引用即可
+        writer.SendRef(pData, nLen);
+        return true;
     }
 };
 
-int main() {
+int main(int argc, char **argv) {
+    // 传入 "uring" 参数时选择 io_uring 连接切面
+    if (argc > 1 && strcmp(argv[1], "uring") == 0) {
+        CTCPServerUring<CMyTCPServer> myserver(DEFAULT_PORT);
+        myserver.Run();
+        return 0;
+    }
+
+    // 传入 "splice" / "zerocopy" 参数时织入零拷贝 Echo 业务（不打印消息内容，适合大块数据）
+    if (argc > 1 && strcmp(argv[1], "splice") == 0) {
+        CTCPServer<CSpliceEchoServer> myserver(DEFAULT_PORT);
+        myserver.RunEventLoop();
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "zerocopy") == 0) {
+        CTCPServer<CZeroCopyEchoServer> myserver(DEFAULT_PORT);
+        myserver.RunEventLoop();
+        return 0;
+    }
+
+    // 传入 "framed" 参数时织入长度前缀分帧切面，业务类按消息收发
+    // 再传入 "stats" 时，每当所有连接都已关闭就打印一次缓冲池统计
+    if (argc > 1 && strcmp(argv[1], "framed") == 0) {
+        CTCPServer<CFramedServer<CMyFramedServer>> myserver(DEFAULT_PORT);
+        if (argc > 2 && strcmp(argv[2], "stats") == 0) {
+            myserver.EnablePoolStats();
+        }
+        myserver.RunEventLoop();
+        return 0;
+    }
+
     // AOP 组合：将业务逻辑(CMyTCPServer)织入到网络框架(CTCPServer)中
     CTCPServer<CMyTCPServer> myserver(DEFAULT_PORT);
-    myserver.Run();
+    // 默认使用 epoll 事件循环；传入 "block" 参数时使用原有的阻塞模式
+    if (argc > 1 && strcmp(argv[1], "block") == 0) {
+        myserver.Run();
+    } else {
+        myserver.RunEventLoop();
+    }
     return 0;
 }
\ No newline at end of file
@@ -35,11 +35,14 @@ bool CPluginController::InitializeController() {
         PROC_PRINT DllPrint = (PROC_PRINT)dlsym(hinstLib, "Print");
         PROC_GETID DllGetID = (PROC_GETID)dlsym(hinstLib, "GetID");
 
-        // 校验：必须两个函数都存在才算加载成功
+        // 校验：必须两个函数都存在才算加载成功；GetID 只在加载时调用一次，用于建立索引
         if (DllPrint && DllGetID) {
-            m_vhForPlugin.push_back(hinstLib);
-            m_vPrintFunc.push_back(DllPrint);
-            m_vGetIDFunc.push_back(DllGetID);
+            if (RegisterPlugin(DllGetID(), DllPrint)) {
+                m_vhForPlugin.push_back(hinstLib);
+            } else {
+                cerr << "[Error] Skipped " << path << endl;
+                dlclose(hinstLib);
+            }
         } else {
             cerr << "[Error] Missing symbols in " << path << ": " << dlerror() << endl;
             dlclose(hinstLib);
@@ -48,19 +51,37 @@ bool CPluginController::InitializeController() {
     return true;
 }
 
-bool CPluginController::ProcessRequest(int FunctionID) {
-    bool bFound = false;
-    // 遍历已加载的 GetID 函数，寻找匹配的 ID
-    for (size_t i = 0; i < m_vGetIDFunc.size(); i++) {
-        if (m_vGetIDFunc[i]() == FunctionID) {
-            // 找到 ID，调用对应的 Print
-            m_vPrintFunc[i]();
-            bFound = true;
-            break;
+bool CPluginController::RegisterPlugin(int FunctionID, PROC_PRINT DllPrint) {
+    if (Lookup(FunctionID) != nullptr) {
+        cerr << "[Error] Function ID " << FunctionID << " is already registered." << endl;
+        return false;
+    }
+
+    if (FunctionID >= 0 && FunctionID < DENSE_ID_LIMIT) {
+        if ((size_t)FunctionID >= m_vDenseIndex.size()) {
+            m_vDenseIndex.resize(FunctionID + 1, nullptr);
         }
+        m_vDenseIndex[FunctionID] = DllPrint;
+    } else {
+        m_mapSparseIndex[FunctionID] = DllPrint;
     }
+    return true;
+}
 
-    if (!bFound) {
+PROC_PRINT CPluginController::Lookup(int FunctionID) const {
+    if (FunctionID >= 0 && FunctionID < DENSE_ID_LIMIT) {
+        return (size_t)FunctionID < m_vDenseIndex.size() ? m_vDenseIndex[FunctionID] : nullptr;
+    }
+    auto it = m_mapSparseIndex.find(FunctionID);
+    return it != m_mapSparseIndex.end() ? it->second : nullptr;
+}
+
+bool CPluginController::ProcessRequest(int FunctionID) {
+    // 查索引，命中后只有一次间接调用
+    PROC_PRINT DllPrint = Lookup(FunctionID);
+    if (DllPrint != nullptr) {
+        DllPrint();
+    } else {
         cout << "[Warning] Function ID " << FunctionID << " not found." << endl;
     }
 
@@ -97,7 +118,7 @@ bool CPluginController::UninitializeController() {
         }
     }
     m_vhForPlugin.clear();
-    m_vPrintFunc.clear();
-    m_vGetIDFunc.clear();
+    m_vDenseIndex.clear();
+    m_mapSparseIndex.clear();
     return true;
 }
\ No newline at end of file
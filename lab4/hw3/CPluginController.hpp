@@ -1,5 +1,6 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 // 定义函数指针类型
@@ -7,6 +8,9 @@ typedef void (*PROC_PRINT)(void);
 typedef void (*PROC_HELP)(void);
 typedef int (*PROC_GETID)(void);
 
+// 插件 ID 小于该值时使用数组直接索引，否则放入哈希表
+#define DENSE_ID_LIMIT 4096
+
 class CPluginController {
 public:
     CPluginController();
@@ -25,7 +29,14 @@ public:
     bool ProcessRequest(int FunctionID);
 
 private:
-    std::vector<void *> m_vhForPlugin;    // 保存 dlopen 返回的句柄
-    std::vector<PROC_PRINT> m_vPrintFunc; // 保存 Print 函数地址
-    std::vector<PROC_GETID> m_vGetIDFunc; // 保存 GetID 函数地址
+    // 登记一个插件的 Print 函数，ID 与已登记的插件冲突时返回 false
+    bool RegisterPlugin(int FunctionID, PROC_PRINT DllPrint);
+
+    // 按 ID 查找 Print 函数，O(1)；找不到时返回 nullptr
+    PROC_PRINT Lookup(int FunctionID) const;
+
+private:
+    std::vector<void *> m_vhForPlugin;                    // 保存 dlopen 返回的句柄
+    std::vector<PROC_PRINT> m_vDenseIndex;                // 小的非负 ID：直接下标访问 Print 函数地址
+    std::unordered_map<int, PROC_PRINT> m_mapSparseIndex; // 负数或过大的 ID
 };
@@ -0,0 +1,82 @@
+#include "CEpochReclaimer.hpp"
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+CEpochReclaimer::CEpochReclaimer() : m_nEpoch(1), m_nPending(0) {
+    for (auto &slot : m_slots) {
+        slot.nEpoch = 0;
+    }
+}
+
+CEpochReclaimer::~CEpochReclaimer() {
+    for (auto &retired : m_vRetired) {
+        retired.fnFree();
+    }
+}
+
+size_t CEpochReclaimer::Enter() {
+    // 全部使用顺序一致的原子操作：若读者随后读到了旧指针，它写入槽位一定早于写者换指针，
+    // 因而也早于写者检查槽位，且写入的纪元不大于旧数据登记时的纪元，旧数据不会被提前释放
+    while (true) {
+        uint64_t nEpoch = m_nEpoch.load();
+        for (size_t i = 0; i < MAX_READERS; i++) {
+            uint64_t nIdle = 0;
+            if (m_slots[i].nEpoch.compare_exchange_strong(nIdle, nEpoch)) {
+                return i;
+            }
+        }
+        this_thread::yield();
+    }
+}
+
+void CEpochReclaimer::Leave(size_t nSlot) {
+    // release 即可：读者在临界区内的访问都发生在写者看到槽位清零之前
+    m_slots[nSlot].nEpoch.store(0, memory_order_release);
+}
+
+void CEpochReclaimer::Retire(function<void()> fnFree) {
+    m_vRetired.push_back(CRetired{m_nEpoch.fetch_add(1), std::move(fnFree)});
+    m_nPending = m_vRetired.size();
+}
+
+size_t CEpochReclaimer::Reclaim() {
+    if (m_vRetired.empty()) {
+        return 0;
+    }
+
+    // 活跃读者中最早的纪元；纪元小于它的待回收项已经没有读者能看到
+    uint64_t nMinActive = UINT64_MAX;
+    for (auto &slot : m_slots) {
+        uint64_t nEpoch = slot.nEpoch.load();
+        if (nEpoch != 0 && nEpoch < nMinActive) {
+            nMinActive = nEpoch;
+        }
+    }
+
+    size_t nKept = 0;
+    for (size_t i = 0; i < m_vRetired.size(); i++) {
+        if (m_vRetired[i].nEpoch < nMinActive) {
+            m_vRetired[i].fnFree();
+        } else {
+            if (nKept != i) {
+                m_vRetired[nKept] = std::move(m_vRetired[i]);
+            }
+            nKept++;
+        }
+    }
+    m_vRetired.resize(nKept);
+    m_nPending = nKept;
+    return nKept;
+}
+
+void CEpochReclaimer::Synchronize() {
+    while (Reclaim() > 0) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+size_t CEpochReclaimer::GetPendingCount() const {
+    return m_nPending;
+}
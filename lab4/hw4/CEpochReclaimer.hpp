@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 基于纪元（epoch）的延迟回收：读者无锁地读取共享指针，写者换上新数据后把旧数据登记为待回收，
+// 等所有可能还在使用旧数据的读者都离开后才真正释放
+//
+// 读者：nSlot = Enter(); 读取共享指针并使用; Leave(nSlot);
+//   Enter 把当前纪元写入一个空闲槽位（一次 CAS），Leave 把槽位清零，读路径上没有锁
+// 写者：先换上新指针，再 Retire(释放旧数据的函数)；Retire 记下当前纪元并把纪元加一
+//   之后进入的读者只能看到新指针；某个待回收项只有在所有活跃读者的纪元都大于它的纪元时才会被释放
+// 写者之间需要调用方自行互斥（Retire / Reclaim / Synchronize 不是线程安全的）
+class CEpochReclaimer {
+public:
+    enum { MAX_READERS = 64 }; // 同时处于临界区的读者上限，超出时 Enter 会等待空闲槽位
+
+    CEpochReclaimer();
+    virtual ~CEpochReclaimer(); // 调用时必须已没有读者，剩余的待回收项全部释放
+
+    CEpochReclaimer(const CEpochReclaimer &) = delete;
+    CEpochReclaimer &operator=(const CEpochReclaimer &) = delete;
+
+    // 读者进入临界区，返回占用的槽位，离开时交给 Leave
+    size_t Enter();
+    void Leave(size_t nSlot);
+
+    // 写者：登记一项待回收的旧数据，fnFree 在安全之后由写者线程（Reclaim / Synchronize 的调用方）执行
+    void Retire(std::function<void()> fnFree);
+
+    // 写者：释放已经安全的待回收项，返回仍需等待的项数
+    size_t Reclaim();
+
+    // 写者：等待当前所有读者离开，之后释放全部待回收项
+    void Synchronize();
+
+    size_t GetPendingCount() const;
+
+private:
+    // 每个槽位独占一条缓存行，避免不同读者之间伪共享
+    struct alignas(64) CReaderSlot {
+        std::atomic<uint64_t> nEpoch; // 0 表示空闲，否则为读者进入时的纪元
+    };
+
+    struct CRetired {
+        uint64_t nEpoch;
+        std::function<void()> fnFree;
+    };
+
+    std::atomic<uint64_t> m_nEpoch; // 全局纪元，从 1 开始
+    CReaderSlot m_slots[MAX_READERS];
+    std::vector<CRetired> m_vRetired; // 只有写者访问
+    std::atomic<size_t> m_nPending;
+};
+
+// 读者临界区的作用域守卫：构造时 Enter，析构时 Leave（插件调用抛出异常也不会占住槽位）
+class CEpochGuard {
+public:
+    explicit CEpochGuard(CEpochReclaimer &reclaimer) : m_reclaimer(reclaimer), m_nSlot(reclaimer.Enter()) {}
+    ~CEpochGuard() {
+        m_reclaimer.Leave(m_nSlot);
+    }
+
+    CEpochGuard(const CEpochGuard &) = delete;
+    CEpochGuard &operator=(const CEpochGuard &) = delete;
+
+private:
+    CEpochReclaimer &m_reclaimer;
+    size_t m_nSlot;
+};
@@ -1,115 +1,476 @@
 #include "CPluginController.hpp"
 #include "CPluginEnumerator.hpp"
+#include "CPluginManifest.hpp"
 #include "IPrintPlugin.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <dlfcn.h>
+#include <fcntl.h>
 #include <iostream>
+#include <set>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
 
 using namespace std;
 
 // 定义创建对象的函数指针类型
 typedef void (*PLUGIN_CREATE)(IPrintPlugin **);
 
-CPluginController::CPluginController() {
+// 单个插件的加载结果，由加载线程填写，登记阶段按文件名顺序处理
+struct CPluginLoadSlot {
+    void *hLib;
+    IPrintPlugin *pPlugin;
+    string strError; // 加载失败的原因；错误信息在登记阶段按顺序输出，避免多个线程的输出交错
+    double dDlopenMs;
+    double dDlsymMs;
+    double dCreateMs;
+};
+
+static double MillisSince(chrono::steady_clock::time_point tStart) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - tStart).count();
+}
+
+// 影子副本的序号，保证每个副本路径都不同（动态链接器按路径与 inode 识别同一个库）
+static atomic<unsigned long> g_nShadowSerial(0);
+
+static bool CopyFile(const string &strSrc, const string &strDst) {
+    int fdSrc = open(strSrc.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fdSrc == -1) {
+        return false;
+    }
+    int fdDst = open(strDst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0700);
+    if (fdDst == -1) {
+        close(fdSrc);
+        return false;
+    }
+
+    char buf[65536];
+    ssize_t n;
+    bool bOk = true;
+    while (bOk && (n = read(fdSrc, buf, sizeof(buf))) != 0) {
+        if (n == -1) {
+            bOk = errno == EINTR;
+            continue;
+        }
+        for (ssize_t nDone = 0; bOk && nDone < n;) {
+            ssize_t m = write(fdDst, buf + nDone, (size_t)(n - nDone));
+            if (m == -1) {
+                bOk = errno == EINTR;
+            } else {
+                nDone += m;
+            }
+        }
+    }
+    close(fdSrc);
+    return close(fdDst) == 0 && bOk;
+}
+
+// 加载一个插件：dlopen -> dlsym(CreateObj) -> CreateObj，各阶段分别计时
+// bShadow 时先把插件复制到 PLUGIN_SHADOW_DIRECTORY 再加载，加载后删除副本（已映射的内容不受影响）
+static void LoadPlugin(const string &path, CPluginLoadSlot &slot, bool bShadow) {
+    // 1. 加载动态库
+    auto tStart = chrono::steady_clock::now();
+    if (bShadow) {
+        string strName = path.substr(path.rfind('/') + 1);
+        string strShadow = string(PLUGIN_SHADOW_DIRECTORY) + "/" + strName + "." + to_string(getpid()) + "." + to_string(g_nShadowSerial++) + ".so";
+        if (!CopyFile(path, strShadow)) {
+            slot.strError = "Failed to copy " + path + " to " + strShadow + ": " + strerror(errno);
+            unlink(strShadow.c_str());
+            return;
+        }
+        slot.hLib = dlopen(strShadow.c_str(), RTLD_LAZY);
+        unlink(strShadow.c_str());
+    } else {
+        slot.hLib = dlopen(path.c_str(), RTLD_LAZY);
+    }
+    slot.dDlopenMs = MillisSince(tStart);
+    if (slot.hLib == nullptr) {
+        slot.strError = string("dlopen failed: ") + dlerror();
+        return;
+    }
+
+    // 2. 获取 CreateObj 函数地址
+    tStart = chrono::steady_clock::now();
+    PLUGIN_CREATE CreateProc = (PLUGIN_CREATE)dlsym(slot.hLib, "CreateObj");
+    slot.dDlsymMs = MillisSince(tStart);
+    if (CreateProc == nullptr) {
+        slot.strError = "CreateObj not found in " + path;
+        return;
+    }
+
+    // 3. 创建对象
+    tStart = chrono::steady_clock::now();
+    (CreateProc)(&slot.pPlugin); // 调用插件的工厂函数
+    slot.dCreateMs = MillisSince(tStart);
+}
+
+// 卸载一个插件：先释放插件对象（析构函数在动态库里），再 dlclose
+static void UnloadPlugin(IPrintPlugin *pPlugin, void *hLib) {
+    delete pPlugin;
+    dlclose(hLib);
+}
+
+bool CPluginTable::Add(const CPluginRecord &record) {
+    if (Lookup(record.nID) != nullptr) {
+        cerr << "[Error] Function ID " << record.nID << " is already registered." << endl;
+        return false;
+    }
+
+    if (record.nID >= 0 && record.nID < DENSE_ID_LIMIT) {
+        if ((size_t)record.nID >= m_vDenseIndex.size()) {
+            m_vDenseIndex.resize(record.nID + 1, nullptr);
+        }
+        m_vDenseIndex[record.nID] = record.pPlugin;
+    } else {
+        m_mapSparseIndex[record.nID] = record.pPlugin;
+    }
+    m_vRecords.push_back(record);
+    return true;
+}
+
+IPrintPlugin *CPluginTable::Lookup(int FunctionID) const {
+    if (FunctionID >= 0 && FunctionID < DENSE_ID_LIMIT) {
+        return (size_t)FunctionID < m_vDenseIndex.size() ? m_vDenseIndex[FunctionID] : nullptr;
+    }
+    auto it = m_mapSparseIndex.find(FunctionID);
+    return it != m_mapSparseIndex.end() ? it->second : nullptr;
+}
+
+const vector<CPluginRecord> &CPluginTable::GetRecords() const {
+    return m_vRecords;
+}
+
+CPluginController::CPluginController() : m_pTable(new CPluginTable()), m_nLoadThreads(0), m_loadStats(), m_bHotReload(false), m_nReloads(0) {
 }
 
 CPluginController::~CPluginController() {
     UninitializeController();
+    delete m_pTable.load();
+}
+
+void CPluginController::EnableHotReload() {
+    m_bHotReload = true;
 }
 
 bool CPluginController::InitializeController() {
+    lock_guard<mutex> lock(m_mtxUpdate);
+    auto tStart = chrono::steady_clock::now();
+    m_loadStats = CPluginLoadStats();
+
+    // 热加载：先开始监视再枚举，加载期间发生的变化在加载完成后（拿到 m_mtxUpdate 时）处理，不会遗漏
+    if (m_bHotReload && !m_watcher.IsRunning()) {
+        if (mkdir(PLUGIN_SHADOW_DIRECTORY, 0700) == -1 && errno != EEXIST) {
+            cerr << "[Error] Failed to create " << PLUGIN_SHADOW_DIRECTORY << ": " << strerror(errno) << endl;
+            return false;
+        }
+        m_watcher.Start(PLUGIN_DIRECTORY, [this](const vector<string> &vstrPaths, bool bRescan) { ApplyChanges(vstrPaths, bRescan); });
+    }
+
+    // 热加载时插件目录可以是空的，之后放入的插件由监视线程加载
     vector<string> vstrPluginNames;
     CPluginEnumerator enumerator;
 
-    if (!enumerator.GetPluginNames(vstrPluginNames)) {
+    if (!enumerator.GetPluginNames(vstrPluginNames, m_bHotReload)) {
         return false;
     }
+    m_loadStats.dEnumerateMs = MillisSince(tStart);
+    m_loadStats.nPlugins = vstrPluginNames.size();
+
+    // 1. 线程池并行加载：各线程从原子计数器领取下一个插件，结果写入各自的槽位
+    // glibc 的 dlopen 持有全局锁，映射与重定位本身是串行的，并行的收益来自读盘、插件的静态构造与 CreateObj
+    vector<CPluginLoadSlot> vSlots(vstrPluginNames.size(), CPluginLoadSlot{nullptr, nullptr, string(), 0, 0, 0});
+    atomic<size_t> nNext(0);
+    bool bShadow = m_bHotReload;
+    auto worker = [&vstrPluginNames, &vSlots, &nNext, bShadow]() {
+        for (size_t i = nNext++; i < vSlots.size(); i = nNext++) {
+            LoadPlugin(vstrPluginNames[i], vSlots[i], bShadow);
+        }
+    };
+
+    unsigned nThreads = m_nLoadThreads ? m_nLoadThreads : max(1u, thread::hardware_concurrency());
+    nThreads = (unsigned)min<size_t>(nThreads, vSlots.size());
+    m_loadStats.nThreads = nThreads;
+    vector<thread> vThreads;
+    for (unsigned i = 1; i < nThreads; i++) {
+        vThreads.emplace_back(worker);
+    }
+    worker(); // 当前线程算作其中一个
+    for (auto &t : vThreads) {
+        t.join();
+    }
+
+    // 2. 按文件名顺序登记到新的分派表（在当前表的基础上追加），ID 冲突时保留排在前面的插件
+    auto tRegister = chrono::steady_clock::now();
+    CPluginTable *pTable = new CPluginTable(*m_pTable.load());
+    for (size_t i = 0; i < vSlots.size(); i++) {
+        CPluginLoadSlot &slot = vSlots[i];
+        m_loadStats.dDlopenMs += slot.dDlopenMs;
+        m_loadStats.dDlsymMs += slot.dDlsymMs;
+        m_loadStats.dCreateMs += slot.dCreateMs;
 
-    for (const auto &path : vstrPluginNames) {
-        // 1. 加载动态库
-        void *hinstLib = dlopen(path.c_str(), RTLD_LAZY);
-        if (hinstLib == nullptr) {
-            cerr << "[Error] dlopen failed: " << dlerror() << endl;
+        if (!slot.strError.empty()) {
+            cerr << "[Error] " << slot.strError << endl;
+        }
+        if (slot.hLib == nullptr) {
             continue;
         }
+        // 成功：保存句柄和对象指针；ID 冲突的插件不加载
+        if (slot.pPlugin == nullptr) {
+            dlclose(slot.hLib);
+        } else if (!pTable->Add(CPluginRecord{vstrPluginNames[i], slot.hLib, slot.pPlugin, slot.pPlugin->GetID()})) {
+            cerr << "[Error] Skipped " << vstrPluginNames[i] << endl;
+            UnloadPlugin(slot.pPlugin, slot.hLib);
+        }
+    }
+    Publish(pTable);
+    m_loadStats.dRegisterMs = MillisSince(tRegister);
+    m_loadStats.nLoaded = pTable->GetRecords().size();
+    m_loadStats.dTotalMs = MillisSince(tStart);
+
+    return true;
+}
 
-        // 2. 获取 CreateObj 函数地址
-        PLUGIN_CREATE CreateProc = (PLUGIN_CREATE)dlsym(hinstLib, "CreateObj");
+bool CPluginController::InitializeController(int FunctionID) {
+    auto tStart = chrono::steady_clock::now();
+    m_loadStats = CPluginLoadStats();
 
-        // 3. 创建对象
-        if (CreateProc != nullptr) {
-            IPrintPlugin *pPlugin = nullptr;
-            (CreateProc)(&pPlugin); // 调用插件的工厂函数
+    vector<string> vstrPluginNames;
+    CPluginEnumerator enumerator;
+    CPluginManifest manifest;
 
-            if (pPlugin != nullptr) {
-                // 成功：保存句柄和对象指针
-                m_vhForPlugin.push_back(hinstLib);
-                m_vpPlugin.push_back(pPlugin);
-            } else {
-                dlclose(hinstLib);
-            }
-        } else {
-            cerr << "[Error] CreateObj not found in " << path << endl;
-            dlclose(hinstLib);
+    if (!enumerator.GetPluginNames(vstrPluginNames) || !manifest.Refresh(vstrPluginNames)) {
+        return false;
+    }
+    m_loadStats.dEnumerateMs = MillisSince(tStart);
+    m_loadStats.nPlugins = vstrPluginNames.size();
+
+    const CPluginManifestEntry *pEntry = manifest.Find(FunctionID);
+    if (pEntry == nullptr) {
+        m_loadStats.dTotalMs = MillisSince(tStart);
+        return true; // ProcessRequest 会报告找不到该 ID
+    }
+
+    CPluginLoadSlot slot = {nullptr, nullptr, string(), 0, 0, 0};
+    LoadPlugin(pEntry->strPath, slot, false);
+    m_loadStats.nThreads = 1;
+    m_loadStats.dDlopenMs = slot.dDlopenMs;
+    m_loadStats.dDlsymMs = slot.dDlsymMs;
+    m_loadStats.dCreateMs = slot.dCreateMs;
+
+    // 插件在刷新清单之后又被替换，ID 已经对不上：退回到加载全部插件
+    if (slot.pPlugin == nullptr || slot.pPlugin->GetID() != FunctionID) {
+        if (slot.hLib != nullptr) {
+            UnloadPlugin(slot.pPlugin, slot.hLib);
         }
+        return InitializeController();
     }
 
+    auto tRegister = chrono::steady_clock::now();
+    if (!RegisterPlugin(slot.pPlugin, slot.hLib)) {
+        UnloadPlugin(slot.pPlugin, slot.hLib);
+    }
+    m_loadStats.dRegisterMs = MillisSince(tRegister);
+    m_loadStats.nLoaded = m_pTable.load()->GetRecords().size();
+    m_loadStats.dTotalMs = MillisSince(tStart);
     return true;
 }
 
-bool CPluginController::ProcessRequest(int FunctionID) {
-    bool bFound = false;
-    // 遍历对象列表
-    for (auto *plugin : m_vpPlugin) {
-        if (plugin->GetID() == FunctionID) {
-            plugin->Print(); // 多态调用
-            bFound = true;
-            break;
+bool CPluginController::RegisterPlugin(IPrintPlugin *pPlugin, void *hLib) {
+    if (pPlugin == nullptr) {
+        return false;
+    }
+
+    lock_guard<mutex> lock(m_mtxUpdate);
+    CPluginTable *pTable = new CPluginTable(*m_pTable.load());
+    if (!pTable->Add(CPluginRecord{string(), hLib, pPlugin, pPlugin->GetID()})) {
+        delete pTable;
+        return false;
+    }
+    Publish(pTable);
+    return true;
+}
+
+IPrintPlugin *CPluginController::Lookup(int FunctionID) const {
+    return m_pTable.load()->Lookup(FunctionID);
+}
+
+void CPluginController::Publish(CPluginTable *pTable) {
+    CPluginTable *pOld = m_pTable.exchange(pTable);
+
+    // 旧表中不再出现在新表里的插件（被替换、删除或在 ID 冲突中落选），随旧表一起等读者离开后释放对象并卸载动态库
+    unordered_set<void *> setInUse;
+    for (const auto &record : pTable->GetRecords()) {
+        setInUse.insert(record.hLib);
+    }
+    vector<CPluginRecord> vUnused;
+    for (const auto &record : pOld->GetRecords()) {
+        if (record.hLib != nullptr && setInUse.count(record.hLib) == 0) {
+            vUnused.push_back(record);
+        }
+    }
+
+    m_reclaimer.Retire([pOld, vUnused]() {
+        for (const auto &record : vUnused) {
+            UnloadPlugin(record.pPlugin, record.hLib);
+        }
+        delete pOld;
+    });
+    m_reclaimer.Reclaim();
+}
+
+void CPluginController::ApplyChanges(const vector<string> &vstrPathsChanged, bool bRescan) {
+    lock_guard<mutex> lock(m_mtxUpdate);
+
+    // 0. 事件丢失时不知道哪些插件变了：已登记的（可能已删除）与目录中现有的（可能新增或替换）全部重新处理
+    vector<string> vstrPaths = vstrPathsChanged;
+    if (bRescan) {
+        vector<string> vstrPresent;
+        CPluginEnumerator enumerator;
+        enumerator.GetPluginNames(vstrPresent, true);
+        vstrPaths.insert(vstrPaths.end(), vstrPresent.begin(), vstrPresent.end());
+        for (const auto &record : m_pTable.load()->GetRecords()) {
+            if (!record.strPath.empty()) {
+                vstrPaths.push_back(record.strPath);
+            }
         }
+        sort(vstrPaths.begin(), vstrPaths.end());
+        vstrPaths.erase(unique(vstrPaths.begin(), vstrPaths.end()), vstrPaths.end());
     }
 
-    if (!bFound) {
+    if (!vstrPaths.empty()) {
+        // 1. 未变化的插件原样保留
+        const CPluginTable *pOld = m_pTable.load();
+        set<string> setChanged(vstrPaths.begin(), vstrPaths.end());
+        vector<CPluginRecord> vRecords;
+        for (const auto &record : pOld->GetRecords()) {
+            if (setChanged.count(record.strPath) == 0) {
+                vRecords.push_back(record);
+            }
+        }
+
+        // 2. 变化的插件：文件还在就（重新）加载，否则卸载
+        unordered_set<void *> setFresh;
+        for (const auto &path : vstrPaths) {
+            struct stat st;
+            if (stat(path.c_str(), &st) == -1 || !S_ISREG(st.st_mode)) {
+                cerr << "[Reload] Removed " << path << endl;
+                continue;
+            }
+
+            CPluginLoadSlot slot = {nullptr, nullptr, string(), 0, 0, 0};
+            LoadPlugin(path, slot, true);
+            if (!slot.strError.empty()) {
+                cerr << "[Error] " << slot.strError << endl;
+            }
+            if (slot.pPlugin == nullptr) {
+                if (slot.hLib != nullptr) {
+                    dlclose(slot.hLib);
+                }
+                continue;
+            }
+            vRecords.push_back(CPluginRecord{path, slot.hLib, slot.pPlugin, slot.pPlugin->GetID()});
+            setFresh.insert(slot.hLib);
+        }
+
+        // 3. 与 InitializeController 一样按文件名顺序建表，ID 冲突时保留排在前面的插件
+        stable_sort(vRecords.begin(), vRecords.end(), [](const CPluginRecord &a, const CPluginRecord &b) { return a.strPath < b.strPath; });
+        CPluginTable *pTable = new CPluginTable();
+        for (const auto &record : vRecords) {
+            if (pTable->Add(record)) {
+                if (setFresh.count(record.hLib)) {
+                    cerr << "[Reload] Loaded " << record.strPath << " (Function ID " << record.nID << ")" << endl;
+                }
+            } else {
+                cerr << "[Error] Skipped " << record.strPath << endl;
+                if (setFresh.count(record.hLib)) {
+                    UnloadPlugin(record.pPlugin, record.hLib); // 新加载的插件还没有发布，可以直接卸载
+                }
+            }
+        }
+        Publish(pTable);
+        m_nReloads += vstrPaths.size();
+    }
+
+    // 回收已经没有读者的旧分派表与动态库
+    m_reclaimer.Reclaim();
+}
+
+void CPluginController::SetLoadThreads(unsigned nThreads) {
+    m_nLoadThreads = nThreads;
+}
+
+const CPluginLoadStats &CPluginController::GetLoadStats() const {
+    return m_loadStats;
+}
+
+void CPluginController::PrintLoadStats(ostream &os) const {
+    const CPluginLoadStats &st = m_loadStats;
+    os << "[Startup] plugins loaded     : " << st.nLoaded << " / " << st.nPlugins << " (" << st.nThreads << " threads)" << endl;
+    os << "[Startup] enumerate          : " << st.dEnumerateMs << " ms" << endl;
+    os << "[Startup] dlopen   (sum)     : " << st.dDlopenMs << " ms" << endl;
+    os << "[Startup] dlsym    (sum)     : " << st.dDlsymMs << " ms" << endl;
+    os << "[Startup] create   (sum)     : " << st.dCreateMs << " ms" << endl;
+    os << "[Startup] register           : " << st.dRegisterMs << " ms" << endl;
+    os << "[Startup] total (wall clock) : " << st.dTotalMs << " ms" << endl;
+    if (m_bHotReload) {
+        os << "[Reload] plugin changes      : " << m_nReloads << " (" << m_reclaimer.GetPendingCount() << " old tables awaiting reclaim)" << endl;
+    }
+}
+
+bool CPluginController::ProcessRequest(int FunctionID) {
+    // 进入纪元临界区后读取分派表；查索引，命中后只有一次虚函数调用
+    CEpochGuard guard(m_reclaimer);
+    IPrintPlugin *plugin = m_pTable.load()->Lookup(FunctionID);
+    if (plugin != nullptr) {
+        plugin->Print(); // 多态调用
+    } else {
         cout << "[Warning] Function ID " << FunctionID << " not found." << endl;
     }
     return true;
 }
 
 bool CPluginController::ProcessHelp() {
+    // 常驻宿主（CPluginHost）已经加载过插件，直接使用
+    {
+        CEpochGuard guard(m_reclaimer);
+        const CPluginTable *pTable = m_pTable.load();
+        if (!pTable->GetRecords().empty()) {
+            for (const auto &record : pTable->GetRecords()) {
+                record.pPlugin->Help();
+            }
+            return true;
+        }
+    }
+
     // 注意：根据 main.cpp 的逻辑，调用 Help 时并未调用 InitializeController
-    // 因此这里需要独立完成 加载->调用Help->卸载 的过程
+    // 帮助文本取自插件清单，指纹未变的插件不需要加载
     vector<string> vstrPluginNames;
     CPluginEnumerator enumerator;
+    CPluginManifest manifest;
 
-    if (!enumerator.GetPluginNames(vstrPluginNames)) {
+    if (!enumerator.GetPluginNames(vstrPluginNames) || !manifest.Refresh(vstrPluginNames)) {
         return false;
     }
 
-    for (const auto &path : vstrPluginNames) {
-        void *hinstLib = dlopen(path.c_str(), RTLD_LAZY);
-        if (hinstLib != nullptr) {
-            PLUGIN_CREATE CreateProc = (PLUGIN_CREATE)dlsym(hinstLib, "CreateObj");
-            if (CreateProc != nullptr) {
-                IPrintPlugin *pPlugin = nullptr;
-                (CreateProc)(&pPlugin);
-
-                if (pPlugin != nullptr) {
-                    pPlugin->Help(); // 多态调用 Help
-                }
-            }
-            // 用完即刻销毁
-            dlclose(hinstLib);
+    for (const auto &entry : manifest.GetEntries()) {
+        if (entry.bValid) {
+            cout << entry.strHelp;
         }
     }
+    cout.flush();
     return true;
 }
 
 bool CPluginController::UninitializeController() {
-    // 释放所有动态库句柄
-    for (void *handle : m_vhForPlugin) {
-        if (handle) {
-            dlclose(handle);
-        }
-    }
-    m_vhForPlugin.clear();
-    m_vpPlugin.clear();
+    // 先停止监视线程（它的回调需要 m_mtxUpdate），再换上空表，等所有读者离开后释放全部动态库句柄
+    m_watcher.Stop();
+    lock_guard<mutex> lock(m_mtxUpdate);
+    Publish(new CPluginTable());
+    m_reclaimer.Synchronize();
     return true;
-}
\ No newline at end of file
+}
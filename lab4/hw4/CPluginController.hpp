@@ -1,24 +1,121 @@
 #pragma once
 
+#include "CEpochReclaimer.hpp"
+#include "CPluginWatcher.hpp"
+#include <atomic>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 // 前向声明，减少头文件依赖
 class IPrintPlugin;
 
+// 插件 ID 小于该值时使用数组直接索引，否则放入哈希表
+#define DENSE_ID_LIMIT 4096
+
+// 热加载时插件先复制到这里再 dlopen：原文件可以被就地覆盖（cp）而不影响已映射的代码，
+// 同一路径的新旧版本也不会被动态链接器当作同一个库；dlopen 之后副本随即删除
+#define PLUGIN_SHADOW_DIRECTORY "./plugin/.shadow"
+
+// 启动耗时分解（InitializeController 填写）
+// dlopen / dlsym / create 是各插件耗时之和（多个线程并行时可能大于总耗时），其余为墙钟时间
+struct CPluginLoadStats {
+    size_t nPlugins;     // 枚举到的 .so 个数
+    size_t nLoaded;      // 成功加载并登记的插件数
+    unsigned nThreads;   // 加载线程数
+    double dEnumerateMs; // 枚举插件目录
+    double dDlopenMs;    // dlopen
+    double dDlsymMs;     // dlsym 解析 CreateObj
+    double dCreateMs;    // 调用 CreateObj 创建插件对象
+    double dRegisterMs;  // 按顺序登记索引
+    double dTotalMs;     // InitializeController 总耗时
+};
+
+// 一个已登记的插件
+struct CPluginRecord {
+    std::string strPath;   // 插件文件路径；进程内直接登记的插件为空
+    void *hLib;            // 动态库句柄（可为空），卸载时 dlclose
+    IPrintPlugin *pPlugin; // 插件对象（由插件的 CreateObj 用 new 创建）；hLib 不为空时卸载前 delete
+    int nID;               // 登记时取得的 GetID()
+};
+
+// 分派表：插件列表（按文件名顺序）与 ID -> 插件 的索引
+// 发布给读者之后不再修改；加载、替换、卸载插件时构造一份新表整体换上
+class CPluginTable {
+public:
+    // ID 与表中已有的插件冲突时返回 false，保留先加入的插件
+    bool Add(const CPluginRecord &record);
+
+    // 按 ID 查找插件，O(1)；找不到时返回 nullptr
+    IPrintPlugin *Lookup(int FunctionID) const;
+
+    const std::vector<CPluginRecord> &GetRecords() const;
+
+private:
+    std::vector<CPluginRecord> m_vRecords;
+    std::vector<IPrintPlugin *> m_vDenseIndex;                // 小的非负 ID：直接下标访问
+    std::unordered_map<int, IPrintPlugin *> m_mapSparseIndex; // 负数或过大的 ID
+};
+
 class CPluginController {
 public:
     CPluginController();
     virtual ~CPluginController();
 
+    // 枚举 ./plugin 后在线程池上并行 dlopen、解析符号并创建插件对象，
+    // 之后按插件文件名顺序登记，加载顺序与 ID 冲突时保留哪个插件都与线程调度无关
     bool InitializeController();
+
+    // 一次性请求：按插件清单只加载处理 FunctionID 的那个插件（清单没有该 ID 时不加载任何插件）
+    bool InitializeController(int FunctionID);
     bool UninitializeController();
 
+    // 热加载：在 InitializeController 之前调用。之后插件都从影子副本加载（见 PLUGIN_SHADOW_DIRECTORY），
+    // InitializeController 同时启动目录监视线程，插件目录中新增、替换、删除 .so 时随即加载或卸载，不中断请求处理
+    void EnableHotReload();
+
+    // 已加载插件时直接调用各插件的 Help；否则读插件清单，只有新增或改动过的插件才会被临时加载
     bool ProcessHelp();
+
+    // 读路径不加锁：进入纪元临界区后读取当前分派表，查索引并调用一次 Print；
+    // 热加载换下来的旧插件要等所有正在进行的调用结束后才会被 dlclose
     bool ProcessRequest(int FunctionID);
 
+    // 登记一个插件：GetID() 只在这里调用一次，建立 ID -> 插件 的索引
+    // ID 与已登记的插件冲突时返回 false，保留先登记的插件；hLib 为插件所在动态库的句柄（可为空），卸载时 dlclose
+    // hLib 不为空时插件对象归控制器所有，卸载时先 delete 再 dlclose；hLib 为空时对象仍归调用方所有
+    // 每次登记都会复制一份分派表，批量加载请用 InitializeController
+    bool RegisterPlugin(IPrintPlugin *pPlugin, void *hLib);
+
+    // 按 ID 查找插件，O(1)；找不到时返回 nullptr
+    // 返回的指针不受纪元保护，开启热加载时只应在没有插件变化的场合使用（如测试）
+    IPrintPlugin *Lookup(int FunctionID) const;
+
+    // 加载线程数，0 表示 CPU 核数（默认）；1 为串行加载
+    void SetLoadThreads(unsigned nThreads);
+
+    const CPluginLoadStats &GetLoadStats() const;
+    void PrintLoadStats(std::ostream &os) const;
+
+private:
+    // 监视线程的回调：重新加载发生变化的插件；vstrPaths 为空时只回收旧插件
+    // bRescan 时（inotify 事件丢失）重新加载已登记的和目录中现有的全部插件
+    void ApplyChanges(const std::vector<std::string> &vstrPaths, bool bRescan = false);
+
+    // 换上新的分派表，旧表及其中不再使用的动态库登记为待回收；调用方持有 m_mtxUpdate
+    void Publish(CPluginTable *pTable);
+
 private:
-    // 保存动态库句柄，用于释放资源
-    std::vector<void *> m_vhForPlugin;
-    // 保存插件对象指针，用于调用功能
-    std::vector<IPrintPlugin *> m_vpPlugin;
+    std::atomic<CPluginTable *> m_pTable; // 当前分派表，读者无锁读取，始终不为空
+    CEpochReclaimer m_reclaimer;          // 旧分派表与动态库的延迟回收
+    std::mutex m_mtxUpdate;               // 写者（加载、热加载、卸载）之间互斥，读者不使用
+
+    unsigned m_nLoadThreads;
+    CPluginLoadStats m_loadStats;
+
+    bool m_bHotReload;
+    CPluginWatcher m_watcher;
+    std::atomic<unsigned long> m_nReloads; // 热加载处理过的插件变化次数
 };
@@ -1,4 +1,5 @@
 #include "CPluginEnumerator.hpp"
+#include <algorithm>
 #include <cstring> // for strcmp, strrchr
 #include <dirent.h>
 #include <iostream>
@@ -12,11 +13,11 @@ CPluginEnumerator::CPluginEnumerator() {
 CPluginEnumerator::~CPluginEnumerator() {
 }
 
-bool CPluginEnumerator::GetPluginNames(vector<string> &vstrPluginNames) {
+bool CPluginEnumerator::GetPluginNames(vector<string> &vstrPluginNames, bool bAllowEmpty) {
     vstrPluginNames.clear();
 
     // 修改点：根据 PPT 要求，遍历当前目录下的 plugin 子目录
-    const char *pluginDir = "./plugin";
+    const char *pluginDir = PLUGIN_DIRECTORY;
     DIR *dir = opendir(pluginDir);
 
     if (dir == nullptr) {
@@ -48,7 +49,10 @@ bool CPluginEnumerator::GetPluginNames(vector<string> &vstrPluginNames) {
 
     closedir(dir);
 
-    if (vstrPluginNames.empty()) {
+    // readdir 的返回顺序取决于文件系统，排序后加载顺序固定
+    sort(vstrPluginNames.begin(), vstrPluginNames.end());
+
+    if (vstrPluginNames.empty() && !bAllowEmpty) {
         cout << "[Warning] No .so files found in " << pluginDir << endl;
         return false;
     }
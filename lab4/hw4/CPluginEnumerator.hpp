@@ -5,10 +5,15 @@
 
 using namespace std;
 
+// 插件目录（相对于当前目录）
+#define PLUGIN_DIRECTORY "./plugin"
+
 class CPluginEnumerator {
 public:
     CPluginEnumerator();
     virtual ~CPluginEnumerator();
 
-    bool GetPluginNames(vector<string> &vstrPluginNames);
+    // 列出插件目录中的 .so（已排序）；目录打不开时返回 false，
+    // 没有插件时默认也返回 false，bAllowEmpty 为 true 时（如热加载）空目录是合法的
+    bool GetPluginNames(vector<string> &vstrPluginNames, bool bAllowEmpty = false);
 };
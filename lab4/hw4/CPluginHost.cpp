@@ -0,0 +1,392 @@
+#include "CPluginHost.hpp"
+#include "CPluginEnumerator.hpp"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 收到 SIGINT/SIGTERM 后置位，poll 被信号打断时检查
+static volatile sig_atomic_t g_bStopRequested = 0;
+
+static void OnStopSignal(int) {
+    g_bStopRequested = 1;
+}
+
+// 填充套接字地址，路径过长时返回 false
+static bool MakeAddress(const string &strPath, struct sockaddr_un &addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strPath.size() >= sizeof(addr.sun_path)) {
+        cerr << "[Error] Socket path too long: " << strPath << endl;
+        return false;
+    }
+    memcpy(addr.sun_path, strPath.c_str(), strPath.size() + 1);
+    return true;
+}
+
+// 写出全部数据；对端已关闭时不产生 SIGPIPE，直接返回 false
+static bool SendAll(int fd, const string &strData) {
+    const char *p = strData.data();
+    size_t nRemain = strData.size();
+    while (nRemain > 0) {
+        ssize_t n = send(fd, p, nRemain, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        nRemain -= (size_t)n;
+    }
+    return true;
+}
+
+CPluginHost::CPluginHost(const string &strSocketPath)
+    : m_strSocketPath(strSocketPath), m_fdListen(-1), m_dLoadMs(0), m_nRequests(0), m_dTotalLatencyUs(0), m_dMaxLatencyUs(0),
+      m_bShutdown(false) {
+}
+
+CPluginHost::~CPluginHost() {
+    if (m_fdListen != -1) {
+        close(m_fdListen);
+        unlink(m_strSocketPath.c_str());
+    }
+}
+
+bool CPluginHost::Run() {
+    // 1. 预热：只加载一次插件；之后插件目录的变化由热加载处理，不需要重启宿主
+    m_controller.EnableHotReload();
+    auto tStart = chrono::steady_clock::now();
+    if (!m_controller.InitializeController()) {
+        cerr << "[Error] Failed to load plugins." << endl;
+        return false;
+    }
+    m_dLoadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - tStart).count();
+
+    if (!Listen()) {
+        return false;
+    }
+    cout << "[Host] Plugins loaded in " << m_dLoadMs << " ms, listening on " << m_strSocketPath << endl;
+    m_controller.PrintLoadStats(cout);
+    cout << "[Host] Hot reload: watching " << PLUGIN_DIRECTORY << " for added, replaced and removed plugins" << endl;
+
+    // 2. 不带 SA_RESTART，信号会打断阻塞的 poll
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnStopSignal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    // 3. 服务循环：收到 shutdown 后不再接受和读取，等已有的响应写完再退出
+    vector<struct pollfd> vecPoll;
+    while (!g_bStopRequested) {
+        bool bPendingOutput = false;
+        for (const CHostConnection &conn : m_vecConnections) {
+            bPendingOutput = bPendingOutput || !conn.strOutput.empty();
+        }
+        if (m_bShutdown && !bPendingOutput) {
+            break;
+        }
+
+        // 第 0 项是监听套接字，之后与 m_vecConnections 一一对应；超时取最早到期的空闲连接
+        auto tNow = chrono::steady_clock::now();
+        int nTimeoutMs = -1;
+        vecPoll.clear();
+        vecPoll.push_back({m_fdListen, (short)(m_bShutdown ? 0 : POLLIN), 0});
+        for (const CHostConnection &conn : m_vecConnections) {
+            short nEvents = (conn.bClosing || m_bShutdown) ? 0 : POLLIN;
+            if (!conn.strOutput.empty()) {
+                nEvents |= POLLOUT;
+            }
+            vecPoll.push_back({conn.fd, nEvents, 0});
+
+            long nIdleMs = chrono::duration_cast<chrono::milliseconds>(tNow - conn.tLastActive).count();
+            int nRemainMs = nIdleMs >= HOST_IDLE_TIMEOUT_MS ? 0 : (int)(HOST_IDLE_TIMEOUT_MS - nIdleMs);
+            if (nTimeoutMs == -1 || nRemainMs < nTimeoutMs) {
+                nTimeoutMs = nRemainMs;
+            }
+        }
+
+        if (poll(vecPoll.data(), vecPoll.size(), nTimeoutMs) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << "[Error] poll failed: " << strerror(errno) << endl;
+            break;
+        }
+
+        // 新连接追加在末尾，本轮不参与下面的遍历
+        size_t nConnections = m_vecConnections.size();
+        if (vecPoll[0].revents & POLLIN) {
+            AcceptConnections();
+        }
+
+        tNow = chrono::steady_clock::now();
+        for (size_t i = 0; i < nConnections; i++) {
+            CHostConnection &conn = m_vecConnections[i];
+            short nRevents = vecPoll[i + 1].revents;
+            bool bOpen = !(nRevents & (POLLERR | POLLNVAL));
+
+            if (bOpen && (nRevents & (POLLIN | POLLHUP)) && !conn.bClosing && !m_bShutdown) {
+                ReadConnection(conn);
+            }
+            if (bOpen && !conn.strOutput.empty()) {
+                bOpen = FlushConnection(conn);
+            }
+            if (bOpen && conn.bClosing && conn.strOutput.empty()) {
+                bOpen = false;
+            }
+            if (bOpen && chrono::duration_cast<chrono::milliseconds>(tNow - conn.tLastActive).count() >= HOST_IDLE_TIMEOUT_MS) {
+                cerr << "[Host] Closing idle connection" << endl;
+                bOpen = false;
+            }
+            if (!bOpen) {
+                close(conn.fd);
+                conn.fd = -1;
+            }
+        }
+
+        // 移除已关闭的连接
+        size_t nKept = 0;
+        for (size_t i = 0; i < m_vecConnections.size(); i++) {
+            if (m_vecConnections[i].fd != -1) {
+                if (nKept != i) {
+                    m_vecConnections[nKept] = std::move(m_vecConnections[i]);
+                }
+                nKept++;
+            }
+        }
+        m_vecConnections.resize(nKept);
+    }
+
+    for (const CHostConnection &conn : m_vecConnections) {
+        close(conn.fd);
+    }
+    m_vecConnections.clear();
+    close(m_fdListen);
+    m_fdListen = -1;
+    unlink(m_strSocketPath.c_str());
+    PrintStats(cout);
+    return true;
+}
+
+bool CPluginHost::Listen() {
+    struct sockaddr_un addr;
+    if (!MakeAddress(m_strSocketPath, addr)) {
+        return false;
+    }
+
+    m_fdListen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fdListen == -1) {
+        cerr << "[Error] socket failed: " << strerror(errno) << endl;
+        return false;
+    }
+
+    // 清理上次异常退出遗留的套接字文件
+    unlink(m_strSocketPath.c_str());
+    if (bind(m_fdListen, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(m_fdListen, SOMAXCONN) == -1) {
+        cerr << "[Error] Failed to listen on " << m_strSocketPath << ": " << strerror(errno) << endl;
+        close(m_fdListen);
+        m_fdListen = -1;
+        return false;
+    }
+    return true;
+}
+
+void CPluginHost::AcceptConnections() {
+    while (true) {
+        int fd = accept4(m_fdListen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                cerr << "[Error] accept failed: " << strerror(errno) << endl;
+            }
+            return;
+        }
+        CHostConnection conn;
+        conn.fd = fd;
+        conn.tLastActive = chrono::steady_clock::now();
+        conn.bClosing = false;
+        m_vecConnections.push_back(std::move(conn));
+    }
+}
+
+void CPluginHost::ReadConnection(CHostConnection &conn) {
+    char buf[4096];
+    while (!conn.bClosing) {
+        ssize_t n = recv(conn.fd, buf, sizeof(buf), 0);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n <= 0) {
+            // 对端关闭或出错：处理已收到的完整请求后关闭
+            conn.bClosing = true;
+            break;
+        }
+        conn.tLastActive = chrono::steady_clock::now();
+        conn.strInput.append(buf, (size_t)n);
+        ProcessLines(conn);
+    }
+}
+
+void CPluginHost::ProcessLines(CHostConnection &conn) {
+    // 逐行处理已收到的完整请求
+    size_t nPos;
+    while (!m_bShutdown && (nPos = conn.strInput.find('\n')) != string::npos && nPos <= HOST_MAX_REQUEST_LINE) {
+        string strRequest = conn.strInput.substr(0, nPos);
+        conn.strInput.erase(0, nPos + 1);
+        if (!strRequest.empty() && strRequest.back() == '\r') {
+            strRequest.pop_back();
+        }
+
+        string strResponse;
+        HandleRequest(strRequest, strResponse);
+        conn.strOutput += strResponse;
+    }
+
+    // 不完整的请求行也不能无限增长
+    nPos = conn.strInput.find('\n');
+    if ((nPos == string::npos ? conn.strInput.size() : nPos) > HOST_MAX_REQUEST_LINE) {
+        conn.strInput.clear();
+        conn.strOutput += "# ERROR request line longer than " + to_string(HOST_MAX_REQUEST_LINE) + " bytes\n";
+        conn.bClosing = true;
+    }
+}
+
+// 尽量写出积压的响应，对端不读时留到下次可写；出错时返回 false
+bool CPluginHost::FlushConnection(CHostConnection &conn) {
+    while (!conn.strOutput.empty()) {
+        ssize_t n = send(conn.fd, conn.strOutput.data(), conn.strOutput.size(), MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        conn.strOutput.erase(0, (size_t)n);
+        conn.tLastActive = chrono::steady_clock::now();
+    }
+    return true;
+}
+
+void CPluginHost::HandleRequest(const string &strRequest, string &strResponse) {
+    auto tStart = chrono::steady_clock::now();
+
+    // 插件直接写 cout，调用期间把 cout 重定向到缓冲区，输出随响应返回给客户端
+    ostringstream oss;
+    streambuf *pOldBuf = cout.rdbuf(oss.rdbuf());
+    bool bOk = true;
+    if (strRequest == "help") {
+        m_controller.ProcessHelp();
+    } else if (strRequest == "stats") {
+        PrintStats(oss);
+    } else if (strRequest == "shutdown") {
+        m_bShutdown = true;
+        oss << "[Host] Shutting down." << endl;
+    } else {
+        char *pEnd = nullptr;
+        long nID = strtol(strRequest.c_str(), &pEnd, 10);
+        if (strRequest.empty() || *pEnd != '\0') {
+            oss << "[Error] Invalid request: " << strRequest << endl;
+            bOk = false;
+        } else {
+            m_controller.ProcessRequest((int)nID);
+        }
+    }
+    cout.rdbuf(pOldBuf);
+
+    double dLatencyUs = chrono::duration<double, micro>(chrono::steady_clock::now() - tStart).count();
+    m_nRequests++;
+    m_dTotalLatencyUs += dLatencyUs;
+    if (dLatencyUs > m_dMaxLatencyUs) {
+        m_dMaxLatencyUs = dLatencyUs;
+    }
+
+    // 状态行：本次延迟、累计请求数、一次预热加载分摊到每个请求的开销
+    ostringstream status;
+    status << "# " << (bOk ? "OK" : "ERROR") << " latency_us=" << dLatencyUs << " served=" << m_nRequests
+           << " amortized_load_us=" << m_dLoadMs * 1000 / m_nRequests << "\n";
+    strResponse = oss.str() + status.str();
+}
+
+void CPluginHost::PrintStats(ostream &os) const {
+    m_controller.PrintLoadStats(os);
+    os << "[Host] requests served     : " << m_nRequests << endl;
+    os << "[Host] warm load (once)    : " << m_dLoadMs << " ms" << endl;
+    if (m_nRequests > 0) {
+        os << "[Host] load amortized/req  : " << m_dLoadMs * 1000 / m_nRequests << " us (" << m_nRequests
+           << " requests share one load)" << endl;
+        os << "[Host] latency avg / max   : " << m_dTotalLatencyUs / m_nRequests << " / " << m_dMaxLatencyUs << " us" << endl;
+    }
+}
+
+bool CPluginHost::Call(const string &strSocketPath, const string &strRequest, string &strResponse) {
+    strResponse.clear();
+    struct sockaddr_un addr;
+    if (!MakeAddress(strSocketPath, addr)) {
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return false;
+    }
+    // 宿主无响应时不无限等待
+    struct timeval tv;
+    tv.tv_sec = HOST_IDLE_TIMEOUT_MS / 1000;
+    tv.tv_usec = (HOST_IDLE_TIMEOUT_MS % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        cerr << "[Error] Failed to connect to " << strSocketPath << ": " << strerror(errno) << endl;
+        cerr << "Hint: Start the host with './main serve' first." << endl;
+        close(fd);
+        return false;
+    }
+
+    if (!SendAll(fd, strRequest + "\n")) {
+        close(fd);
+        return false;
+    }
+
+    // 读到以 "# " 开头的状态行为止
+    char buf[4096];
+    size_t nStatus = string::npos;
+    while (true) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        strResponse.append(buf, (size_t)n);
+        nStatus = strResponse.compare(0, 2, "# ") == 0 ? 0 : strResponse.rfind("\n# ");
+        if (nStatus != string::npos && strResponse.back() == '\n') {
+            break;
+        }
+    }
+    close(fd);
+
+    if (nStatus == string::npos) {
+        return false;
+    }
+    size_t nStart = nStatus == 0 ? 0 : nStatus + 1;
+    return strResponse.compare(nStart, 4, "# OK") == 0;
+}
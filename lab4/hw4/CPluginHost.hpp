@@ -0,0 +1,72 @@
+#pragma once
+
+#include "CPluginController.hpp"
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// 默认的宿主套接字路径（相对于当前目录，与 ./plugin 放在一起）
+#define DEFAULT_HOST_SOCKET "./plugin_host.sock"
+
+// 连接空闲超过该时间（毫秒）即被关闭，客户端等待响应的时间也以此为上限
+#define HOST_IDLE_TIMEOUT_MS 10000
+
+// 单个请求行的最大长度（不含换行），超过时返回错误并关闭连接
+#define HOST_MAX_REQUEST_LINE 4096
+
+// 常驻插件宿主：启动时只加载一次插件，之后通过 Unix 域套接字接收请求，
+// 省去每个请求都要 枚举目录 -> dlopen -> InitializeController 的开销
+//
+// 协议：每个请求是一行文本
+//   help      列出插件
+//   <ID>      执行指定 ID 的插件
+//   stats     宿主统计：启动耗时分解、请求数、预热加载耗时、每个请求分摊的加载开销、延迟
+//   shutdown  停止宿主
+// 响应是插件的输出（宿主在调用期间把 cout 重定向到缓冲区），最后一行以 "# " 开头，
+// 给出状态与本次请求的处理耗时，例如 "# OK latency_us=3.1 served=42 amortized_load_us=25.7"
+// 单线程用 poll 同时服务多个连接，同一连接上可以连续发送多个请求；
+// 空闲超过 HOST_IDLE_TIMEOUT_MS 的连接被关闭，请求行超过 HOST_MAX_REQUEST_LINE 时返回错误并关闭
+// 宿主开启热加载：向插件目录放入、覆盖或删除 .so 后无需重启，后续请求即使用新的插件集合
+// （热加载的日志写到 cerr，cout 在处理请求期间会被重定向）
+class CPluginHost {
+public:
+    CPluginHost(const std::string &strSocketPath);
+    virtual ~CPluginHost();
+
+    // 加载插件并进入服务循环，直到收到 shutdown 请求或 SIGINT/SIGTERM
+    bool Run();
+
+    // 客户端：发送一个请求，把完整响应（含状态行）写入 strResponse；状态为 OK 时返回 true
+    static bool Call(const std::string &strSocketPath, const std::string &strRequest, std::string &strResponse);
+
+private:
+    // 一个客户端连接：未处理完的输入与尚未写出的响应
+    struct CHostConnection {
+        int fd;
+        std::string strInput;
+        std::string strOutput;
+        std::chrono::steady_clock::time_point tLastActive;
+        bool bClosing; // 对端已关闭或请求出错：写完剩余响应后关闭
+    };
+
+    bool Listen();
+    void AcceptConnections();
+    void ReadConnection(CHostConnection &conn);
+    void ProcessLines(CHostConnection &conn);
+    bool FlushConnection(CHostConnection &conn);
+    void HandleRequest(const std::string &strRequest, std::string &strResponse);
+    void PrintStats(std::ostream &os) const;
+
+private:
+    std::string m_strSocketPath;
+    int m_fdListen;
+    std::vector<CHostConnection> m_vecConnections;
+    CPluginController m_controller;
+
+    double m_dLoadMs;          // 预热加载（InitializeController）耗时
+    unsigned long m_nRequests; // 已处理的请求数
+    double m_dTotalLatencyUs;
+    double m_dMaxLatencyUs;
+    bool m_bShutdown;
+};
@@ -0,0 +1,239 @@
+#include "CPluginManifest.hpp"
+#include "IPrintPlugin.hpp"
+#include <cstdio>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+using namespace std;
+
+typedef void (*PLUGIN_CREATE)(IPrintPlugin **);
+
+// 清单文件首行，格式变化时修改版本号，旧的缓存会被整体丢弃
+static const char *MANIFEST_HEADER = "# plugin manifest v1";
+
+// 帮助文本可能含有换行与制表符，转义后一个条目占一行
+static string Escape(const string &str) {
+    string strOut;
+    for (char c : str) {
+        if (c == '\\') {
+            strOut += "\\\\";
+        } else if (c == '\n') {
+            strOut += "\\n";
+        } else if (c == '\t') {
+            strOut += "\\t";
+        } else {
+            strOut += c;
+        }
+    }
+    return strOut;
+}
+
+static string Unescape(const string &str) {
+    string strOut;
+    for (size_t i = 0; i < str.size(); i++) {
+        if (str[i] == '\\' && i + 1 < str.size()) {
+            i++;
+            strOut += str[i] == 'n' ? '\n' : (str[i] == 't' ? '\t' : str[i]);
+        } else {
+            strOut += str[i];
+        }
+    }
+    return strOut;
+}
+
+// 读取文件指纹中的 mtime/inode/size
+static bool StatFile(const string &path, CPluginManifestEntry &entry) {
+    struct stat st;
+    if (stat(path.c_str(), &st) == -1) {
+        return false;
+    }
+    entry.nMtimeNs = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    entry.nInode = (uint64_t)st.st_ino;
+    entry.nSize = (uint64_t)st.st_size;
+    return true;
+}
+
+// 文件内容的 FNV-1a 哈希
+static bool HashFile(const string &path, uint64_t &nHash) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    nHash = 14695981039346656037ull;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            nHash = (nHash ^ (uint8_t)buf[i]) * 1099511628211ull;
+        }
+    }
+    close(fd);
+    return n == 0;
+}
+
+// 探测插件：临时加载，取 ID 并捕获 Help() 写到 cout 的文本，然后卸载
+static void Probe(CPluginManifestEntry &entry) {
+    entry.bValid = false;
+    entry.nID = 0;
+    entry.strHelp.clear();
+
+    void *hinstLib = dlopen(entry.strPath.c_str(), RTLD_LAZY);
+    if (hinstLib == nullptr) {
+        cerr << "[Error] dlopen failed: " << dlerror() << endl;
+        return;
+    }
+
+    PLUGIN_CREATE CreateProc = (PLUGIN_CREATE)dlsym(hinstLib, "CreateObj");
+    if (CreateProc != nullptr) {
+        IPrintPlugin *pPlugin = nullptr;
+        (CreateProc)(&pPlugin);
+
+        if (pPlugin != nullptr) {
+            ostringstream oss;
+            streambuf *pOldBuf = cout.rdbuf(oss.rdbuf());
+            pPlugin->Help();
+            cout.rdbuf(pOldBuf);
+
+            entry.nID = pPlugin->GetID();
+            entry.strHelp = oss.str();
+            entry.bValid = true;
+            delete pPlugin; // 析构函数在动态库里，必须在 dlclose 之前释放
+        }
+    } else {
+        cerr << "[Error] CreateObj not found in " << entry.strPath << endl;
+    }
+    dlclose(hinstLib);
+}
+
+CPluginManifest::CPluginManifest() : m_nProbed(0) {
+}
+
+CPluginManifest::~CPluginManifest() {
+}
+
+bool CPluginManifest::Refresh(const vector<string> &vstrPluginNames) {
+    Load();
+    unordered_map<string, size_t> mapCached;
+    for (size_t i = 0; i < m_vEntries.size(); i++) {
+        mapCached[m_vEntries[i].strPath] = i;
+    }
+
+    bool bChanged = vstrPluginNames.size() != m_vEntries.size();
+    m_nProbed = 0;
+    vector<CPluginManifestEntry> vEntries;
+    for (const auto &path : vstrPluginNames) {
+        CPluginManifestEntry entry = CPluginManifestEntry();
+        entry.strPath = path;
+        if (!StatFile(path, entry)) {
+            bChanged = true;
+            continue; // 枚举之后被删除
+        }
+
+        auto it = mapCached.find(path);
+        const CPluginManifestEntry *pCached = it != mapCached.end() ? &m_vEntries[it->second] : nullptr;
+
+        // 1. 指纹未变：直接复用，不读文件
+        if (pCached && pCached->nMtimeNs == entry.nMtimeNs && pCached->nInode == entry.nInode && pCached->nSize == entry.nSize) {
+            vEntries.push_back(*pCached);
+            continue;
+        }
+
+        // 2. 指纹变了但内容相同（如 touch、原样重新拷贝）：只更新指纹
+        bChanged = true;
+        if (!HashFile(path, entry.nHash)) {
+            continue;
+        }
+        if (pCached && pCached->nHash == entry.nHash) {
+            entry.bValid = pCached->bValid;
+            entry.nID = pCached->nID;
+            entry.strHelp = pCached->strHelp;
+        } else {
+            // 3. 新增或改动过的插件：重新探测
+            Probe(entry);
+            m_nProbed++;
+        }
+        vEntries.push_back(entry);
+    }
+
+    m_vEntries.swap(vEntries);
+    if (bChanged) {
+        Save();
+    }
+    return true;
+}
+
+const vector<CPluginManifestEntry> &CPluginManifest::GetEntries() const {
+    return m_vEntries;
+}
+
+const CPluginManifestEntry *CPluginManifest::Find(int FunctionID) const {
+    for (const auto &entry : m_vEntries) {
+        if (entry.bValid && entry.nID == FunctionID) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+size_t CPluginManifest::GetProbedCount() const {
+    return m_nProbed;
+}
+
+bool CPluginManifest::Load() {
+    m_vEntries.clear();
+    ifstream ifs(PLUGIN_MANIFEST_FILE);
+    string strLine;
+    if (!ifs || !getline(ifs, strLine) || strLine != MANIFEST_HEADER) {
+        return false;
+    }
+
+    // 每行：路径 mtime inode size hash valid id help，以制表符分隔
+    while (getline(ifs, strLine)) {
+        istringstream iss(strLine);
+        CPluginManifestEntry entry = CPluginManifestEntry();
+        string strHelp;
+        int nValid = 0;
+        if (!getline(iss, entry.strPath, '\t') ||
+            !(iss >> entry.nMtimeNs >> entry.nInode >> entry.nSize >> hex >> entry.nHash >> dec >> nValid >> entry.nID) ||
+            iss.get() != '\t') {
+            // 缓存损坏：丢弃全部条目，之后整体重新探测
+            m_vEntries.clear();
+            return false;
+        }
+        getline(iss, strHelp);
+        entry.bValid = nValid != 0;
+        entry.strHelp = Unescape(strHelp);
+        m_vEntries.push_back(entry);
+    }
+    return true;
+}
+
+bool CPluginManifest::Save() const {
+    string strTemp = string(PLUGIN_MANIFEST_FILE) + ".tmp." + to_string(getpid());
+    {
+        ofstream ofs(strTemp, ios::trunc);
+        if (!ofs) {
+            return false;
+        }
+        ofs << MANIFEST_HEADER << '\n';
+        for (const auto &entry : m_vEntries) {
+            ofs << entry.strPath << '\t' << entry.nMtimeNs << ' ' << entry.nInode << ' ' << entry.nSize << ' ' << hex << entry.nHash << dec
+                << ' ' << (entry.bValid ? 1 : 0) << ' ' << entry.nID << '\t' << Escape(entry.strHelp) << '\n';
+        }
+        if (!ofs.flush()) {
+            unlink(strTemp.c_str());
+            return false;
+        }
+    }
+    if (rename(strTemp.c_str(), PLUGIN_MANIFEST_FILE) == -1) {
+        unlink(strTemp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 插件清单缓存文件，与插件放在同一目录（不以 .so 结尾，不会被当作插件枚举）
+#define PLUGIN_MANIFEST_FILE "./plugin/.manifest"
+
+// 清单中的一个插件：文件指纹 + 探测得到的元数据
+struct CPluginManifestEntry {
+    std::string strPath; // 插件路径，如 ./plugin/libfunc1.so
+    int64_t nMtimeNs;    // 修改时间（纳秒）
+    uint64_t nInode;
+    uint64_t nSize;
+    uint64_t nHash;      // 文件内容的 FNV-1a 哈希，只在 mtime/inode/size 变化时重新计算
+    bool bValid;         // 是否导出 CreateObj 并成功创建了对象；无效的插件也记录下来，避免每次重新探测
+    int nID;
+    std::string strHelp; // Help() 输出到 cout 的完整文本
+};
+
+// 插件清单：把每个插件的 ID 与帮助文本连同文件指纹一起保存到 PLUGIN_MANIFEST_FILE，
+// help 与按 ID 路由直接读清单，不必 dlopen 全部插件；只有新增或改动过的 .so 才重新探测（dlopen -> CreateObj -> Help/GetID -> dlclose）
+class CPluginManifest {
+public:
+    CPluginManifest();
+    virtual ~CPluginManifest();
+
+    // 按当前的插件列表（已排序）更新清单：指纹未变的条目直接复用，其余重新探测；
+    // 已删除的插件从清单移除。有变化时写回缓存文件（先写临时文件再 rename，并发的进程读到的总是完整的清单）
+    bool Refresh(const std::vector<std::string> &vstrPluginNames);
+
+    // 与插件列表顺序一致
+    const std::vector<CPluginManifestEntry> &GetEntries() const;
+
+    // 处理该 ID 的插件（ID 冲突时与 InitializeController 一致，取排在前面的），找不到时返回 nullptr
+    const CPluginManifestEntry *Find(int FunctionID) const;
+
+    // 最近一次 Refresh 重新探测的插件数
+    size_t GetProbedCount() const;
+
+private:
+    bool Load();
+    bool Save() const;
+
+private:
+    std::vector<CPluginManifestEntry> m_vEntries;
+    size_t m_nProbed;
+};
@@ -0,0 +1,135 @@
+#include "CPluginWatcher.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 关心的事件：写入完成（cp、编译器输出）、移入（mv 原子安装）、删除、移出
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)
+
+CPluginWatcher::CPluginWatcher() : m_fdInotify(-1), m_fdWake{-1, -1} {
+}
+
+CPluginWatcher::~CPluginWatcher() {
+    Stop();
+}
+
+bool CPluginWatcher::Start(const string &strDir, CHANGE_HANDLER handler) {
+    Stop();
+    m_strDir = strDir;
+    m_handler = handler;
+
+    m_fdInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fdInotify == -1) {
+        cerr << "[Error] inotify_init1 failed: " << strerror(errno) << endl;
+        return false;
+    }
+    if (inotify_add_watch(m_fdInotify, strDir.c_str(), WATCH_EVENTS) == -1 || pipe2(m_fdWake, O_CLOEXEC) == -1) {
+        cerr << "[Error] Failed to watch " << strDir << ": " << strerror(errno) << endl;
+        close(m_fdInotify);
+        m_fdInotify = -1;
+        return false;
+    }
+
+    m_thread = thread(&CPluginWatcher::Run, this);
+    return true;
+}
+
+void CPluginWatcher::Stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+    char c = 0;
+    while (write(m_fdWake[1], &c, 1) == -1 && errno == EINTR) {
+    }
+    m_thread.join();
+
+    close(m_fdInotify);
+    close(m_fdWake[0]);
+    close(m_fdWake[1]);
+    m_fdInotify = -1;
+    m_fdWake[0] = m_fdWake[1] = -1;
+}
+
+bool CPluginWatcher::IsRunning() const {
+    return m_thread.joinable();
+}
+
+void CPluginWatcher::Run() {
+    struct pollfd fds[2];
+    fds[0].fd = m_fdInotify;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_fdWake[0];
+    fds[1].events = POLLIN;
+
+    vector<string> vstrChanged;
+    bool bOverflow = false;
+    while (true) {
+        // 有尚未交出的变化时只等一小段时间，合并紧接着到来的事件
+        int nTimeout = (vstrChanged.empty() && !bOverflow) ? WATCH_IDLE_MS : WATCH_SETTLE_MS;
+        int n = poll(fds, 2, nTimeout);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << "[Error] poll failed: " << strerror(errno) << endl;
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+        if (n > 0 && (fds[0].revents & POLLIN)) {
+            if (!ReadEvents(vstrChanged, bOverflow)) {
+                return;
+            }
+            continue;
+        }
+
+        // 超时：交出这一批变化（没有变化时为空列表）
+        sort(vstrChanged.begin(), vstrChanged.end());
+        vstrChanged.erase(unique(vstrChanged.begin(), vstrChanged.end()), vstrChanged.end());
+        m_handler(vstrChanged, bOverflow);
+        vstrChanged.clear();
+        bOverflow = false;
+    }
+}
+
+bool CPluginWatcher::ReadEvents(vector<string> &vstrChanged, bool &bOverflow) {
+    alignas(struct inotify_event) char buf[4096];
+    while (true) {
+        ssize_t n = read(m_fdInotify, buf, sizeof(buf));
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN;
+        }
+
+        for (char *p = buf; p < buf + n;) {
+            const struct inotify_event *pEvent = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + pEvent->len;
+
+            if (pEvent->mask & IN_Q_OVERFLOW) {
+                // 丢失的事件无从补回，交给调用方重新扫描整个目录
+                cerr << "[Warning] inotify queue overflow, rescanning " << m_strDir << endl;
+                bOverflow = true;
+                continue;
+            }
+            // 只处理 .so 文件，忽略清单、临时文件与子目录
+            if (pEvent->len == 0 || (pEvent->mask & IN_ISDIR)) {
+                continue;
+            }
+            const char *dot = strrchr(pEvent->name, '.');
+            if (!dot || strcmp(dot, ".so") != 0) {
+                continue;
+            }
+            vstrChanged.push_back(m_strDir + "/" + pEvent->name);
+        }
+    }
+}
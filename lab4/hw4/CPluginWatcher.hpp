@@ -0,0 +1,44 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 插件目录监视器：后台线程用 inotify 监视目录中 .so 文件的写入完成、移入、删除与移出，
+// 把一批发生变化的插件路径（已排序、去重）交给回调；空闲时每隔 WATCH_IDLE_MS 以空列表调用一次回调，
+// 供调用方回收已替换下来的旧插件。inotify 队列溢出时事件已丢失，回调的 bRescan 为 true，调用方应重新扫描整个目录
+class CPluginWatcher {
+public:
+    typedef std::function<void(const std::vector<std::string> &vstrPaths, bool bRescan)> CHANGE_HANDLER;
+
+    enum {
+        WATCH_IDLE_MS = 100, // 空闲时回调的间隔
+        WATCH_SETTLE_MS = 20 // 收到事件后再等这么久，把紧接着的事件（如先删除再移入）合并为一批
+    };
+
+    CPluginWatcher();
+    virtual ~CPluginWatcher();
+
+    CPluginWatcher(const CPluginWatcher &) = delete;
+    CPluginWatcher &operator=(const CPluginWatcher &) = delete;
+
+    // 开始监视 strDir，回调在监视线程中执行
+    bool Start(const std::string &strDir, CHANGE_HANDLER handler);
+
+    // 停止并等待监视线程退出；不能在回调中调用
+    void Stop();
+
+    bool IsRunning() const;
+
+private:
+    void Run();
+    bool ReadEvents(std::vector<std::string> &vstrChanged, bool &bOverflow);
+
+private:
+    std::string m_strDir;
+    CHANGE_HANDLER m_handler;
+    int m_fdInotify;
+    int m_fdWake[2]; // Stop 向管道写入一个字节唤醒监视线程
+    std::thread m_thread;
+};
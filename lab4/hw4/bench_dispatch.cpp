@@ -0,0 +1,115 @@
+#include "CPluginController.hpp"
+#include "IPrintPlugin.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// 插件数量增长时，每个请求的分派开销
+// 对比 CPluginController 的 ID 索引与旧版逐个调用 GetID() 比较的线性查找
+// 插件对象直接在进程内创建并登记，不经过 dlopen，只测分派本身
+// 用法: ./hw4-bench-dispatch [请求数，默认 1000000]
+
+static unsigned long g_nPrinted = 0;
+
+// 合成插件：Print 只累加计数，不产生输出
+class CBenchPlugin : public IPrintPlugin {
+public:
+    explicit CBenchPlugin(int nID) : m_nID(nID) {}
+
+    virtual void Print() override {
+        g_nPrinted++;
+    }
+
+    virtual void Help() override {
+        cout << "Function ID " << m_nID << " : Synthetic plugin for benchmark." << endl;
+    }
+
+    virtual int GetID() override {
+        return m_nID;
+    }
+
+private:
+    int m_nID;
+};
+
+static double NanosSince(chrono::steady_clock::time_point tStart) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - tStart).count();
+}
+
+// nPlugins 个插件，bSparse 时 ID 超出数组索引范围（走哈希表）
+static void RunCase(size_t nPlugins, bool bSparse, size_t nRequests) {
+    vector<unique_ptr<CBenchPlugin>> vPlugins;
+    vector<IPrintPlugin *> vLinear;
+    CPluginController pc;
+    for (size_t i = 0; i < nPlugins; i++) {
+        int nID = bSparse ? DENSE_ID_LIMIT + (int)i * 7919 : (int)i;
+        vPlugins.push_back(make_unique<CBenchPlugin>(nID));
+        vLinear.push_back(vPlugins.back().get());
+        pc.RegisterPlugin(vPlugins.back().get(), nullptr);
+    }
+
+    // 请求的 ID 在已加载插件中均匀随机分布
+    vector<int> vRequests;
+    vRequests.reserve(nRequests);
+    unsigned int nSeed = 12345;
+    for (size_t i = 0; i < nRequests; i++) {
+        nSeed = nSeed * 1103515245 + 12345;
+        vRequests.push_back(vLinear[(nSeed >> 8) % nPlugins]->GetID());
+    }
+
+    // 索引分派：ProcessRequest 进入纪元临界区（一次 CAS，供热加载安全回收旧插件），查索引后调用一次 Print
+    g_nPrinted = 0;
+    auto tStart = chrono::steady_clock::now();
+    for (int nID : vRequests) {
+        pc.ProcessRequest(nID);
+    }
+    double dIndexed = NanosSince(tStart) / nRequests;
+    bool bOk = g_nPrinted == nRequests;
+
+    // 旧版线性查找：逐个调用 GetID() 比较，找到后调用 Print
+    g_nPrinted = 0;
+    tStart = chrono::steady_clock::now();
+    for (int nID : vRequests) {
+        for (auto *plugin : vLinear) {
+            if (plugin->GetID() == nID) {
+                plugin->Print();
+                break;
+            }
+        }
+    }
+    double dLinear = NanosSince(tStart) / nRequests;
+    bOk = bOk && g_nPrinted == nRequests;
+
+    printf("%8zu %8s %16.1f ns/req %18.1f ns/req%s\n", nPlugins, bSparse ? "sparse" : "dense", dIndexed, dLinear,
+           bOk ? "" : "  [dispatch miss]");
+}
+
+int main(int argc, char **argv) {
+    size_t nRequests = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    if (nRequests == 0) {
+        nRequests = 1;
+    }
+
+    // ID 冲突检测：第二个同 ID 插件被拒绝，仍由先登记的插件处理请求
+    {
+        CBenchPlugin first(7), second(7);
+        CPluginController pc;
+        bool bFirst = pc.RegisterPlugin(&first, nullptr);
+        bool bSecond = pc.RegisterPlugin(&second, nullptr);
+        cout << "Duplicate ID: first=" << bFirst << " second=" << bSecond
+             << " lookup=" << (pc.Lookup(7) == &first ? "first" : "wrong") << endl;
+    }
+
+    printf("%8s %8s %22s %24s\n", "plugins", "ids", "indexed dispatch", "linear lookup (old)");
+    const size_t pluginCounts[] = {1, 16, 256, 1024, 4096};
+    for (size_t nPlugins : pluginCounts) {
+        RunCase(nPlugins, false, nRequests);
+        RunCase(nPlugins, true, nRequests);
+    }
+    return 0;
+}
@@ -25,9 +25,7 @@ public:
 };
 
 // 2. 导出唯一的创建接口
-// 注意：这里使用了 static 对象，这是一种简单的单例模式实现（符合 PPT 示例）
-// 如果需要动态创建，可以使用 return new CPrintPlugin()，但需要在 Controller 中 delete
+// 对象用 new 创建，归加载方所有：卸载插件时先 delete 对象，再 dlclose 动态库
 extern "C" void CreateObj(IPrintPlugin **ppPlugin) {
-    static CPrintPlugin plugin;
-    *ppPlugin = &plugin;
+    *ppPlugin = new CPrintPlugin();
 }
\ No newline at end of file
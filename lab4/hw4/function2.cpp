@@ -24,6 +24,5 @@ public:
 };
 
 extern "C" void CreateObj(IPrintPlugin **ppPlugin) {
-    static CPrintPlugin plugin;
-    *ppPlugin = &plugin;
+    *ppPlugin = new CPrintPlugin();
 }
\ No newline at end of file
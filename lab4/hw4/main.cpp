@@ -1,4 +1,5 @@
 #include "CPluginController.hpp"
+#include "CPluginHost.hpp"
 #include <cstdlib> // for atoi
 #include <cstring>
 #include <iostream>
@@ -6,11 +7,39 @@
 using namespace std;
 
 int main(int argc, char **argv) {
+    // 模式 3: 常驻宿主，插件只加载一次，通过 Unix 域套接字接收请求
+    if (argc >= 2 && argc <= 3 && strcmp(argv[1], "serve") == 0) {
+        CPluginHost host(argc == 3 ? argv[2] : DEFAULT_HOST_SOCKET);
+        return host.Run() ? 0 : 1;
+    }
+
+    // 模式 4: 把请求发给常驻宿主
+    if (argc >= 3 && argc <= 4 && strcmp(argv[1], "call") == 0) {
+        string strResponse;
+        bool bOk = CPluginHost::Call(argc == 4 ? argv[3] : DEFAULT_HOST_SOCKET, argv[2], strResponse);
+        cout << strResponse;
+        return bOk ? 0 : 1;
+    }
+
+    // 模式 5: 只加载插件，输出启动耗时分解（可指定加载线程数，1 为串行）
+    if (argc >= 2 && argc <= 3 && strcmp(argv[1], "startup") == 0) {
+        CPluginController pc;
+        pc.SetLoadThreads(argc == 3 ? (unsigned)atoi(argv[2]) : 0);
+        if (!pc.InitializeController()) {
+            return 1;
+        }
+        pc.PrintLoadStats(cout);
+        return 0;
+    }
+
     // 参数校验
     if (argc != 2) {
         cout << "Usage:" << endl;
         cout << "  ./main help      : List all plugins" << endl;
         cout << "  ./main <ID>      : Execute plugin with specific ID" << endl;
+        cout << "  ./main serve [socket]            : Run a persistent plugin host" << endl;
+        cout << "  ./main call <request> [socket]   : Send help / <ID> / stats / shutdown to the host" << endl;
+        cout << "  ./main startup [threads]         : Load all plugins and print the startup timing breakdown" << endl;
         return 0;
     }
 
@@ -28,8 +57,8 @@ int main(int argc, char **argv) {
             return 1;
         }
 
-        // 初始化控制器（加载插件）
-        if (pc.InitializeController()) {
+        // 初始化控制器：按插件清单只加载处理该 ID 的插件
+        if (pc.InitializeController(FunctionID)) {
             // 处理请求
             pc.ProcessRequest(FunctionID);
         }